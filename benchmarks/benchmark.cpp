@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "benchmark.h"
+#include "system/file.h"
+#include "utils/arena_allocator.h"
+#include "utils/check.h"
+#include "utils/parallel.h"
+
+namespace gca {
+
+  benchmark_state::benchmark_state(const long p_arg, const size_t p_iterations)
+    : arg(p_arg), iterations(p_iterations), completed(0), items(0),
+      started(false), running(false), cpu_start(0), real_ns(0.0), cpu_ns(0.0) {
+    DBG_ASSERT(iterations > 0);
+  }
+
+  void benchmark_state::start_timer() {
+    DBG_ASSERT(!running);
+    running = true;
+    cpu_start = std::clock();
+    real_start = std::chrono::high_resolution_clock::now();
+  }
+
+  void benchmark_state::stop_timer() {
+    DBG_ASSERT(running);
+    auto real_end = std::chrono::high_resolution_clock::now();
+    std::clock_t cpu_end = std::clock();
+    running = false;
+    real_ns += std::chrono::duration<double, std::nano>(real_end - real_start).count();
+    cpu_ns += 1e9*static_cast<double>(cpu_end - cpu_start) / CLOCKS_PER_SEC;
+  }
+
+  bool benchmark_state::keep_running() {
+    // The first call starts timing without finishing an iteration
+    if (started) {
+      completed++;
+    } else {
+      started = true;
+      start_timer();
+    }
+
+    if (completed < iterations) { return true; }
+
+    // The last iteration may have ended with timing paused
+    if (running) { stop_timer(); }
+    return false;
+  }
+
+  static benchmark_state run_iterations(const benchmark_fn& f,
+					const long arg,
+					const size_t iterations) {
+    // Everything the body allocated goes away with the arena
+    unique_ptr<arena_allocator> a(new arena_allocator());
+    set_system_allocator(a.get());
+
+    benchmark_state state(arg, iterations);
+    f(state);
+
+    set_system_allocator(NULL);
+    return state;
+  }
+
+  benchmark_result run_benchmark(const std::string& name,
+				 const benchmark_fn& f,
+				 const long arg,
+				 const double min_time_s) {
+    const double min_time_ns = 1e9*min_time_s;
+    const size_t max_iterations = 1000000000;
+
+    size_t iterations = 1;
+    benchmark_state state = run_iterations(f, arg, iterations);
+
+    // Same growth rule as Google Benchmark, aim 40% past the minimum
+    // time but never grow more than 10x per attempt
+    while (state.real_time_ns() < min_time_ns && iterations < max_iterations) {
+      double multiplier =
+	state.real_time_ns() <= 0.0 ? 10.0 :
+	std::min(10.0, 1.4*min_time_ns / state.real_time_ns());
+      size_t next = static_cast<size_t>(multiplier*iterations);
+      iterations = std::min(max_iterations, std::max(iterations + 1, next));
+      state = run_iterations(f, arg, iterations);
+    }
+
+    benchmark_result r;
+    r.name = name;
+    r.label = state.label();
+    r.iterations = iterations;
+    r.real_time_ns = state.real_time_ns() / iterations;
+    r.cpu_time_ns = state.cpu_time_ns() / iterations;
+    r.items_per_second =
+      state.items_processed() == 0 ? 0.0 :
+      1e9*state.items_processed() / r.real_time_ns;
+    return r;
+  }
+
+  std::vector<benchmark_result> benchmark_registry::run_all() const {
+    std::vector<benchmark_result> results;
+    for (auto& e : entries) {
+      for (auto arg : e.args) {
+	std::string name =
+	  e.named_args ? e.name + "/" + std::to_string(arg) : e.name;
+	if (name.find(options.filter) == std::string::npos) { continue; }
+
+	benchmark_result r = run_benchmark(name, e.fn, arg, options.min_time_s);
+	std::cerr << std::left << std::setw(56) << r.name
+		  << std::right << std::setw(16) << std::fixed
+		  << std::setprecision(0) << r.real_time_ns << " ns"
+		  << std::setw(12) << r.iterations
+		  << "  " << r.label << std::endl;
+	results.push_back(r);
+      }
+    }
+    return results;
+  }
+
+  std::vector<std::string> corpus_files(const std::string& dir,
+					const std::string& ext) {
+    std::vector<std::string> paths;
+    read_dir(dir, [&paths, &ext](const std::string& path) {
+	if (ends_with(path, ext)) { paths.push_back(path); }
+      });
+    sort(begin(paths), end(paths));
+    return paths;
+  }
+
+  std::string file_name(const std::string& path) {
+    return path.substr(path.find_last_of('/') + 1);
+  }
+
+  static std::string json_string(const std::string& s) {
+    std::string escaped = "\"";
+    for (char c : s) {
+      if (c == '"' || c == '\\') { escaped += '\\'; }
+      escaped += c;
+    }
+    return escaped + "\"";
+  }
+
+  void write_benchmark_json(const std::vector<benchmark_result>& results,
+			    std::ostream& out) {
+    std::time_t now = std::time(NULL);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+
+    out << std::setprecision(17);
+    out << "{" << std::endl;
+    out << "  \"context\": {" << std::endl;
+    out << "    \"date\": " << json_string(date) << "," << std::endl;
+    out << "    \"num_cpus\": " << num_worker_threads() << "," << std::endl;
+#ifdef NDEBUG
+    out << "    \"library_build_type\": \"release\"" << std::endl;
+#else
+    out << "    \"library_build_type\": \"debug\"" << std::endl;
+#endif
+    out << "  }," << std::endl;
+    out << "  \"benchmarks\": [" << std::endl;
+    for (unsigned i = 0; i < results.size(); i++) {
+      const benchmark_result& r = results[i];
+      out << "    {" << std::endl;
+      out << "      \"name\": " << json_string(r.name) << "," << std::endl;
+      out << "      \"iterations\": " << r.iterations << "," << std::endl;
+      out << "      \"real_time\": " << r.real_time_ns << "," << std::endl;
+      out << "      \"cpu_time\": " << r.cpu_time_ns << "," << std::endl;
+      out << "      \"time_unit\": \"ns\"";
+      if (r.items_per_second > 0.0) {
+	out << "," << std::endl << "      \"items_per_second\": " << r.items_per_second;
+      }
+      if (r.label != "") {
+	out << "," << std::endl << "      \"label\": " << json_string(r.label);
+      }
+      out << std::endl << "    }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+  }
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gca {
+
+  // Timing state handed to a benchmark body, which runs the measured
+  // work once per pass of
+  //
+  //   while (state.keep_running()) { ... }
+  //
+  // Setup that should not be timed goes before the loop, or between
+  // pause_timing and resume_timing inside it
+  class benchmark_state {
+  protected:
+    long arg;
+    size_t iterations;
+    size_t completed;
+    size_t items;
+    std::string label_text;
+
+    bool started;
+    bool running;
+    std::chrono::high_resolution_clock::time_point real_start;
+    std::clock_t cpu_start;
+    double real_ns;
+    double cpu_ns;
+
+    void start_timer();
+    void stop_timer();
+
+  public:
+    benchmark_state(const long p_arg, const size_t p_iterations);
+
+    bool keep_running();
+
+    void pause_timing() { stop_timer(); }
+    void resume_timing() { start_timer(); }
+
+    inline long range() const { return arg; }
+    inline size_t max_iterations() const { return iterations; }
+
+    // Work done per iteration, reported as items_per_second
+    void set_items_processed(const size_t n) { items = n; }
+    void set_label(const std::string& l) { label_text = l; }
+
+    inline size_t items_processed() const { return items; }
+    inline const std::string& label() const { return label_text; }
+    inline double real_time_ns() const { return real_ns; }
+    inline double cpu_time_ns() const { return cpu_ns; }
+  };
+
+  typedef std::function<void(benchmark_state&)> benchmark_fn;
+
+  struct benchmark_result {
+    std::string name;
+    std::string label;
+    size_t iterations;
+    double real_time_ns;
+    double cpu_time_ns;
+    double items_per_second;
+  };
+
+  struct benchmark_options {
+    std::string filter;
+    double min_time_s;
+    std::string data_dir;
+
+    benchmark_options() : filter(""), min_time_s(0.5), data_dir("./") {}
+  };
+
+  class benchmark_registry {
+  protected:
+    struct entry {
+      std::string name;
+      benchmark_fn fn;
+      std::vector<long> args;
+      bool named_args;
+    };
+
+    std::vector<entry> entries;
+
+  public:
+    benchmark_options options;
+
+    void add(const std::string& name, benchmark_fn fn) {
+      entries.push_back(entry{name, fn, {0}, false});
+    }
+
+    // One run per arg, named name/arg
+    void add(const std::string& name,
+	     benchmark_fn fn,
+	     const std::vector<long>& args) {
+      entries.push_back(entry{name, fn, args, true});
+    }
+
+    // Paths in the bundled corpora, relative to the repository root
+    std::string data_path(const std::string& relative) const {
+      return options.data_dir + relative;
+    }
+
+    std::vector<benchmark_result> run_all() const;
+  };
+
+  // Runs f until it has taken at least min_time_s, each pass in a
+  // fresh arena so one benchmark's allocations never outlive it
+  benchmark_result run_benchmark(const std::string& name,
+				 const benchmark_fn& f,
+				 const long arg,
+				 const double min_time_s);
+
+  // Results in the JSON layout of Google Benchmark's --benchmark_format=json
+  // so existing comparison scripts can read them
+  void write_benchmark_json(const std::vector<benchmark_result>& results,
+			    std::ostream& out);
+
+  // Files under dir, recursively, whose names end in ext, sorted so
+  // benchmark names are stable between runs
+  std::vector<std::string> corpus_files(const std::string& dir,
+					const std::string& ext);
+
+  std::string file_name(const std::string& path);
+
+  void register_gcode_benchmarks(benchmark_registry& r);
+  void register_geometry_benchmarks(benchmark_registry& r);
+  void register_planning_benchmarks(benchmark_registry& r);
+
+}
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "analysis/gcode_to_cuts.h"
+#include "backend/shapes_to_gcode.h"
+#include "benchmark.h"
+#include "gcode/lexer.h"
+#include "simulators/mill_tool.h"
+#include "simulators/sim_mill.h"
+#include "synthesis/dxf_reader.h"
+#include "synthesis/dxf_streaming.h"
+
+namespace gca {
+
+  // Zig zag of n moves over a 2 x 2 inch block, every tenth move a
+  // half circle arc
+  static std::string synthetic_program(const long n) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+    out << "G90 S3000 M3" << endl;
+    out << "G0 X0 Y0 Z1" << endl;
+    out << "G1 F20 Z0.5" << endl;
+
+    double x = 0.0;
+    double y = 0.0;
+    double step = 2.0 / std::max(n / 2, 1L);
+    for (long i = 0; i < n; i++) {
+      if (i % 10 == 9) {
+	out << "G2 X" << x << " Y" << y + step << " I0 J" << step / 2.0 << endl;
+	y += step;
+      } else if (i % 2 == 0) {
+	x = x == 0.0 ? 2.0 : 0.0;
+	out << "G1 X" << x << " Y" << y << endl;
+      } else {
+	y += step;
+	out << "G1 X" << x << " Y" << y << endl;
+      }
+    }
+
+    out << "G0 Z1" << endl;
+    return out.str();
+  }
+
+  static std::string read_file(const std::string& path) {
+    std::ifstream t(path);
+    return std::string((std::istreambuf_iterator<char>(t)),
+		       std::istreambuf_iterator<char>());
+  }
+
+  static size_t num_cuts(const vector<vector<cut*>>& paths) {
+    size_t n = 0;
+    for (auto& p : paths) { n += p.size(); }
+    return n;
+  }
+
+  static void lex(benchmark_state& state, const std::string& program) {
+    size_t num_blocks = 0;
+    while (state.keep_running()) {
+      num_blocks = lex_gprog(program).size();
+    }
+    state.set_items_processed(num_blocks);
+  }
+
+  static void to_cuts(benchmark_state& state, const std::string& program) {
+    vector<block> p = lex_gprog(program);
+    gcode_to_cuts_result r = GCODE_TO_CUTS_SUCCESS;
+    while (state.keep_running()) {
+      vector<vector<cut*>> paths;
+      r = gcode_to_cuts(p, paths);
+    }
+    state.set_items_processed(p.size());
+    if (r != GCODE_TO_CUTS_SUCCESS) { state.set_label("failed"); }
+  }
+
+  static void simulate(benchmark_state& state, const std::string& program) {
+    vector<vector<cut*>> paths;
+    if (gcode_to_cuts(lex_gprog(program), paths) != GCODE_TO_CUTS_SUCCESS ||
+	paths.size() == 0) {
+      state.set_label("skipped, not convertible to cuts");
+      while (state.keep_running()) {}
+      return;
+    }
+
+    double tool_diameter = 0.25;
+    cylindrical_bit t(tool_diameter);
+    while (state.keep_running()) {
+      state.pause_timing();
+      class region r = set_up_region(paths, tool_diameter);
+      state.resume_timing();
+
+      for (auto& p : paths) { simulate_mill(p, r, t); }
+    }
+    state.set_items_processed(num_cuts(paths));
+  }
+
+  // Drag knife settings of the DXF tests
+  static cut_params dxf_params() {
+    cut_params params;
+    params.default_feedrate = 30;
+    params.set_default_feedrate = true;
+    params.material_depth = 0.09;
+    params.cut_depth = 0.05;
+    params.push_depth = 0.005;
+    params.safe_height = 0.35;
+    params.machine_z_zero = -4.05;
+    params.start_loc = point(0, 0, 0);
+    params.start_orient = point(1, 0, 0);
+    params.target_machine = CAMASTER;
+    params.tools = DRILL_AND_DRAG_KNIFE;
+    return params;
+  }
+
+  void register_gcode_benchmarks(benchmark_registry& r) {
+    std::vector<long> sizes{1000, 10000, 100000};
+
+    r.add("lex_gprog/synthetic", [](benchmark_state& state) {
+	lex(state, synthetic_program(state.range()));
+      }, sizes);
+    r.add("gcode_to_cuts/synthetic", [](benchmark_state& state) {
+	to_cuts(state, synthetic_program(state.range()));
+      }, sizes);
+    r.add("simulate_mill/synthetic", [](benchmark_state& state) {
+	simulate(state, synthetic_program(state.range()));
+      }, {1000, 10000});
+
+    for (auto& path : corpus_files(r.data_path("gcode_samples"), ".NCF")) {
+      std::string name = file_name(path);
+      r.add("lex_gprog/" + name, [path](benchmark_state& state) {
+	  lex(state, read_file(path));
+	});
+      r.add("gcode_to_cuts/" + name, [path](benchmark_state& state) {
+	  to_cuts(state, read_file(path));
+	});
+      r.add("simulate_mill/" + name, [path](benchmark_state& state) {
+	  simulate(state, read_file(path));
+	});
+    }
+
+    for (auto& path : corpus_files(r.data_path("test/dxf-files"), ".DXF")) {
+      std::string name = file_name(path);
+      r.add("dxf_to_gcode/" + name, [path](benchmark_state& state) {
+	  cut_params params = dxf_params();
+	  while (state.keep_running()) {
+	    shape_layout l = read_dxf(path.c_str());
+	    shape_layout_to_gcode_string(l, params);
+	  }
+	});
+      r.add("stream_dxf_to_gcode/" + name, [path](benchmark_state& state) {
+	  cut_params params = dxf_params();
+	  while (state.keep_running()) {
+	    std::ostringstream out;
+	    gcode_writer w(out);
+	    stream_dxf_to_gcode(path.c_str(), params, w);
+	    w.flush();
+	  }
+	});
+    }
+  }
+
+}
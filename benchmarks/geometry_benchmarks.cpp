@@ -0,0 +1,122 @@
+#include <cmath>
+
+#include "benchmark.h"
+#include "geometry/offset.h"
+#include "geometry/polygon_3.h"
+#include "geometry/triangular_mesh.h"
+#include "synthesis/millability.h"
+#include "system/parse_stl.h"
+
+namespace gca {
+
+  // Surface of the unit cube with each face split into an n x n grid,
+  // 12n^2 triangles wound so their normals point out
+  static std::vector<triangle> subdivided_cube(const long n) {
+    struct face { point o, u, v; };
+    std::vector<face> faces{
+      {point(0, 0, 0), point(0, 1, 0), point(1, 0, 0)},
+      {point(0, 0, 1), point(1, 0, 0), point(0, 1, 0)},
+      {point(0, 0, 0), point(1, 0, 0), point(0, 0, 1)},
+      {point(0, 1, 0), point(0, 0, 1), point(1, 0, 0)},
+      {point(0, 0, 0), point(0, 0, 1), point(0, 1, 0)},
+      {point(1, 0, 0), point(0, 1, 0), point(0, 0, 1)}};
+
+    std::vector<triangle> triangles;
+    for (auto& f : faces) {
+      point normal = cross(f.u, f.v);
+      auto grid = [&f, n](const long i, const long j) {
+	return f.o + (static_cast<double>(i) / n)*f.u + (static_cast<double>(j) / n)*f.v;
+      };
+      for (long i = 0; i < n; i++) {
+	for (long j = 0; j < n; j++) {
+	  triangles.push_back(triangle(normal, grid(i, j), grid(i + 1, j), grid(i + 1, j + 1)));
+	  triangles.push_back(triangle(normal, grid(i, j), grid(i + 1, j + 1), grid(i, j + 1)));
+	}
+      }
+    }
+    return triangles;
+  }
+
+  // Star with n points alternating between radius 1 and 0.7, its
+  // straight skeleton has a branch at every vertex
+  static polygon_3 star(const long n) {
+    std::vector<point> pts;
+    for (long i = 0; i < n; i++) {
+      double theta = 2*M_PI*i / n;
+      double r = i % 2 == 0 ? 1.0 : 0.7;
+      pts.push_back(point(r*cos(theta), r*sin(theta), 0));
+    }
+    return build_clean_polygon_3(pts);
+  }
+
+  static std::vector<std::string> stl_parts(const benchmark_registry& r) {
+    std::vector<std::string> parts;
+    for (auto& path : corpus_files(r.data_path("test/stl-files"), ".stl")) {
+      if (path.find("bad_mesh") == std::string::npos) { parts.push_back(path); }
+    }
+    return parts;
+  }
+
+  static void mesh(benchmark_state& state, const std::vector<triangle>& triangles) {
+    while (state.keep_running()) {
+      triangular_mesh m = make_mesh(triangles, 0.001);
+    }
+    state.set_items_processed(triangles.size());
+  }
+
+  void register_geometry_benchmarks(benchmark_registry& r) {
+    r.add("make_mesh/subdivided_cube", [](benchmark_state& state) {
+	mesh(state, subdivided_cube(state.range()));
+      }, {8, 32, 128});
+
+    // Depth fields of a 1 inch cube at 1/arg inch resolution
+    r.add("build_from_stl/subdivided_cube", [](benchmark_state& state) {
+	triangular_mesh m = make_mesh(subdivided_cube(8), 0.001);
+	while (state.keep_running()) {
+	  depth_field df = build_from_stl(m, 1.0 / state.range());
+	}
+	state.set_items_processed(state.range()*state.range());
+      }, {50, 100, 200});
+
+    r.add("exterior_offset/star", [](benchmark_state& state) {
+	std::vector<polygon_3> polys{star(state.range())};
+	while (state.keep_running()) {
+	  exterior_offset(polys, 0.1);
+	}
+	state.set_items_processed(state.range());
+      }, {16, 128, 1024});
+
+    r.add("interior_offset/star", [](benchmark_state& state) {
+	std::vector<polygon_3> polys{star(state.range())};
+	while (state.keep_running()) {
+	  interior_offset(polys, 0.05);
+	}
+	state.set_items_processed(state.range());
+      }, {16, 128, 1024});
+
+    // Ten offsets from one set of skeletons, the pattern of
+    // roughing passes
+    r.add("exterior_offset_rings/star", [](benchmark_state& state) {
+	std::vector<polygon_3> polys{star(state.range())};
+	while (state.keep_running()) {
+	  exterior_offset_rings rings(polys, 1.0);
+	  for (int i = 1; i <= 10; i++) { rings.at(0.1*i); }
+	}
+	state.set_items_processed(state.range());
+      }, {16, 128, 1024});
+
+    for (auto& path : stl_parts(r)) {
+      std::string name = file_name(path);
+      r.add("make_mesh/" + name, [path](benchmark_state& state) {
+	  mesh(state, parse_stl(path).triangles);
+	});
+      r.add("build_from_stl/" + name, [path](benchmark_state& state) {
+	  triangular_mesh m = parse_stl(path, 0.001);
+	  while (state.keep_running()) {
+	    depth_field df = build_from_stl(m, 0.01);
+	  }
+	});
+    }
+  }
+
+}
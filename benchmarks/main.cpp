@@ -0,0 +1,63 @@
+#include <fstream>
+#include <iostream>
+
+#include "benchmark.h"
+
+using namespace gca;
+
+static bool read_flag(const std::string& arg,
+		      const std::string& flag,
+		      std::string& value) {
+  std::string prefix = "--" + flag + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0) { return false; }
+  value = arg.substr(prefix.size());
+  return true;
+}
+
+// Usage: gca-benchmarks [--benchmark_filter=<substring>]
+//                       [--benchmark_min_time=<seconds>]
+//                       [--benchmark_out=<json file>]
+//                       [--data_dir=<repository root>]
+//
+// Progress goes to stderr and the JSON results to the --benchmark_out
+// file, or stdout without one. Anything the benchmarked code prints to
+// stdout is sent to stderr so it never mixes with the JSON. Run from the repository root or pass
+// --data_dir so the bundled corpora can be found
+int main(int argc, char** argv) {
+  benchmark_registry r;
+  std::string out_path;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string value;
+    if (read_flag(arg, "benchmark_filter", value)) {
+      r.options.filter = value;
+    } else if (read_flag(arg, "benchmark_min_time", value)) {
+      r.options.min_time_s = std::stod(value);
+    } else if (read_flag(arg, "benchmark_out", value)) {
+      out_path = value;
+    } else if (read_flag(arg, "data_dir", value)) {
+      r.options.data_dir = value.back() == '/' ? value : value + "/";
+    } else {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  register_gcode_benchmarks(r);
+  register_geometry_benchmarks(r);
+  register_planning_benchmarks(r);
+
+  std::streambuf* stdout_buf = std::cout.rdbuf(std::cerr.rdbuf());
+  std::vector<benchmark_result> results = r.run_all();
+  std::cout.rdbuf(stdout_buf);
+
+  if (out_path == "") {
+    write_benchmark_json(results, std::cout);
+  } else {
+    std::ofstream out(out_path);
+    write_benchmark_json(results, out);
+  }
+
+  return 0;
+}
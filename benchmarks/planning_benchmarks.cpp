@@ -0,0 +1,56 @@
+#include "benchmark.h"
+#include "feature_recognition/feature_decomposition.h"
+#include "synthesis/fabrication_plan.h"
+#include "synthesis/mesh_to_gcode.h"
+#include "system/parse_stl.h"
+
+namespace gca {
+
+  struct planning_part {
+    std::string path;
+    double scale_factor;
+    point n;
+  };
+
+  // Parts and directions from the feature recognition and
+  // manufacturing tests, each takes seconds to plan so they run once
+  static std::vector<planning_part> planning_parts() {
+    return {
+      {"test/stl-files/onshape_parts/Part Studio 4 - Part 1.stl", 0.25, point(0, 0, 1)},
+      {"test/stl-files/Arm_Joint_Top.stl", 1.0, point(0, -1, 0)},
+      {"test/stl-files/RectangleWithCircularNotch.stl", 1.0, point(0, -1, 0)},
+      {"test/stl-files/OctagonWithHolesShort.stl", 1.0, point(0, 0, 1)},
+      {"test/stl-files/CircleWithFilletAndSide.stl", 1.0, point(0, 0, 1)},
+      {"test/stl-files/onshape_parts/PSU Mount - PSU Mount.stl", 1.0, point(-1, 0, 0)}};
+  }
+
+  void register_planning_benchmarks(benchmark_registry& r) {
+    for (auto& part : planning_parts()) {
+      std::string path = r.data_path(part.path);
+      std::string name = file_name(path);
+
+      r.add("build_feature_decomposition/" + name, [path, part](benchmark_state& state) {
+	  triangular_mesh m = parse_and_scale_stl(path, part.scale_factor, 0.001);
+	  unsigned num_features = 0;
+	  while (state.keep_running()) {
+	    feature_decomposition* f = build_feature_decomposition(m, part.n);
+	    num_features = f->num_features();
+	  }
+	  state.set_items_processed(num_features);
+	});
+
+      r.add("make_fabrication_plan/" + name, [path, part](benchmark_state& state) {
+	  triangular_mesh m = parse_and_scale_stl(path, part.scale_factor, 0.001);
+	  workpiece wp(1.75, 1.75, 2.5, ALUMINUM);
+	  fabrication_inputs inputs = current_fab_inputs(wp);
+	  unsigned num_steps = 0;
+	  while (state.keep_running()) {
+	    fabrication_plan p = make_fabrication_plan(m, inputs);
+	    num_steps = p.steps().size();
+	  }
+	  state.set_label(std::to_string(num_steps) + " setups");
+	});
+    }
+  }
+
+}
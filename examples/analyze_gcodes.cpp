@@ -131,7 +131,7 @@ simulate_program_GCA(const vector<block>& p, const string& file_name) {
       infer_operation_ranges_GCA(p);
 
     vector<operation_params> prog_ops =
-      program_operations_GCA(paths, tt, op_ranges);
+      program_operations_GCA(paths, tt, op_ranges, emco_f1_profile());
 
     return prog_ops;
   } else {
@@ -162,7 +162,7 @@ void simulate_all_programs(const std::string& dir_name) {
   	  infer_operation_ranges_HAAS(p);
 
   	vector<operation_params> prog_ops =
-  	  program_operations_HAAS(paths, tt, op_ranges);
+  	  program_operations_HAAS(paths, tt, op_ranges, haas_vf_profile());
 
   	double program_length = 0.0;
   	double program_cut_length = 0.0;
@@ -280,7 +280,7 @@ vector<operation_params> generate_params(const std::string& dir_name) {
   	// std::vector<operation_range> op_ranges =
   	//   infer_operation_ranges_GCA(p);
 
-  	// auto ops = program_operations_GCA(paths, tt, op_ranges);
+  	// auto ops = program_operations_GCA(paths, tt, op_ranges, emco_f1_profile());
   	// concat(all_params, ops);
 
   	//simulation_log l = simulation_log_GCA(paths, tt, op_ranges);
@@ -294,7 +294,7 @@ vector<operation_params> generate_params(const std::string& dir_name) {
   	std::vector<operation_range> op_ranges =
   	  infer_operation_ranges_HAAS(p);
 
-  	auto prog_ops = program_operations_GCA(paths, tt, op_ranges);
+  	auto prog_ops = program_operations_GCA(paths, tt, op_ranges, emco_f1_profile());
 
   	// simulation_log l = simulation_log_HAAS(paths, tt, op_ranges);
 
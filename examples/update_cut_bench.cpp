@@ -0,0 +1,90 @@
+#include <chrono>
+#include <iostream>
+
+#include "gcode/circular_arc.h"
+#include "gcode/linear_cut.h"
+#include "simulators/mill_tool.h"
+#include "simulators/sim_mill.h"
+#include "utils/arena_allocator.h"
+
+using namespace gca;
+using namespace std;
+
+template<typename F>
+double ns_per_op(const unsigned n, F f) {
+  auto start = chrono::high_resolution_clock::now();
+  f();
+  auto end = chrono::high_resolution_clock::now();
+  return chrono::duration<double, nano>(end - start).count() / n;
+}
+
+// Spiral of alternating lines and half circle arcs over a 10x10 block
+vector<cut*> spiral_cuts(const unsigned n) {
+  vector<cut*> cuts;
+  double z = 0.9;
+  for (unsigned i = 0; i < n; i++) {
+    double y = 1.0 + 8.0*(i % 40) / 40.0;
+    cuts.push_back(new (allocate<linear_cut>()) linear_cut(point(1, y, z), point(9, y, z)));
+    cuts.push_back(new (allocate<circular_arc>())
+		   circular_arc(point(9, y, z), point(9, y + 0.2, z), point(0, 0.1, 0),
+				COUNTERCLOCKWISE, XY));
+  }
+  return cuts;
+}
+
+int main(int argc, char** argv) {
+  arena_allocator a;
+  set_system_allocator(&a);
+
+  const unsigned n = argc > 1 ? atoi(argv[1]) : 2000;
+  vector<cut*> cuts = spiral_cuts(n);
+
+  vector<linear_cut> lines;
+  vector<circular_arc> arcs;
+  for (unsigned i = 0; i < cuts.size(); i += 2) {
+    lines.push_back(*static_cast<linear_cut*>(cuts[i]));
+    arcs.push_back(*static_cast<circular_arc*>(cuts[i + 1]));
+  }
+
+  // Copies land in storage reserved up front so only the cuts
+  // themselves are measured
+  vector<linear_cut> line_copies;
+  line_copies.reserve(lines.size());
+  double copy_ns = ns_per_op(lines.size(), [&]() {
+      for (auto& l : lines) { line_copies.push_back(l); }
+    });
+
+  double shift_ns = ns_per_op(lines.size(), [&]() {
+      for (auto& l : line_copies) { l.translate(point(0.1, 0, 0)); }
+    });
+
+  // Even cuts are lines and odd cuts are arcs
+  auto value_ns = [&cuts](const unsigned first) {
+    point sum(0, 0, 0);
+    double ns = ns_per_op(500*cuts.size(), [&cuts, &sum, first]() {
+	for (unsigned j = first; j < cuts.size(); j += 2) {
+	  for (unsigned i = 0; i < 1000; i++) { sum = sum + cuts[j]->value_at(i / 1000.0); }
+	}
+      });
+    cout << "# checksum " << sum << endl;
+    return ns;
+  };
+  double line_value_ns = value_ns(0);
+  double arc_value_ns = value_ns(1);
+
+  region r(10, 10, 1, 0.01);
+  r.r.set_height(0, 10, 0, 10, 1.0);
+  cylindrical_bit t(0.05);
+  double volume = 0.0;
+  double update_ns = ns_per_op(cuts.size(), [&]() {
+      for (auto c : cuts) { volume += update_cut(*c, r, t); }
+    });
+
+  cout << "cuts          " << cuts.size() << endl;
+  cout << "copy          " << copy_ns << " ns/cut" << endl;
+  cout << "shift         " << shift_ns << " ns/cut" << endl;
+  cout << "line value_at " << line_value_ns << " ns/sample" << endl;
+  cout << "arc value_at  " << arc_value_ns << " ns/sample" << endl;
+  cout << "update_cut    " << update_ns << " ns/cut" << endl;
+  cout << "volume        " << volume << endl;
+}
@@ -0,0 +1,215 @@
+#include <cmath>
+#include <limits>
+
+#include "analysis/cycle_time.h"
+#include "gcode/circular_arc.h"
+#include "gcode/circular_helix_cut.h"
+
+namespace gca {
+
+  machine_profile emco_f1_profile() {
+    return machine_profile{point(30, 30, 30), point(2, 2, 2), 20, 0.001};
+  }
+
+  machine_profile haas_vf_profile() {
+    return machine_profile{point(1000, 1000, 1000), point(190, 190, 190), 1000, 0.002};
+  }
+
+  machine_profile wells_profile() {
+    return machine_profile{point(200, 200, 150), point(20, 20, 15), 100, 0.001};
+  }
+
+  machine_profile camaster_profile() {
+    return machine_profile{point(1200, 1200, 600), point(40, 40, 20), 250, 0.002};
+  }
+
+  // Speeds in the planner are in inches per second
+  struct planned_move {
+    double length;
+    point entry_direction;
+    point exit_direction;
+    double max_speed;
+    double acceleration;
+  };
+
+  static const double unlimited = std::numeric_limits<double>::infinity();
+
+  // Largest value of limit[i] / |u[i]| over the axes u moves along
+  static double axis_limit(const point u, const point limit) {
+    double l = unlimited;
+    if (fabs(u.x) > 1e-9) { l = min(l, limit.x / fabs(u.x)); }
+    if (fabs(u.y) > 1e-9) { l = min(l, limit.y / fabs(u.y)); }
+    if (fabs(u.z) > 1e-9) { l = min(l, limit.z / fabs(u.z)); }
+    return l;
+  }
+
+  // Tangent of the arc with the given center and direction at p
+  static point arc_tangent(const point p,
+			   const point center,
+			   const direction dir,
+			   const double horizontal,
+			   const double vertical) {
+    point r = p - center;
+    point t = dir == COUNTERCLOCKWISE ? point(-r.y, r.x, 0) : point(r.y, -r.x, 0);
+    t = t.normalize();
+    return (horizontal*t + point(0, 0, vertical)).normalize();
+  }
+
+  template<typename A>
+  static void plan_arc(const A* arc, const machine_profile& m, planned_move& move) {
+    double radius = sqrt(arc->start_offset.x*arc->start_offset.x +
+			 arc->start_offset.y*arc->start_offset.y);
+    double horizontal = radius*swept_angle(arc);
+    double vertical = arc->get_end().z - arc->get_start().z;
+
+    move.entry_direction =
+      arc_tangent(arc->get_start(), arc->center(), arc->dir, horizontal, vertical);
+    move.exit_direction =
+      arc_tangent(arc->get_end(), arc->center(), arc->dir, horizontal, vertical);
+
+    // Both axes of the plane reach every direction around the arc
+    double speed = min(m.max_axis_feed.x, m.max_axis_feed.y) / 60.0;
+    double accel = min(m.max_axis_acceleration.x, m.max_axis_acceleration.y);
+    if (fabs(vertical) > 1e-9) {
+      speed = min(speed, axis_limit(point(0, 0, vertical / move.length), m.max_axis_feed) / 60.0);
+    }
+
+    // Centripetal acceleration has to stay within the axis limits
+    move.max_speed = min(move.max_speed, min(speed, sqrt(accel*radius)));
+    move.acceleration = accel;
+  }
+
+  static planned_move plan_move(const cut* c,
+				const double feed,
+				const machine_profile& m) {
+    planned_move move;
+    move.length = travel_distance(c);
+    move.max_speed = c->is_safe_move() ? unlimited : feed / 60.0;
+
+    if (c->is_circular_arc()) {
+      plan_arc(static_cast<const circular_arc*>(c), m, move);
+    } else if (c->is_circular_helix_cut()) {
+      plan_arc(static_cast<const circular_helix_cut*>(c), m, move);
+    } else {
+      point u = (c->get_end() - c->get_start()).normalize();
+      move.entry_direction = u;
+      move.exit_direction = u;
+      move.max_speed = min(move.max_speed, axis_limit(u, m.max_axis_feed) / 60.0);
+      move.acceleration = axis_limit(u, m.max_axis_acceleration);
+    }
+
+    return move;
+  }
+
+  // Fastest speed the corner between from and to can be taken at
+  // while staying within the junction deviation of it
+  static double junction_speed(const planned_move& from,
+			       const planned_move& to,
+			       const machine_profile& m) {
+    double speed = min(from.max_speed, to.max_speed);
+    double cos_theta = -from.exit_direction.dot(to.entry_direction);
+
+    if (cos_theta > 0.999999) { return 0.0; }
+    if (cos_theta < -0.999999) { return speed; }
+
+    double sin_half = sqrt(0.5*(1.0 - cos_theta));
+    double accel = min(from.acceleration, to.acceleration);
+    return min(speed,
+	       sqrt(accel*m.junction_deviation*sin_half / (1.0 - sin_half)));
+  }
+
+  // Time to cover length starting at entry and ending at exit while
+  // accelerating at accel and never passing max_speed
+  static double trapezoid_time(const double length,
+			       const double entry,
+			       const double exit,
+			       const double max_speed,
+			       const double accel) {
+    double peak_sq = accel*length + 0.5*(entry*entry + exit*exit);
+    if (peak_sq <= max_speed*max_speed) {
+      double peak = sqrt(peak_sq);
+      return (2*peak - entry - exit) / accel;
+    }
+
+    double speed_up = (max_speed*max_speed - entry*entry) / (2*accel);
+    double slow_down = (max_speed*max_speed - exit*exit) / (2*accel);
+    return (max_speed - entry) / accel +
+      (max_speed - exit) / accel +
+      (length - speed_up - slow_down) / max_speed;
+  }
+
+  std::vector<double> cut_times_seconds(const std::vector<cut*>& path,
+					const machine_profile& m) {
+    double rapid = max(m.max_axis_feed.x, max(m.max_axis_feed.y, m.max_axis_feed.z));
+    double feed = rapid;
+
+    std::vector<planned_move> moves;
+    moves.reserve(path.size());
+    for (auto c : path) {
+      value* f = c->get_feedrate();
+      if (f != nullptr && f->is_lit()) {
+	feed = static_cast<lit*>(f)->v;
+      }
+      DBG_ASSERT(feed > 0.0);
+
+      planned_move move = plan_move(c, feed, m);
+
+      // Moves that go nowhere only cost a block, they pass the
+      // speed and direction of the move before them through
+      if (move.length < 1e-12) {
+	move.length = 0.0;
+	move.entry_direction = moves.size() > 0 ? moves.back().exit_direction : point(0, 0, 0);
+	move.exit_direction = move.entry_direction;
+	move.max_speed = moves.size() > 0 ? moves.back().max_speed : 0.0;
+	move.acceleration = moves.size() > 0 ? moves.back().acceleration : 1.0;
+      }
+
+      moves.push_back(move);
+    }
+
+    unsigned n = moves.size();
+
+    // entry[i] is the speed at the start of move i and entry[n] the
+    // speed the path ends at. The backward sweep bounds each entry by
+    // the speed the machine can still stop from, the forward sweep by
+    // the speed it can reach
+    std::vector<double> entry(n + 1, 0.0);
+    for (unsigned i = n; i-- > 0;) {
+      double corner = i == 0 ? 0.0 : junction_speed(moves[i - 1], moves[i], m);
+      double stoppable =
+	sqrt(entry[i + 1]*entry[i + 1] + 2*moves[i].acceleration*moves[i].length);
+      entry[i] = min(corner, stoppable);
+    }
+
+    std::vector<double> times(n);
+    double seconds_per_block = 1.0 / m.blocks_per_second;
+    for (unsigned i = 0; i < n; i++) {
+      const planned_move& move = moves[i];
+      double reachable =
+	sqrt(entry[i]*entry[i] + 2*move.acceleration*move.length);
+      entry[i + 1] = min(entry[i + 1], reachable);
+
+      double t = 0.0;
+      if (move.length > 0.0) {
+	t = trapezoid_time(move.length,
+			   entry[i],
+			   entry[i + 1],
+			   move.max_speed,
+			   move.acceleration);
+      }
+      times[i] = max(t, seconds_per_block);
+    }
+
+    return times;
+  }
+
+  double execution_time_seconds(const std::vector<cut*>& path,
+				const machine_profile& m) {
+    double total = 0.0;
+    for (auto t : cut_times_seconds(path, m)) {
+      total += t;
+    }
+    return total;
+  }
+
+}
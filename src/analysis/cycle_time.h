@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "gcode/cut.h"
+#include "geometry/point.h"
+
+namespace gca {
+
+  // Motion limits of a machine's controller. Feeds are in inches per
+  // minute and accelerations in inches per second squared
+  struct machine_profile {
+    point max_axis_feed;
+    point max_axis_acceleration;
+
+    // Blocks the controller can read and plan per second, no move
+    // finishes faster than one block time
+    double blocks_per_second;
+
+    // How far the path may stray from a corner that is taken
+    // without stopping, in inches
+    double junction_deviation;
+  };
+
+  machine_profile emco_f1_profile();
+  machine_profile haas_vf_profile();
+  machine_profile wells_profile();
+  machine_profile camaster_profile();
+
+  // Time in seconds each cut of path takes on a machine that
+  // accelerates at a constant rate and looks ahead over the whole
+  // path. Corners are taken at the junction deviation speed and the
+  // path starts and ends at rest. Safe moves run at the axis limits
+  // and cuts without a literal feed use the last one before them
+  std::vector<double> cut_times_seconds(const std::vector<cut*>& path,
+					const machine_profile& m);
+
+  double execution_time_seconds(const std::vector<cut*>& path,
+				const machine_profile& m);
+
+}
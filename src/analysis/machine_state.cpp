@@ -1,6 +1,5 @@
-#include <stack>
-
 #include "analysis/machine_state.h"
+#include "analysis/unfold.h"
 #include "analysis/utils.h"
 #include "gcode/value.h"
 
@@ -269,26 +268,9 @@ namespace gca {
 					   const vector<block>& p) {
     vector<machine_state> ms;
     ms.push_back(init);
-    vector<pair<token, program_loc> > subroutine_starts = compute_starts(p);
-    stack<vector<block>::const_iterator> istack;
-    vector<block>::const_iterator it = p.begin();
-    while (it < p.end()) {
-      const block& b = *it;
-      if (is_call_block(b)) {
-	++it;
-	istack.push(it);
-	it = find_called_subroutine(b, subroutine_starts);
-      } else if (is_ret_block(*it)) {
-	it = istack.top();
-	istack.pop();
-      } else if (is_end_block(*it)) {
-	ms.push_back(next_machine_state(*it, ms.back()));
-	break;
-      } else {
-	ms.push_back(next_machine_state(*it, ms.back()));
-	++it;
-      }
-    }
+    for_each_executed_block(p, [&ms](const block& b) {
+	ms.push_back(next_machine_state(b, ms.back()));
+      });
     return ms;
   }
   
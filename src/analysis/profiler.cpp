@@ -2,26 +2,44 @@
 
 namespace gca {
 
-  profile_info path_profile_info(const vector<cut*>& path) {
+  profile_info path_profile_info(const vector<cut*>& path,
+				 const vector<double>& cut_minutes) {
     profile_info info;
-    info.time = execution_time_minutes(path);
+    info.time = 0.0;
     info.time_wo_transitions = 0.0;
     info.time_wo_G1s = 0.0;
     info.time_wo_G2_G3 = 0.0;
     info.inches_traveled = 0.0;
 
-    for (auto c : path) {
+    for (unsigned i = 0; i < path.size(); i++) {
+      const cut* c = path[i];
+      info.time += cut_minutes[i];
       if (!c->is_safe_move())
-	{ info.time_wo_transitions += cut_execution_time_minutes(c); }
+	{ info.time_wo_transitions += cut_minutes[i]; }
       if (!c->is_linear_cut())
-	{ info.time_wo_G1s += cut_execution_time_minutes(c); }
+	{ info.time_wo_G1s += cut_minutes[i]; }
       if (!c->is_circular_arc() && !c->is_circular_helix_cut())
-	{ info.time_wo_G2_G3 += cut_execution_time_minutes(c); }
-      info.inches_traveled += (c->get_end() - c->get_start()).len();
+	{ info.time_wo_G2_G3 += cut_minutes[i]; }
+      info.inches_traveled += travel_distance(c);
     }
     return info;
   }
 
+  profile_info path_profile_info(const vector<cut*>& path) {
+    vector<double> cut_minutes;
+    for (auto c : path) {
+      cut_minutes.push_back(cut_execution_time_minutes(c));
+    }
+    return path_profile_info(path, cut_minutes);
+  }
+
+  profile_info path_profile_info(const vector<cut*>& path,
+				 const machine_profile& m) {
+    vector<double> cut_minutes = cut_times_seconds(path, m);
+    for (auto& t : cut_minutes) { t = t / 60.0; }
+    return path_profile_info(path, cut_minutes);
+  }
+
   void print_profile_info(const profile_info& info) {
     double pct_time_in_G0s = ((info.time - info.time_wo_transitions) / info.time) * 100;
     double pct_time_in_G1s = ((info.time - info.time_wo_G1s) / info.time) * 100;
@@ -50,6 +68,14 @@ namespace gca {
     return info;
   }
 
+  program_profile_info profile_toolpaths(const vector<vector<cut*>>& paths,
+					 const machine_profile& m) {
+    program_profile_info info;
+    for (auto& p : paths)
+      { info.push_back(path_profile_info(p, m)); }
+    return info;
+  }
+
   double execution_time(const program_profile_info& p) {
     double time = 0;
     for (auto prof : p)
@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include "analysis/cycle_time.h"
 #include "gcode/cut.h"
 
 using namespace std;
@@ -38,6 +39,10 @@ namespace gca {
   double execution_time(const program_profile_info& p);
 
   program_profile_info profile_toolpaths(const vector<vector<cut*>>& paths);
+
+  // Same profile with cut times from the motion planner of m
+  program_profile_info profile_toolpaths(const vector<vector<cut*>>& paths,
+					 const machine_profile& m);
   void print_profile_info(const vector<cut*>& path);
 
   void print_performance_diff(const program_profile_info& before,
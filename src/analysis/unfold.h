@@ -1,10 +1,40 @@
 #ifndef GCA_UNFOLD_H
 #define GCA_UNFOLD_H
 
+#include "analysis/utils.h"
 #include "gcode/lexer.h"
 
 namespace gca {
 
+  // Calls f on each block of p in the order the program runs them,
+  // following subroutine calls and returns up to the first end
+  // block. Blocks are visited where they are in p, so nested calls
+  // are followed without copying any of them
+  template<typename F>
+  void for_each_executed_block(const vector<block>& p, F f) {
+    label_index labels(p);
+    vector<size_t> returns;
+
+    size_t i = 0;
+    while (i < p.size()) {
+      const block& b = p[i];
+      if (is_call_block(b)) {
+	returns.push_back(i + 1);
+	i = labels.called_offset(b);
+      } else if (is_ret_block(b)) {
+	DBG_ASSERT(returns.size() > 0);
+	i = returns.back();
+	returns.pop_back();
+      } else if (is_end_block(b)) {
+	f(b);
+	break;
+      } else {
+	f(b);
+	i++;
+      }
+    }
+  }
+
   vector<block> unfold_gprog(const vector<block>& p);
 }
 
@@ -1,3 +1,5 @@
+#include <unordered_set>
+
 #include "analysis/utils.h"
 #include "analysis/position_table.h"
 #include "utils/algorithm.h"
@@ -64,23 +66,44 @@ namespace gca {
 
   vector<pair<token, program_loc> >
   compute_starts(const vector<block>& p) {
+    label_index labels(p);
+
     vector<pair<token, program_loc> > locs;
-    vector<token> already_added;
-    for (const auto b : p) {
+    std::unordered_set<int> already_added;
+    for (const auto& b : p) {
       if (is_call_block(b)) {
 	token ic = *find_if(b.begin(), b.end(), is_register('P'));
-	token line_no('N', ic.v);
-	if (find(already_added.begin(), already_added.end(), line_no) ==
-	    already_added.end()) {
-	  program_loc loc = find_loc(p, line_no);
-	  locs.push_back(pair<token, program_loc>(line_no, loc));
-	  already_added.push_back(line_no);
+	DBG_ASSERT(ic.v->is_ilit());
+
+	if (already_added.insert(static_cast<ilit*>(ic.v)->v).second) {
+	  program_loc loc = p.begin() + labels.called_offset(b);
+	  locs.push_back(pair<token, program_loc>(token('N', ic.v), loc));
 	}
       }
     }
     return locs;
   }
 
+  label_index::label_index(const vector<block>& p) : num_blocks(p.size()) {
+    for (size_t i = 0; i < p.size(); i++) {
+      for (auto& t : p[i]) {
+	if (t.tp() == ICODE && t.c == 'N' && t.v->is_ilit()) {
+	  offsets.insert({static_cast<ilit*>(t.v)->v, i});
+	}
+      }
+    }
+  }
+
+  size_t label_index::called_offset(const block& b) const {
+    auto ic = find_if(b.begin(), b.end(), is_register('P'));
+    DBG_ASSERT(ic != b.end());
+    DBG_ASSERT(ic->v->is_ilit());
+
+    auto loc = offsets.find(static_cast<ilit*>(ic->v)->v);
+    if (loc == offsets.end()) { return num_blocks; }
+    return loc->second;
+  }
+
   bool is_cut(const machine_state& s) {
     return (s.active_move_type != FAST_MOVE) && !(s.x->is_omitted() || s.y->is_omitted() || s.z->is_omitted());
   }
@@ -1,6 +1,8 @@
 #ifndef GCA_ANALYSIS_UTILS_H
 #define GCA_ANALYSIS_UTILS_H
 
+#include <unordered_map>
+
 #include "gcode/lexer.h"
 #include "analysis/machine_state.h"
 
@@ -43,6 +45,21 @@ namespace gca {
   vector<pair<token, program_loc> >
   compute_starts(const vector<block>& p);
 
+  // Offset of the first block holding each N label of a program,
+  // built in one pass over it
+  class label_index {
+  protected:
+    std::unordered_map<int, size_t> offsets;
+    size_t num_blocks;
+
+  public:
+    label_index(const vector<block>& p);
+
+    // Offset of the label the P word of call block b refers to, the
+    // end of the program when there is no such label
+    size_t called_offset(const block& b) const;
+  };
+
   bool is_cut(const machine_state& s);
   bool is_move(const machine_state& s);
   bool spindle_off(const machine_state& s);
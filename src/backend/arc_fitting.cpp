@@ -0,0 +1,198 @@
+#include <cmath>
+
+#include "backend/arc_fitting.h"
+#include "gcode/circular_arc.h"
+#include "gcode/linear_cut.h"
+#include "geometry/line.h"
+
+namespace gca {
+
+  // Growing one cut is quadratic in the number of points it replaces,
+  // so no cut replaces more than this many segments
+  static const int max_fit_segments = 256;
+
+  // Flatter arcs are left to the line fit
+  static const double max_arc_radius = 1000.0;
+
+  // Under half a turn, so the arc is never ambiguous and arc::value,
+  // which measures its sweep with angle_between, stays correct
+  static const double max_arc_sweep = 0.95*M_PI;
+
+  struct arc_fit {
+    point center;
+    direction dir;
+  };
+
+  static inline double xy_distance(const point a, const point b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    return sqrt(dx*dx + dy*dy);
+  }
+
+  // Every point strictly between i and j is within tolerance of the
+  // chord from i to j, so every segment between them is as well
+  static bool fits_line(const std::vector<point>& pts,
+			const int i,
+			const int j,
+			const double tolerance) {
+    for (int k = i + 1; k < j; k++) {
+      if (distance_to_segment(pts[k], pts[i], pts[j]) > tolerance) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // Circle in the XY plane through a, b and c, with its center at
+  // the height of a
+  static bool circle_through(const point a,
+			     const point b,
+			     const point c,
+			     arc_fit& fit) {
+    double bx = b.x - a.x;
+    double by = b.y - a.y;
+    double cx = c.x - a.x;
+    double cy = c.y - a.y;
+
+    double d = 2.0*(bx*cy - by*cx);
+    if (fabs(d) < 1e-12) { return false; }
+
+    double b2 = bx*bx + by*by;
+    double c2 = cx*cx + cy*cy;
+    fit.center = point(a.x + (cy*b2 - by*c2) / d,
+		       a.y + (bx*c2 - cx*b2) / d,
+		       a.z);
+    fit.dir = d > 0.0 ? COUNTERCLOCKWISE : CLOCKWISE;
+    return true;
+  }
+
+  // The circle through the first, middle and last points fits when
+  // the points and segment midpoints between them are within
+  // tolerance of it and the points turn one way around its center
+  static bool fits_arc(const std::vector<point>& pts,
+		       const int i,
+		       const int j,
+		       const double tolerance,
+		       arc_fit& fit) {
+    if (!circle_through(pts[i], pts[(i + j) / 2], pts[j], fit)) {
+      return false;
+    }
+
+    double r = xy_distance(fit.center, pts[i]);
+    if (r > max_arc_radius) { return false; }
+
+    double turn = fit.dir == COUNTERCLOCKWISE ? 1.0 : -1.0;
+    double sweep = 0.0;
+    for (int k = i; k < j; k++) {
+      point a = pts[k];
+      point b = pts[k + 1];
+
+      if (!within_eps(b.z, pts[i].z)) { return false; }
+
+      point u = a - fit.center;
+      point v = b - fit.center;
+      double step = atan2(u.x*v.y - u.y*v.x, u.x*v.x + u.y*v.y);
+      if (step*turn < 0.0) { return false; }
+      sweep += fabs(step);
+
+      if (fabs(xy_distance(fit.center, b) - r) > tolerance ||
+	  fabs(xy_distance(fit.center, 0.5*(a + b)) - r) > tolerance) {
+	return false;
+      }
+    }
+
+    return sweep <= max_arc_sweep;
+  }
+
+  std::vector<cut*> fit_arcs(const std::vector<point>& pts,
+			     const double tolerance) {
+    DBG_ASSERT(pts.size() > 1);
+
+    std::vector<cut*> cuts;
+    int last = pts.size() - 1;
+    int i = 0;
+    while (i < last) {
+      int max_j = min(last, i + max_fit_segments);
+
+      int line_end = i + 1;
+      while (line_end < max_j && fits_line(pts, i, line_end + 1, tolerance)) {
+	line_end++;
+      }
+
+      int arc_end = i;
+      arc_fit fit, next_fit;
+      for (int j = i + 2; j <= max_j && fits_arc(pts, i, j, tolerance, next_fit); j++) {
+	arc_end = j;
+	fit = next_fit;
+      }
+
+      if (arc_end > line_end) {
+	cuts.push_back(circular_arc::make(pts[i],
+					  pts[arc_end],
+					  fit.center - pts[i],
+					  fit.dir,
+					  XY));
+	i = arc_end;
+      } else {
+	cuts.push_back(linear_cut::make(pts[i], pts[line_end]));
+	i = line_end;
+      }
+    }
+
+    return cuts;
+  }
+
+  static bool same_run(const cut* l, const cut* r) {
+    return r->is_linear_cut() &&
+      l->tool_no == r->tool_no &&
+      same_cut_properties(*l, *r) &&
+      within_eps(l->get_end(), r->get_start());
+  }
+
+  static std::vector<cut*> fit_arcs(const std::vector<cut*>& cuts,
+				    const double tolerance) {
+    std::vector<cut*> fitted;
+
+    unsigned i = 0;
+    while (i < cuts.size()) {
+      if (!cuts[i]->is_linear_cut()) {
+	fitted.push_back(cuts[i]);
+	i++;
+	continue;
+      }
+
+      std::vector<point> pts{cuts[i]->get_start(), cuts[i]->get_end()};
+      unsigned j = i;
+      while (j + 1 < cuts.size() && same_run(cuts[j], cuts[j + 1])) {
+	j++;
+	pts.push_back(cuts[j]->get_end());
+      }
+
+      for (auto c : fit_arcs(pts, tolerance)) {
+	c->settings = cuts[i]->settings;
+	c->tool_no = cuts[i]->tool_no;
+	fitted.push_back(c);
+      }
+
+      i = j + 1;
+    }
+
+    return fitted;
+  }
+
+  toolpath fit_arcs(const toolpath& tp, const double tolerance) {
+    std::vector<std::vector<cut*>> fitted;
+    for (auto& cuts : tp.cuts_without_safe_moves()) {
+      fitted.push_back(fit_arcs(cuts, tolerance));
+    }
+
+    return toolpath(tp.pocket_type(),
+		    tp.safe_z_before_tlc,
+		    tp.spindle_speed,
+		    tp.feedrate,
+		    tp.plunge_feedrate,
+		    tp.t,
+		    fitted);
+  }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "backend/toolpath.h"
+#include "gcode/cut.h"
+#include "geometry/point.h"
+
+namespace gca {
+
+  // Fewest linear cuts and XY circular arcs that pass through pts and
+  // stay within tolerance of the polyline between them. Arcs are only
+  // fit where the points share a z value, and never sweep more than
+  // half a turn. The cuts have no settings
+  std::vector<cut*> fit_arcs(const std::vector<point>& pts,
+			     const double tolerance);
+
+  // Refits every run of linear cuts with the same settings, leaving
+  // the other cuts of tp as they are
+  toolpath fit_arcs(const toolpath& tp, const double tolerance);
+
+}
@@ -165,6 +165,79 @@ namespace gca {
     }
   }
 
+  // End of the straight move ci->reflect_x() would have, evaluated
+  // the same way line::value does so that signed zeros print the same
+  static inline point written_end(const cut* ci, const bool reflected) {
+    if (!reflected) { return ci->get_end(); }
+
+    point s = ci->get_start();
+    point e = ci->get_end();
+    s.x = -1*s.x;
+    e.x = -1*e.x;
+    return (1.0 - 1.0)*s + 1.0*e;
+  }
+
+  void write_cut_block(const cut* ci, const bool reflected, gcode_writer& w) {
+    if (ci->is_hole_punch()) {
+    } else if (ci->is_linear_cut()) {
+      point e = written_end(ci, reflected);
+      w.word('G', 1);
+      w.word('X', e.x);
+      w.word('Y', e.y);
+      w.word('Z', e.z);
+      if (!ci->get_feedrate()->is_omitted()) { w.word('F', ci->get_feedrate()); }
+    } else if (ci->is_circular_arc()) {
+      // Reflected in place, the way circular_arc::reflect_x would,
+      // so writing does not allocate a copy of the arc
+      const circular_arc* arc = static_cast<const circular_arc*>(ci);
+      bool clockwise = (arc->dir == CLOCKWISE) != reflected;
+      double sign = reflected ? -1 : 1;
+      w.word('G', clockwise ? 2 : 3);
+      w.word('X', sign*arc->get_end().x);
+      w.word('Y', arc->get_end().y);
+      w.word('Z', arc->get_end().z);
+      w.word('I', sign*arc->start_offset.x);
+      w.word('J', arc->start_offset.y);
+    } else if (ci->is_safe_move()) {
+      point e = written_end(ci, reflected);
+      w.word('G', 0);
+      w.word('X', e.x);
+      w.word('Y', e.y);
+      w.word('Z', e.z);
+    } else {
+      assert(false);
+    }
+    w.end_block();
+  }
+
+  void write_cuts_gcode(const vector<cut*>& cuts,
+			const cut_params& params,
+			const bool reflected,
+			gcode_writer& w) {
+    write_cuts_gcode(NULL, cuts, params, reflected, w);
+  }
+
+  void write_cuts_gcode(const cut* last,
+			const vector<cut*>& cuts,
+			const cut_params& params,
+			const bool reflected,
+			gcode_writer& w) {
+    // Settings changes are rare, they go through the block builders
+    vector<block> settings_blocks;
+
+    const cut* last_cut = last;
+    for (auto next_cut : cuts) {
+      append_settings_block(last_cut, next_cut, settings_blocks, params);
+      if (settings_blocks.size() > 0) {
+	w.write(settings_blocks);
+	settings_blocks.clear();
+      }
+
+      write_cut_block(next_cut, reflected, w);
+      last_cut = next_cut;
+    }
+  }
+
   void append_header_blocks(vector<block>& bs, const machine_name m) {
     if (m == EMCO_F1) {
       block b;
@@ -3,6 +3,7 @@
 
 #include "gcode/lexer.h"
 #include "gcode/cut.h"
+#include "gcode/gcode_writer.h"
 #include "backend/shape_layout.h"
 
 namespace gca {
@@ -17,6 +18,31 @@ namespace gca {
 				const cut_params& params);
 
   std::vector<block> camaster_tool_change_block(const int tool_no);
+
+  void append_settings_block(const cut* last,
+			     const cut* next,
+			     vector<block>& blocks,
+			     const cut_params& params);
+
+  // Streaming versions of append_cut_block and append_cuts_gcode_blocks.
+  // With reflected set each cut is written as cut::reflect_x would
+  // leave it, without copying it
+  void write_cut_block(const cut* ci, const bool reflected, gcode_writer& w);
+
+  void write_cuts_gcode(const vector<cut*>& cuts,
+			const cut_params& params,
+			const bool reflected,
+			gcode_writer& w);
+
+  // Continues a program that was written up to last, settings that
+  // last already set up are not written again
+  void write_cuts_gcode(const cut* last,
+			const vector<cut*>& cuts,
+			const cut_params& params,
+			const bool reflected,
+			gcode_writer& w);
+
+  void append_header_blocks(vector<block>& bs, const machine_name m);
 }
 
 #endif
@@ -0,0 +1,293 @@
+#include <cmath>
+#include <numeric>
+
+#include "backend/drop_cutter.h"
+#include "utils/parallel.h"
+
+namespace gca {
+
+  static std::vector<index_t> all_positions(const unsigned n) {
+    std::vector<index_t> inds(n);
+    std::iota(begin(inds), end(inds), 0);
+    return inds;
+  }
+
+  drop_cutter::drop_cutter(const triangular_mesh& m) : bvh(m) {
+    init_arrays();
+  }
+
+  drop_cutter::drop_cutter(const triangular_mesh& m,
+			   const std::vector<index_t>& face_inds) :
+    bvh(m, face_inds) {
+    init_arrays();
+  }
+
+  drop_cutter::drop_cutter(const std::vector<triangle>& triangles) :
+    bvh(triangles, all_positions(triangles.size())) {
+    init_arrays();
+  }
+
+  void drop_cutter::init_arrays() {
+    unsigned n = bvh.num_faces();
+    for (auto v : {&ax, &ay, &az, &bx, &by, &bz, &cx, &cy, &cz, &nx, &ny, &nz}) {
+      v->resize(n);
+    }
+
+    for (unsigned i = 0; i < n; i++) {
+      const triangle& t = bvh.tree_triangle(i);
+      ax[i] = t.v1.x; ay[i] = t.v1.y; az[i] = t.v1.z;
+      bx[i] = t.v2.x; by[i] = t.v2.y; bz[i] = t.v2.z;
+      cx[i] = t.v3.x; cy[i] = t.v3.y; cz[i] = t.v3.z;
+
+      // Recompute the normal from the corners so it always points
+      // up, the cutter comes from above regardless of winding
+      point nm = cross(t.v2 - t.v1, t.v3 - t.v1);
+      double l = nm.len();
+      if (l > 0.0) { nm = (1.0 / l)*nm; }
+      if (nm.z < 0.0) { nm = -1*nm; }
+
+      nx[i] = nm.x; ny[i] = nm.y; nz[i] = nm.z;
+    }
+  }
+
+  // Normals with a smaller z component are treated as vertical,
+  // their facets are only touched along the edges
+  static const double min_facet_nz = 1e-8;
+
+  static inline bool in_triangle_xy(const double px, const double py,
+				    const double ax, const double ay,
+				    const double bx, const double by,
+				    const double cx, const double cy) {
+    double d1 = (bx - ax)*(py - ay) - (by - ay)*(px - ax);
+    double d2 = (cx - bx)*(py - by) - (cy - by)*(px - bx);
+    double d3 = (ax - cx)*(py - cy) - (ay - cy)*(px - cx);
+
+    bool has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
+    bool has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
+    return !(has_neg && has_pos);
+  }
+
+  // Height of the plane through a with unit normal n over (px, py)
+  static inline double plane_z(const double px, const double py,
+			       const double ax, const double ay, const double az,
+			       const double nx, const double ny, const double nz) {
+    return az - (nx*(px - ax) + ny*(py - ay)) / nz;
+  }
+
+  // Highest point of the edge p -> q inside the disk of radius r
+  // around (x, y). The edge height is linear along it, so the
+  // highest point is an end of the part of the edge in the disk
+  static inline double flat_edge_z(const double x, const double y,
+				   const double r,
+				   const double px, const double py, const double pz,
+				   const double qx, const double qy, const double qz,
+				   double z) {
+    double dx = qx - px;
+    double dy = qy - py;
+    double ex = px - x;
+    double ey = py - y;
+
+    double a = dx*dx + dy*dy;
+    double c = ex*ex + ey*ey - r*r;
+
+    if (a < 1e-20) {
+      if (c <= 0.0) { z = std::max(z, std::max(pz, qz)); }
+      return z;
+    }
+
+    double b = 2*(dx*ex + dy*ey);
+    double disc = b*b - 4*a*c;
+    if (disc < 0.0) { return z; }
+
+    double sq = sqrt(disc);
+    double t0 = std::max((-b - sq) / (2*a), 0.0);
+    double t1 = std::min((-b + sq) / (2*a), 1.0);
+    if (t0 > t1) { return z; }
+
+    double dz = qz - pz;
+    return std::max(z, std::max(pz + t0*dz, pz + t1*dz));
+  }
+
+  // Tip height at which a ball of radius r over (x, y) touches the
+  // edge p -> q away from its ends. In the vertical plane of the
+  // edge the ball is a circle of radius r_c resting on a line
+  static inline double ball_edge_z(const double x, const double y,
+				   const double r,
+				   const double px, const double py, const double pz,
+				   const double qx, const double qy, const double qz,
+				   double z) {
+    double dx = qx - px;
+    double dy = qy - py;
+    double len = sqrt(dx*dx + dy*dy);
+
+    // Vertical edges are only touched at their top end
+    if (len < 1e-10) { return z; }
+
+    double ux = dx / len;
+    double uy = dy / len;
+    double s_c = (x - px)*ux + (y - py)*uy;
+    double d_perp = (x - px)*uy - (y - py)*ux;
+
+    double r_c2 = r*r - d_perp*d_perp;
+    if (r_c2 <= 0.0) { return z; }
+    double r_c = sqrt(r_c2);
+
+    double m = (qz - pz) / len;
+    double k = sqrt(1 + m*m);
+    double s_contact = s_c + r_c*m / k;
+    if (s_contact < 0.0 || s_contact > len) { return z; }
+
+    double center_z = pz + m*s_c + r_c*k;
+    return std::max(z, center_z - r);
+  }
+
+  double drop_cutter::drop_flat(const double x, const double y,
+				const double r,
+				const unsigned start, const unsigned end,
+				double z) const {
+    // Facets, the highest point of a tilted plane under the disk is
+    // on its rim in the direction of steepest ascent
+    for (unsigned i = start; i < end; i++) {
+      if (nz[i] < min_facet_nz) { continue; }
+
+      double nxy = sqrt(nx[i]*nx[i] + ny[i]*ny[i]);
+      double px = x;
+      double py = y;
+      if (nxy > 1e-12) {
+	px -= r*nx[i] / nxy;
+	py -= r*ny[i] / nxy;
+      }
+
+      if (in_triangle_xy(px, py, ax[i], ay[i], bx[i], by[i], cx[i], cy[i])) {
+	z = std::max(z, plane_z(px, py, ax[i], ay[i], az[i], nx[i], ny[i], nz[i]));
+      }
+    }
+
+    // Edges, which also covers the corners
+    for (unsigned i = start; i < end; i++) {
+      z = flat_edge_z(x, y, r, ax[i], ay[i], az[i], bx[i], by[i], bz[i], z);
+      z = flat_edge_z(x, y, r, bx[i], by[i], bz[i], cx[i], cy[i], cz[i], z);
+      z = flat_edge_z(x, y, r, cx[i], cy[i], cz[i], ax[i], ay[i], az[i], z);
+    }
+
+    return z;
+  }
+
+  double drop_cutter::drop_ball(const double x, const double y,
+				const double r,
+				const unsigned start, const unsigned end,
+				double z) const {
+    // Corners
+    for (unsigned i = start; i < end; i++) {
+      const double vxs[3] = {ax[i], bx[i], cx[i]};
+      const double vys[3] = {ay[i], by[i], cy[i]};
+      const double vzs[3] = {az[i], bz[i], cz[i]};
+      for (int j = 0; j < 3; j++) {
+	double ex = vxs[j] - x;
+	double ey = vys[j] - y;
+	double h2 = r*r - (ex*ex + ey*ey);
+	if (h2 >= 0.0) {
+	  z = std::max(z, vzs[j] + sqrt(h2) - r);
+	}
+      }
+    }
+
+    // Facets, the ball touches the plane at the point one radius
+    // from its center against the normal
+    for (unsigned i = start; i < end; i++) {
+      if (nz[i] < min_facet_nz) { continue; }
+
+      double px = x - r*nx[i];
+      double py = y - r*ny[i];
+      if (in_triangle_xy(px, py, ax[i], ay[i], bx[i], by[i], cx[i], cy[i])) {
+	double contact_z = plane_z(px, py, ax[i], ay[i], az[i], nx[i], ny[i], nz[i]);
+	z = std::max(z, contact_z + r*nz[i] - r);
+      }
+    }
+
+    // Edges
+    for (unsigned i = start; i < end; i++) {
+      z = ball_edge_z(x, y, r, ax[i], ay[i], az[i], bx[i], by[i], bz[i], z);
+      z = ball_edge_z(x, y, r, bx[i], by[i], bz[i], cx[i], cy[i], cz[i], z);
+      z = ball_edge_z(x, y, r, cx[i], cy[i], cz[i], ax[i], ay[i], az[i], z);
+    }
+
+    return z;
+  }
+
+  double drop_cutter::drop(const double x, const double y,
+			   const tool& t,
+			   const double z_min) const {
+    DBG_ASSERT(t.type() == FLAT_NOSE || t.type() == BALL_NOSE);
+
+    double r = t.cut_diameter() / 2.0;
+    bool ball = t.type() == BALL_NOSE;
+
+    double z = z_min;
+    bvh.for_each_leaf_in_xy(x - r, x + r, y - r, y + r,
+			    [&](const unsigned start, const unsigned end) {
+			      z = ball ?
+				drop_ball(x, y, r, start, end, z) :
+				drop_flat(x, y, r, start, end, z);
+			    });
+    return z;
+  }
+
+  std::vector<point> drop_cutter::drop(const std::vector<point>& pts,
+				       const tool& t,
+				       const double z_min) const {
+    return parallel_map(pts, [this, &t, z_min](const point p) {
+	return point(p.x, p.y, drop(p.x, p.y, t, z_min));
+      });
+  }
+
+  std::vector<polyline>
+  drop_cutter::drop(const std::vector<polyline>& lines,
+		    const tool& t,
+		    const double z_min) const {
+    std::vector<point> all_pts;
+    for (auto& l : lines) {
+      all_pts.insert(end(all_pts), begin(l), end(l));
+    }
+
+    std::vector<point> dropped = drop(all_pts, t, z_min);
+
+    std::vector<polyline> dropped_lines;
+    unsigned total = 0;
+    for (auto& l : lines) {
+      std::vector<point> pts(begin(dropped) + total,
+			     begin(dropped) + total + l.num_points());
+      total += l.num_points();
+      dropped_lines.push_back(polyline(pts));
+    }
+
+    return dropped_lines;
+  }
+
+  maybe<double> drop_cutter::surface_z(const double x, const double y) const {
+    bool found = false;
+    unsigned best = 0;
+
+    bvh.for_each_leaf_in_xy(x, x, y, y,
+			    [&](const unsigned start, const unsigned end) {
+      for (unsigned i = start; i < end; i++) {
+	if (found &&
+	    bvh.tree_input_position(i) > bvh.tree_input_position(best)) {
+	  continue;
+	}
+
+	const triangle& t = bvh.tree_triangle(i);
+	if (t.normal.z > 0.01 &&
+	    point_in_triangle_2d(point(x, y, 0), t.v1, t.v2, t.v3)) {
+	  found = true;
+	  best = i;
+	}
+      }
+    });
+
+    if (!found) { return maybe<double>(); }
+
+    return maybe<double>(z_at(bvh.tree_triangle(best), x, y));
+  }
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include "backend/tool.h"
+#include "geometry/line.h"
+#include "geometry/mesh_bvh.h"
+#include "geometry/polyline.h"
+#include "geometry/triangular_mesh.h"
+
+namespace gca {
+
+  // Drops flat and ball end mills straight down onto a set of
+  // faces. The faces are indexed once in a BVH and copied out in
+  // tree order as flat coordinate arrays, so the contact tests for
+  // a leaf run over contiguous memory. Build one per mesh and reuse
+  // it for every cutter location
+  class drop_cutter {
+  protected:
+    mesh_bvh bvh;
+
+    // Corners and upward unit normals of the faces in tree order
+    std::vector<double> ax, ay, az, bx, by, bz, cx, cy, cz;
+    std::vector<double> nx, ny, nz;
+
+    void init_arrays();
+
+    double drop_flat(const double x, const double y,
+		     const double r,
+		     const unsigned start, const unsigned end,
+		     double z) const;
+
+    double drop_ball(const double x, const double y,
+		     const double r,
+		     const unsigned start, const unsigned end,
+		     double z) const;
+
+  public:
+    drop_cutter(const triangular_mesh& m);
+
+    // Only the faces in face_inds are considered
+    drop_cutter(const triangular_mesh& m,
+		const std::vector<index_t>& face_inds);
+
+    drop_cutter(const std::vector<triangle>& triangles);
+
+    // Height of the cutter tip over (x, y) when it rests on the
+    // faces, or z_min if nothing under the cutter is higher
+    double drop(const double x, const double y,
+		const tool& t,
+		const double z_min) const;
+
+    // Each point is dropped in parallel, results keep the order
+    // of pts
+    std::vector<point> drop(const std::vector<point>& pts,
+			    const tool& t,
+			    const double z_min) const;
+
+    std::vector<polyline> drop(const std::vector<polyline>& lines,
+			       const tool& t,
+			       const double z_min) const;
+
+    // Same result as z_at(x, y, faces, mesh) over the faces this
+    // cutter was built from
+    maybe<double> surface_z(const double x, const double y) const;
+  };
+
+}
@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "backend/feedrate_optimization.h"
 
 namespace gca {
@@ -8,9 +10,7 @@ namespace gca {
     double y_len = b.y_max - b.y_min;
     double z_len = mregion.height();
 
-    class region r(x_len, y_len, z_len, 0.01);
-    r.set_machine_x_offset(-b.x_min);
-    r.set_machine_y_offset(-b.y_min);
+    class region r(point(b.x_min, b.y_min, 0), x_len, y_len, z_len, 0.01);
     r.set_machine_z_offset(-mregion.end_depth); //-b.z_min);
 
     // TODO: Find better way to express the safe z value in the
@@ -18,82 +18,283 @@ namespace gca {
     // point safe_machine_point(0, 0, mregion.start_depth()); //mregion.height());
     // point safe_region_point = r.machine_coords_to_region_coords(safe_machine_point);
 
-    auto poly_2d = to_boost_multipoly_2(mregion.machine_area);
+    // Columns start empty, the ones inside the machine area are
+    // found with one scanline per column of the region
+    for (auto& p : mregion.machine_area) {
+      for (auto cell : rasterize_polygon(p, r.r)) {
+	r.r.set_column_height(cell.first, cell.second, mregion.height());
+      }
+    }
 
-    for (int i = 0; i < r.r.num_x_elems; i++) {
-      for (int j = 0; j < r.r.num_y_elems; j++) {
-	double r_x = r.r.resolution*i;
-	double r_y = r.r.resolution*j;
+    return r;
+  }
+
+  // Raises every column under t to the height of t there
+  static void rasterize_top_face(const triangle& t, depth_field& df) {
+    point n = cross(t.v2 - t.v1, t.v3 - t.v1);
+    if (fabs(n.z) < 1e-12) { return; }
+
+    const point vs[3] = {t.v1, t.v2, t.v3};
+
+    double x_min = min(t.v1.x, min(t.v2.x, t.v3.x));
+    double x_max = max(t.v1.x, max(t.v2.x, t.v3.x));
+    int first_i = max(df.x_index(x_min), 0);
+    int last_i = min(df.x_index(x_max) + 1, df.num_x_elems - 1);
 
-	point dummy(r_x, r_y, 0.0);
-	point converted = r.region_coords_to_machine_coords(dummy);
+    for (int i = first_i; i <= last_i; i++) {
+      double x = df.x_coord(i);
 
-	bg::model::d2::point_xy<double> conv_pt(converted.x, converted.y);
+      double y_lo = 0.0;
+      double y_hi = 0.0;
+      bool crossed = false;
+      for (int k = 0; k < 3; k++) {
+	point a = vs[k];
+	point b = vs[(k + 1) % 3];
 
-	if (bg::within(conv_pt, poly_2d)) {
-	  r.r.set_column_height(i, j, mregion.height()); //safe_region_point.z);
-	} else {
-	  r.r.set_column_height(i, j, 0.0);
+	if ((a.x <= x && x < b.x) || (b.x <= x && x < a.x)) {
+	  double y = a.y + (x - a.x)*(b.y - a.y)/(b.x - a.x);
+	  y_lo = crossed ? min(y_lo, y) : y;
+	  y_hi = crossed ? max(y_hi, y) : y;
+	  crossed = true;
+	}
+      }
+
+      if (!crossed) { continue; }
+
+      int first_j = max(df.y_index(y_lo), 0);
+      int last_j = min(df.y_index(y_hi) + 1, df.num_y_elems - 1);
+      for (int j = first_j; j <= last_j; j++) {
+	double y = df.y_coord(j);
+	if (y < y_lo || y > y_hi) { continue; }
+
+	double z = t.v1.z - (n.x*(x - t.v1.x) + n.y*(y - t.v1.y)) / n.z;
+	if (z > df.column_height(i, j)) {
+	  df.set_column_height(i, j, z);
 	}
       }
     }
+  }
+
+  class region stock_region(const triangular_mesh& stock,
+			    const double resolution) {
+    box b = stock.bounding_box();
+
+    class region r(point(b.x_min, b.y_min, 0),
+		   b.x_max - b.x_min,
+		   b.y_max - b.y_min,
+		   b.z_max - b.z_min,
+		   resolution);
+
+    // Cutting at or above the bottom of the stock removes nothing
+    // from columns that no face covers
+    for (int i = 0; i < r.r.num_x_elems; i++) {
+      for (int j = 0; j < r.r.num_y_elems; j++) {
+	r.r.set_column_height(i, j, b.z_min);
+      }
+    }
+
+    for (auto i : stock.face_indexes()) {
+      triangle t = stock.face_triangle(i);
+      if (t.normal.z > 0.0) {
+	rasterize_top_face(t, r.r);
+      }
+    }
 
     return r;
   }
 
-  void optimize_feedrates_by_MRR_simulation(class region& sim_region,
-					    toolpath& tp,
-					    const double machine_hp,
-					    const double material_unit_hp) {
+  // Cells under the cutter relative to the cell of the tool tip,
+  // with the height of the cutter above the tip over each one
+  struct stencil_cell {
+    int di, dj;
+    double dz;
+  };
 
-    cylindrical_bit current_tool(tp.t.cut_diameter());
+  static std::vector<stencil_cell>
+  cutter_stencil(const tool& t, const double resolution) {
+    double r = t.cut_diameter() / 2.0;
+    int n = static_cast<int>(ceil(r / resolution));
+    bool ball = t.type() == BALL_NOSE;
 
-    for (auto cuts : tp.cuts_without_safe_moves()) {
+    std::vector<stencil_cell> stencil;
+    for (int di = -n; di <= n; di++) {
+      for (int dj = -n; dj <= n; dj++) {
+	double d2 = (di*resolution)*(di*resolution) + (dj*resolution)*(dj*resolution);
+	if (d2 > r*r) { continue; }
 
-      for (auto c : cuts) {
-	double cut_volume = update_cut(*c, sim_region, current_tool);
-	double cut_mrr = cut_volume / cut_execution_time_minutes(c);
-	double cut_power = material_unit_hp*cut_mrr;
+	double dz = ball ? r - sqrt(r*r - d2) : 0.0;
+	stencil.push_back({di, dj, dz});
+      }
+    }
 
-	cout << "Cut required power = " << cut_power << " hp" << endl;
+    return stencil;
+  }
 
-	if (cut_power >= machine_hp) {
+  static double remove_material_at(class region& sim_region,
+				   const std::vector<stencil_cell>& stencil,
+				   const point machine_pt) {
+    point p = sim_region.machine_coords_to_region_coords(machine_pt);
+    depth_field& df = sim_region.r;
 
-	  if (c->is_safe_move()) {
-	    cout << "Cut that requires large power is a safe move?" << endl;
-	    DBG_ASSERT(false);
-	  }
+    int ci = static_cast<int>(floor((p.x - df.x_min()) / df.resolution));
+    int cj = static_cast<int>(floor((p.y - df.y_min()) / df.resolution));
 
-	  double scaled_down_power = 0.8*machine_hp;
+    double height_removed = 0.0;
+    for (auto& s : stencil) {
+      int i = ci + s.di;
+      int j = cj + s.dj;
+      if (!df.legal_column(i, j)) { continue; }
 
-	  double scaled_down_feed =
-	    (scaled_down_power*(c->length())) / (material_unit_hp * cut_volume);
+      double tool_z = p.z + s.dz;
+      double h = df.column_height(i, j);
+      if (h > tool_z) {
+	height_removed += h - tool_z;
+	df.set_column_height(i, j, tool_z);
+      }
+    }
 
-	  cout << "Scaling down feed to " << scaled_down_feed << endl;
+    return height_removed*df.resolution*df.resolution;
+  }
 
-	  c->set_feedrate(lit::make(scaled_down_feed));
-	}
+  static double remove_material_along(class region& sim_region,
+				      const std::vector<stencil_cell>& stencil,
+				      const cut& c) {
+    int n = max(1, static_cast<int>(ceil(c.length() / sim_region.r.resolution)));
 
+    double volume = 0.0;
+    for (int k = 0; k <= n; k++) {
+      point p = c.value_at(static_cast<double>(k) / n);
+      volume += remove_material_at(sim_region, stencil, p);
+    }
+    return volume;
+  }
+
+  static std::vector<cut*> split_cut(const cut* c, const double max_length) {
+    if (!c->is_linear_cut() || c->length() <= max_length) {
+      return {c->copy()};
+    }
+
+    int n = static_cast<int>(ceil(c->length() / max_length));
+    point s = c->get_start();
+    point e = c->get_end();
+
+    std::vector<cut*> pieces;
+    for (int k = 0; k < n; k++) {
+      cut* piece = c->copy();
+      piece->set_start(s + (static_cast<double>(k) / n)*(e - s));
+      piece->set_end(s + (static_cast<double>(k + 1) / n)*(e - s));
+      pieces.push_back(piece);
+    }
+    return pieces;
+  }
+
+  static double planned_feed(const cut* c, const toolpath& tp) {
+    value* f = c->get_feedrate();
+    if (f != nullptr && f->is_lit()) {
+      return static_cast<lit*>(f)->v;
+    }
+    return tp.feedrate;
+  }
+
+  // Fastest feed that keeps every axis under its limit, arcs may
+  // move in any direction in the XY plane
+  static double machine_feed_limit(const cut& c,
+				   const point max_axis_feed) {
+    double xy_feed = min(max_axis_feed.x, max_axis_feed.y);
+    point d = c.get_end() - c.get_start();
+
+    if (!c.is_linear_cut()) {
+      return within_eps(d.z, 0.0) ? xy_feed : min(xy_feed, max_axis_feed.z);
+    }
+
+    double l = d.len();
+    double limit = std::numeric_limits<double>::infinity();
+    if (l <= 0.0) { return limit; }
+
+    if (!within_eps(d.x, 0.0)) { limit = min(limit, max_axis_feed.x*l / fabs(d.x)); }
+    if (!within_eps(d.y, 0.0)) { limit = min(limit, max_axis_feed.y*l / fabs(d.y)); }
+    if (!within_eps(d.z, 0.0)) { limit = min(limit, max_axis_feed.z*l / fabs(d.z)); }
+    return limit;
+  }
+
+  // Power drawn is material_unit_hp*volume*feed / length, so the
+  // fastest feed under the limit is found directly
+  static double power_limited_feed(const double planned,
+				   const cut& c,
+				   const double volume,
+				   const feed_optimization_params& params) {
+    double length = c.length();
+    double max_feed =
+      min(params.max_feed_scale*planned,
+	  machine_feed_limit(c, params.max_axis_feed));
+    if (volume <= 0.0 || length <= 0.0) { return max_feed; }
+
+    double power_feed =
+      (params.target_load*params.machine_hp*length) /
+      (params.material_unit_hp*volume);
+    return min(max_feed, power_feed);
+  }
+
+  toolpath optimize_feedrates_by_MRR_simulation(class region& sim_region,
+						const toolpath& tp,
+						const feed_optimization_params& params) {
+    std::vector<stencil_cell> stencil =
+      cutter_stencil(tp.t, sim_region.r.resolution);
+
+    std::vector<std::vector<cut*>> optimized;
+    for (auto& cuts : tp.cuts_without_safe_moves()) {
+      std::vector<cut*> new_cuts;
+
+      for (auto c : cuts) {
+	double planned = planned_feed(c, tp);
+	double last_feed = -1.0;
+	for (auto piece : split_cut(c, params.max_segment_length)) {
+	  double volume = remove_material_along(sim_region, stencil, *piece);
+	  double feed = power_limited_feed(planned, *piece, volume, params);
+
+	  // Neighboring pieces of one cut at the same feed are emitted
+	  // as a single move
+	  if (piece->is_linear_cut() && within_eps(feed, last_feed, 1e-6)) {
+	    new_cuts.back()->set_end(piece->get_end());
+	    continue;
+	  }
+
+	  piece->set_feedrate(lit::make(feed));
+	  new_cuts.push_back(piece);
+	  last_feed = feed;
+	}
       }
 
+      optimized.push_back(new_cuts);
     }
 
+    return toolpath(tp.pocket_type(),
+		    tp.safe_z_before_tlc,
+		    tp.spindle_speed,
+		    tp.feedrate,
+		    tp.plunge_feedrate,
+		    tp.t,
+		    optimized);
   }
-  
+
   void optimize_feedrates_by_MRR_simulation(const flat_region& r,
 					    std::vector<toolpath>& toolpaths,
-					    const double machine_hp,
-					    const double material_unit_hp) {
-
+					    const feed_optimization_params& params) {
     class region sim_region = bounding_region(r);
 
     for (auto& tp : toolpaths) {
-      optimize_feedrates_by_MRR_simulation(sim_region,
-					   tp,
-					   machine_hp,
-					   material_unit_hp);
+      tp = optimize_feedrates_by_MRR_simulation(sim_region, tp, params);
     }
+  }
 
+  void optimize_feedrates_by_MRR_simulation(const flat_region& r,
+					    std::vector<toolpath>& toolpaths,
+					    const double machine_hp,
+					    const double material_unit_hp) {
+    optimize_feedrates_by_MRR_simulation(r,
+					 toolpaths,
+					 feed_optimization_params(machine_hp,
+								  material_unit_hp));
   }
 
 }
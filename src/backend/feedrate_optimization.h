@@ -1,12 +1,75 @@
 #pragma once
 
+#include <limits>
+
+#include "analysis/cycle_time.h"
 #include "simulators/sim_mill.h"
 #include "backend/toolpath_generation.h"
 
 namespace gca {
 
+  // Limits for picking feeds from a material removal simulation.
+  // Each cut runs at the fastest feed that keeps its spindle power
+  // at or below target_load*machine_hp, and never faster than
+  // max_feed_scale times the feed it was planned with or than the
+  // axis feed limits of the machine allow along it. The default scale
+  // of 1 only slows cuts down, with a larger one cuts that remove
+  // little or no material speed up to those limits
+  struct feed_optimization_params {
+    double machine_hp;
+
+    // Spindle power per cubic inch per minute removed
+    double material_unit_hp;
+
+    double target_load;
+    double max_feed_scale;
+
+    // Inches per minute, unlimited unless a machine is given
+    point max_axis_feed;
+
+    // Linear cuts longer than this are split so the feed can change
+    // along them
+    double max_segment_length;
+
+    double resolution;
+
+    feed_optimization_params(const double p_machine_hp,
+			     const double p_material_unit_hp)
+      : machine_hp(p_machine_hp),
+	material_unit_hp(p_material_unit_hp),
+	target_load(0.8),
+	max_feed_scale(1.0),
+	max_axis_feed(std::numeric_limits<double>::infinity(),
+		      std::numeric_limits<double>::infinity(),
+		      std::numeric_limits<double>::infinity()),
+	max_segment_length(0.25),
+	resolution(0.01) {}
+
+    feed_optimization_params(const double p_machine_hp,
+			     const double p_material_unit_hp,
+			     const machine_profile& m)
+      : feed_optimization_params(p_machine_hp, p_material_unit_hp) {
+      max_axis_feed = m.max_axis_feed;
+    }
+  };
+
   class region bounding_region(const flat_region& mregion);
 
+  // Height field of the top of stock, columns outside of it hold
+  // no material
+  class region stock_region(const triangular_mesh& stock,
+			    const double resolution);
+
+  // Removes the material under every cut of tp from sim_region and
+  // returns tp with per cut feeds set from the volume each one removed
+  toolpath optimize_feedrates_by_MRR_simulation(class region& sim_region,
+						const toolpath& tp,
+						const feed_optimization_params& params);
+
+  void optimize_feedrates_by_MRR_simulation(const flat_region& r,
+					    std::vector<toolpath>& toolpaths,
+					    const feed_optimization_params& params);
+
   void optimize_feedrates_by_MRR_simulation(const flat_region& r,
 					    std::vector<toolpath>& toolpaths,
 					    const double machine_hp,
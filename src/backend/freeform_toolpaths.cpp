@@ -1,7 +1,7 @@
 #include "backend/freeform_toolpaths.h"
 
-#include <opencamlib/pathdropcutter.hpp>
-#include <opencamlib/batchdropcutter.hpp>
+#include <map>
+
 #include <opencamlib/ballcutter.hpp>
 #include <opencamlib/cylcutter.hpp>
 #include <opencamlib/waterline.hpp>
@@ -9,10 +9,30 @@
 #include "geometry/offset.h"
 #include "geometry/triangular_mesh_utils.h"
 #include "geometry/vtk_debug.h"
+#include "backend/arc_fitting.h"
+#include "backend/drop_cutter.h"
 #include "backend/toolpath_generation.h"
+#include "backend/toolpath_linking.h"
+#include "utils/log.h"
 
 namespace gca {
 
+  // Spacing of the samples along each zig line, the finest step
+  // adaptive dropping will refine to
+  static const double zig_sample_step = 0.01;
+
+  // Freeform zigs are first dropped at this fraction of the cutter
+  // diameter and refined until they are within the drop tolerance
+  static const double freeform_coarse_step_fraction = 0.25;
+
+  // Largest distance of a fitted freeform path from the dropped
+  // cutter surface. Dropping and arc fitting each deviate from their
+  // input and the errors add up, so each gets half
+  static const double freeform_chord_tolerance = 0.0005;
+  static const double freeform_drop_tolerance = 0.5*freeform_chord_tolerance;
+  static const double freeform_arc_tolerance =
+    freeform_chord_tolerance - freeform_drop_tolerance;
+
   std::vector<polyline>
   zig_lines_sampled_x(const polygon_3& bound,
 		      const std::vector<polygon_3>& holes,
@@ -24,11 +44,11 @@ namespace gca {
     DBG_ASSERT(stepover_fraction <= 0.5);
 
     box b = bounding_box(bound);
-    cout << "Zig lines bounding box = " << endl << b << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "Zig lines bounding box = " << b);
     double stepover = stepover_fraction*t.diameter();
 
     vector<polyline> lines;
-    double x_stepover = 0.01;
+    double x_stepover = zig_sample_step;
 
     double current_y = b.y_min;
 
@@ -46,11 +66,11 @@ namespace gca {
       current_y += stepover;
     }
 
-    cout << "# of lines = " << lines.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines = " << lines.size());
 
-    lines = clip_lines(lines, bound, holes, t);
+    lines = order_lines(clip_lines(lines, bound, holes, t));
 
-    cout << "# of lines after clipping = " << lines.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines after clipping = " << lines.size());
 
     return lines;
   }
@@ -66,11 +86,11 @@ namespace gca {
     DBG_ASSERT(stepover_fraction <= 0.5);
 
     box b = bounding_box(bound);
-    cout << "Zig lines bounding box = " << endl << b << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "Zig lines bounding box = " << b);
     double stepover = stepover_fraction*t.diameter();
 
     vector<polyline> lines;
-    double y_stepover = 0.01;
+    double y_stepover = zig_sample_step;
 
     double current_x = b.x_min;
 
@@ -88,11 +108,11 @@ namespace gca {
       current_x += stepover;
     }
 
-    cout << "# of lines = " << lines.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines = " << lines.size());
 
-    lines = clip_lines(lines, bound, holes, t);
+    lines = order_lines(clip_lines(lines, bound, holes, t));
 
-    cout << "# of lines after clipping = " << lines.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines after clipping = " << lines.size());
 
     return lines;
   }
@@ -102,44 +122,8 @@ namespace gca {
 		const std::vector<triangle>& triangles,
 		const polyline& init_line,
 		const tool& t) {
-
-    ocl::STLSurf surf;
-    for (auto t : triangles) {
-      surf.addTriangle(ocl::Triangle(ocl::Point(t.v1.x, t.v1.y, t.v1.z),
-				     ocl::Point(t.v2.x, t.v2.y, t.v2.z),
-				     ocl::Point(t.v3.x, t.v3.y, t.v3.z)));
-
-    }
-
-    ocl::BatchDropCutter pdc;
-    for (auto& p : init_line) {
-      ocl::CLPoint cl_pt(p.x, p.y, z_min);
-      pdc.appendPoint(cl_pt);
-    }
-
-    pdc.setSTL(surf);
-
-    if (t.type() == BALL_NOSE) {
-      ocl::BallCutter ballCut(t.cut_diameter(), t.cut_length());
-      pdc.setCutter(&ballCut);
-    } else if (t.type() == FLAT_NOSE) {
-      ocl::CylCutter millCut(t.cut_diameter(), t.cut_length());
-      pdc.setCutter(&millCut);
-    }
-  
-    pdc.run();
-
-    vector<point> final_pts;
-
-    auto pts = pdc.getCLPoints();
-    std::cout << "# of clpoints = " << pts.size() << std::endl;
-    //    for (auto pt : pts) {
-    for (unsigned i = 0; i < pts.size(); i++) {
-      auto pt = pts[i];
-      final_pts.push_back(point(pt.x, pt.y, pt.z));
-    }
-    
-    return final_pts;
+    drop_cutter cutter(triangles);
+    return cutter.drop(std::vector<polyline>{init_line}, t, z_min).front();
   }
   
   polyline
@@ -147,8 +131,8 @@ namespace gca {
 		const triangular_mesh& mesh,
 		const polyline& init_line,
 		const tool& t) {
-    
-    return drop_polyline(z_min, mesh.triangle_list(), init_line, t);
+    drop_cutter cutter(mesh);
+    return cutter.drop(std::vector<polyline>{init_line}, t, z_min).front();
   }
   
   std::vector<polyline>
@@ -156,58 +140,139 @@ namespace gca {
 		 const triangular_mesh& mesh,
 		 const vector<polyline>& init_lines,
 		 const tool& t) {
+    drop_cutter cutter(mesh);
+    return cutter.drop(init_lines, t, z_min);
+  }
 
-    ocl::STLSurf surf;
-    for (auto t : mesh.triangle_list()) {
-      surf.addTriangle(ocl::Triangle(ocl::Point(t.v1.x, t.v1.y, t.v1.z),
-				     ocl::Point(t.v2.x, t.v2.y, t.v2.z),
-				     ocl::Point(t.v3.x, t.v3.y, t.v3.z)));
+  struct sample_span {
+    unsigned line, start, end;
+  };
 
+  // Each round of midpoints is dropped in one batch
+  std::vector<polyline>
+  adaptive_drop_polylines(const double z_min,
+			  const drop_cutter& cutter,
+			  const std::vector<polyline>& init_lines,
+			  const tool& t,
+			  const double coarse_step,
+			  const double chord_tolerance) {
+    DBG_ASSERT(coarse_step > 0.0);
+    DBG_ASSERT(chord_tolerance > 0.0);
+
+    vector<vector<point>> samples;
+    unsigned num_samples = 0;
+    for (auto& init_line : init_lines) {
+      samples.push_back(vector<point>(begin(init_line), end(init_line)));
+      num_samples += samples.back().size();
     }
 
-    ocl::BatchDropCutter pdc;
-    for (auto& init_line : init_lines) {
-      for (auto& p : init_line) {
-	ocl::CLPoint cl_pt(p.x, p.y, z_min);
-	pdc.appendPoint(cl_pt);
+    if (num_samples == 0) { return {}; }
+
+    // Heights of the samples kept so far in each line, by index
+    vector<map<unsigned, double>> heights(samples.size());
+
+    auto drop_samples = [&](const vector<pair<unsigned, unsigned>>& to_drop) {
+      vector<point> pts;
+      for (auto& s : to_drop) {
+	pts.push_back(samples[s.first][s.second]);
       }
-    }
 
-    pdc.setSTL(surf);
+      vector<point> dropped = cutter.drop(pts, t, z_min);
+      for (unsigned i = 0; i < to_drop.size(); i++) {
+	heights[to_drop[i].first][to_drop[i].second] = dropped[i].z;
+      }
+    };
+
+    vector<pair<unsigned, unsigned>> to_drop;
+    vector<sample_span> spans;
+    for (unsigned i = 0; i < samples.size(); i++) {
+      unsigned n = samples[i].size();
+      if (n == 0) { continue; }
+
+      unsigned stride = 1;
+      if (n > 1) {
+	double spacing = (samples[i][1] - samples[i][0]).len();
+	if (spacing > 0.0) {
+	  stride = max(1u, static_cast<unsigned>(coarse_step / spacing));
+	}
+      }
 
-    if (t.type() == BALL_NOSE) {
-      ocl::BallCutter ballCut(t.cut_diameter(), t.cut_length());
-      pdc.setCutter(&ballCut);
-    } else if (t.type() == FLAT_NOSE) {
-      ocl::CylCutter millCut(t.cut_diameter(), t.cut_length());
-      pdc.setCutter(&millCut);
+      unsigned last = 0;
+      to_drop.push_back(make_pair(i, 0u));
+      for (unsigned j = stride; j < n + stride - 1; j += stride) {
+	unsigned next = min(j, n - 1);
+	to_drop.push_back(make_pair(i, next));
+	if (next - last > 1) {
+	  spans.push_back({i, last, next});
+	}
+	last = next;
+      }
     }
-  
-    pdc.run();
 
-    vector<polyline> dropped;
+    drop_samples(to_drop);
 
-    auto pts = pdc.getCLPoints();
-    std::cout << "# of clpoints = " << pts.size() << std::endl;
+    while (spans.size() > 0) {
+      to_drop.clear();
+      for (auto& s : spans) {
+	to_drop.push_back(make_pair(s.line, (s.start + s.end) / 2));
+      }
 
-    unsigned total = 0;
-    for (unsigned i = 0; i < init_lines.size(); i++) {
-      vector<point> final_pts;
+      drop_samples(to_drop);
+
+      vector<sample_span> next_spans;
+      for (auto& s : spans) {
+	unsigned mid = (s.start + s.end) / 2;
 
-      for (unsigned j = 0; j < init_lines[i].num_points(); j++) {
+	const vector<point>& line = samples[s.line];
+	map<unsigned, double>& hs = heights[s.line];
 
-	auto pt = pts[total];
-	final_pts.push_back(point(pt.x, pt.y, pt.z));
+	double z_start = hs[s.start];
+	double z_end = hs[s.end];
+	double frac = (line[mid] - line[s.start]).len() /
+	  (line[s.end] - line[s.start]).len();
+	double chord_z = z_start + frac*(z_end - z_start);
 
-	total++;
+	if (fabs(hs[mid] - chord_z) > chord_tolerance) {
+	  if (mid - s.start > 1) { next_spans.push_back({s.line, s.start, mid}); }
+	  if (s.end - mid > 1) { next_spans.push_back({s.line, mid, s.end}); }
+	} else {
+	  hs.erase(mid);
+	}
       }
 
-      dropped.push_back(polyline(final_pts));
+      spans = next_spans;
+    }
 
+    vector<polyline> dropped;
+    for (unsigned i = 0; i < samples.size(); i++) {
+      vector<point> final_pts;
+      for (auto& h : heights[i]) {
+	point p = samples[i][h.first];
+	final_pts.push_back(point(p.x, p.y, h.second));
+      }
+      dropped.push_back(polyline(final_pts));
     }
-    
+
     return dropped;
+  }
 
+  static vector<polyline>
+  dropped_zig_lines(const polygon_3& surface_bound,
+		    const drop_cutter& cutter,
+		    const tool& t,
+		    const double z_min,
+		    const double stepover_fraction) {
+    vector<polyline> init_lines =
+      zig_lines_sampled_y(surface_bound, {}, t, stepover_fraction);
+    vector<polyline> lines =
+      adaptive_drop_polylines(z_min,
+			      cutter,
+			      init_lines,
+			      t,
+			      freeform_coarse_step_fraction*t.cut_diameter(),
+			      freeform_drop_tolerance);
+
+    return lines;
   }
 
   vector<polyline>
@@ -217,11 +282,22 @@ namespace gca {
 	       const double safe_z,
 	       const double z_min,
 	       const double stepover_fraction) {
-    vector<polyline> init_lines =
-      zig_lines_sampled_y(surface_bound, {}, t, stepover_fraction);
-    vector<polyline> lines = drop_polylines(z_min, mesh, init_lines, t);
+    drop_cutter cutter(mesh);
+    return dropped_zig_lines(surface_bound, cutter, t, z_min, stepover_fraction);
+  }
 
-    return lines;
+  static polygon_3
+  freeform_surface_bound(const std::vector<index_t>& inds,
+			 const triangular_mesh& mesh) {
+    vector<polygon_3> polys = surface_boundary_polygons(inds, mesh);
+
+    DBG_ASSERT(polys.size() == 1);
+
+    polygon_3 surface_bound = polys.front();
+
+    DBG_ASSERT(surface_bound.holes().size() == 0);
+
+    return surface_bound;
   }
   
   vector<polyline>
@@ -241,16 +317,7 @@ namespace gca {
     //   rings.push_back(b.vertices());
     // }
 
-    vector<polygon_3> polys =
-      surface_boundary_polygons(inds, mesh); //arrange_rings(rings);
-
-    //vtk_debug_polygons(polys);
-
-    DBG_ASSERT(polys.size() == 1);
-
-    polygon_3 surface_bound = polys.front();
-
-    DBG_ASSERT(surface_bound.holes().size() == 0);
+    polygon_3 surface_bound = freeform_surface_bound(inds, mesh);
 
     return freeform_zig(surface_bound, mesh, t, safe_z, z_min, stepover_fraction);
     
@@ -289,12 +356,9 @@ namespace gca {
     // DBG_ASSERT(surface_bound.holes().size() == 0);
 
     polygon_3 surface_bound = box_bound(mesh);
-    
-    vector<polyline> init_lines =
-      zig_lines_sampled_y(surface_bound, {}, t, stepover_fraction);
-    vector<polyline> lines = drop_polylines(z_min, mesh, init_lines, t);
 
-    return lines;
+    drop_cutter cutter(mesh);
+    return dropped_zig_lines(surface_bound, cutter, t, z_min, stepover_fraction);
   }
   
   toolpath
@@ -308,13 +372,16 @@ namespace gca {
     vector<polyline> lines =
       freeform_zig(inds, mesh, t, safe_z, z_min, stepover_fraction);
 
-    return {toolpath(FREEFORM_POCKET,
-		     safe_z,
-		     2000,
-		     15.0,
-		     7.5,
-		     t,
-		     lines)};
+    // Dropped lines are dense enough to overrun the controller's
+    // block rate at full feed
+    return fit_arcs(toolpath(FREEFORM_POCKET,
+			     safe_z,
+			     2000,
+			     15.0,
+			     7.5,
+			     t,
+			     lines),
+		    freeform_arc_tolerance);
   }
 
   toolpath
@@ -335,33 +402,46 @@ namespace gca {
     double end_depth = min_in_dir(surf, up);
 
 
-    cout << "Start depth = " << start_depth << endl;
-    cout << "End depth   = " << end_depth << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "Start depth = " << start_depth);
+    GCA_LOG_DEBUG(BACKEND_LOG, "End depth   = " << end_depth);
 
     double cut_depth = depth_fraction*t.diameter();
     vector<double> depths = cut_depths(start_depth, end_depth, cut_depth);
 
-    cout << "# of depths = " << depths.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of depths = " << depths.size());
     for (auto d : depths) {
-      cout << d << endl;
+      GCA_LOG_DEBUG(BACKEND_LOG, d);
     }
 
     //vtk_debug_highlight_inds(surf);
     
     DBG_ASSERT(depths.size() > 0);
 
+    // The clipped zig lines and the cutter's index of the mesh are
+    // the same at every depth, only the drop floor changes
+    polygon_3 surface_bound = freeform_surface_bound(inds, mesh);
+    drop_cutter cutter(mesh);
+    vector<polyline> init_lines =
+      zig_lines_sampled_y(surface_bound, {}, t, stepover_fraction);
+
     vector<polyline> lines;
     for (auto depth : depths) {
-      concat(lines, freeform_zig(inds, mesh, t, safe_z, depth, stepover_fraction));
+      concat(lines, adaptive_drop_polylines(depth,
+					    cutter,
+					    init_lines,
+					    t,
+					    freeform_coarse_step_fraction*t.cut_diameter(),
+					    freeform_drop_tolerance));
     }
 
-    return {toolpath(FREEFORM_POCKET,
-		     safe_z,
-		     2000,
-		     15.0,
-		     7.5,
-		     t,
-		     lines)};
+    return fit_arcs(toolpath(FREEFORM_POCKET,
+			     safe_z,
+			     2000,
+			     15.0,
+			     7.5,
+			     t,
+			     lines),
+		    freeform_arc_tolerance);
   }
 
   std::vector<polyline>
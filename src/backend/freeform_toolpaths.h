@@ -1,5 +1,6 @@
 #pragma once
 
+#include "backend/drop_cutter.h"
 #include "backend/operation.h"
 #include "geometry/surface.h"
 #include "backend/toolpath.h"
@@ -81,6 +82,19 @@ namespace gca {
 	       const double z_min,
 	       const double stepover_fraction);
 
+  // Drops the samples of each line coarsely first, then keeps
+  // bisecting the spans between dropped samples whose midpoint
+  // height deviates from the chord between the ends by more than
+  // chord_tolerance. Flat stretches end up as a single segment,
+  // curved ones are refined down to the original sample spacing
+  std::vector<polyline>
+  adaptive_drop_polylines(const double z_min,
+			  const drop_cutter& cutter,
+			  const std::vector<polyline>& init_lines,
+			  const tool& t,
+			  const double coarse_step,
+			  const double chord_tolerance);
+
   vector<polyline> waterline(const triangular_mesh& part,
 			     const tool& t,
 			     const double z_min,
@@ -252,4 +252,77 @@ namespace gca {
     return blks;
   }
   
+  post_processor emco_f1_post() {
+    return post_processor{EMCO_F1, true, false, true};
+  }
+
+  post_processor emco_f1_no_TLC_post() {
+    return post_processor{EMCO_F1, true, false, false};
+  }
+
+  post_processor emco_f1_G10_TLC_post() {
+    return post_processor{EMCO_F1, true, true, false};
+  }
+
+  post_processor wells_no_TLC_post() {
+    return post_processor{WELLS, false, false, false};
+  }
+
+  void write_toolpath_gcode(const toolpath& tp,
+			    const post_processor& post,
+			    gcode_writer& w) {
+    cut_params params;
+    params.target_machine = post.target_machine;
+    params.safe_height = tp.safe_z_before_tlc;
+    if (post.safe_height_above_tool) {
+      params.safe_height += tp.t.length();
+    }
+    params.set_plunge_feed(tp.plunge_feedrate);
+
+    w.write(comment_prefix(tp, params));
+    if (post.g10_tool_length_offset) {
+      w.write(g10_TLC_prefix(tp));
+    }
+
+    w.word('G', 90);
+    w.end_block();
+    write_cuts_gcode(tp.contiguous_cuts(params), params, post.reflect_x, w);
+  }
+
+  void write_gcode_program(const std::vector<toolpath>& toolpaths,
+			   const post_processor& post,
+			   gcode_writer& w) {
+    for (auto& tp : toolpaths) {
+      write_toolpath_gcode(tp, post, w);
+    }
+
+    w.word('M', 2);
+    w.end_block();
+  }
+
+  void write_camaster_program(const std::vector<toolpath>& toolpaths,
+			      gcode_writer& w) {
+    if (toolpaths.size() == 0) { return; }
+
+    w.write(camaster_prefix_blocks(toolpaths.front()));
+
+    for (unsigned i = 1; i < toolpaths.size(); i++) {
+      const toolpath& tp = toolpaths[i];
+
+      cut_params params;
+      params.target_machine = CAMASTER;
+      params.safe_height = tp.safe_z_before_tlc;
+      params.set_plunge_feed(tp.plunge_feedrate);
+
+      w.write(camaster_comment_prefix(tp, params));
+      w.write(camaster_tool_change_block(tp.tool_number()));
+
+      w.word('G', 90);
+      w.end_block();
+      write_cuts_gcode(tp.contiguous_cuts(params), params, false, w);
+    }
+
+    w.write(camaster_suffix_blocks());
+  }
+
 }
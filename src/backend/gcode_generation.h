@@ -3,6 +3,7 @@
 
 #include "gcode/cut.h"
 #include "gcode/gcode_program.h"
+#include "gcode/gcode_writer.h"
 #include "geometry/polyline.h"
 #include "backend/cut_params.h"
 #include "backend/shapes_to_gcode.h"
@@ -61,6 +62,37 @@ namespace gca {
     return gcode_program(program_name, blocks);
   }
 
+  // Output conventions of one machine's program template, used to
+  // stream programs through a gcode_writer without building blocks
+  struct post_processor {
+    machine_name target_machine;
+    bool reflect_x;
+    bool g10_tool_length_offset;
+    bool safe_height_above_tool;
+  };
+
+  // Same output as emco_f1_code, emco_f1_code_no_TLC,
+  // emco_f1_code_G10_TLC and wells_code_no_TLC
+  post_processor emco_f1_post();
+  post_processor emco_f1_no_TLC_post();
+  post_processor emco_f1_G10_TLC_post();
+  post_processor wells_no_TLC_post();
+
+  void write_toolpath_gcode(const toolpath& tp,
+			    const post_processor& post,
+			    gcode_writer& w);
+
+  // Writes the same text as printing the blocks of
+  // build_gcode_program(name, toolpaths, f) for the matching f
+  void write_gcode_program(const std::vector<toolpath>& toolpaths,
+			   const post_processor& post,
+			   gcode_writer& w);
+
+  // Streaming version of build_gcode_program with camaster_prefix_blocks,
+  // camaster_suffix_blocks and camaster_engraving
+  void write_camaster_program(const std::vector<toolpath>& toolpaths,
+			      gcode_writer& w);
+
   std::vector<cut*> polylines_to_cuts(const vector<polyline>& pocket_lines,
 				      const int tool_number,
 				      const cut_params params,
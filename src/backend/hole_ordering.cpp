@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+#include "backend/hole_ordering.h"
+#include "geometry/box.h"
+#include "utils/algorithm.h"
+
+namespace gca {
+
+  // Sites are snapped to a grid of this many cells per side to
+  // compute their position along the Hilbert curve
+  static const uint32_t hilbert_side = 1 << 16;
+
+  static const unsigned num_neighbors = 8;
+  static const unsigned max_improvement_passes = 8;
+
+  // Longest run of the tour a single move may reverse or shift, keeps
+  // the cost of each applied move bounded on very large inputs
+  static const unsigned max_move_span = 50000;
+
+  static inline double site_distance(const point a, const point b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    return sqrt(dx*dx + dy*dy);
+  }
+
+  static uint64_t hilbert_index(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = hilbert_side / 2; s > 0; s /= 2) {
+      uint32_t rx = (x & s) > 0;
+      uint32_t ry = (y & s) > 0;
+      d += uint64_t(s)*s*((3*rx) ^ ry);
+
+      if (ry == 0) {
+	if (rx == 1) {
+	  x = hilbert_side - 1 - x;
+	  y = hilbert_side - 1 - y;
+	}
+	std::swap(x, y);
+      }
+    }
+    return d;
+  }
+
+  static std::vector<unsigned>
+  hilbert_order(const std::vector<point>& sites, const box b) {
+    double x_len = std::max(b.x_len(), 1e-12);
+    double y_len = std::max(b.y_len(), 1e-12);
+    double len = std::max(x_len, y_len);
+
+    std::vector<uint64_t> keys;
+    for (auto& p : sites) {
+      uint32_t x = static_cast<uint32_t>(((p.x - b.x_min) / len)*(hilbert_side - 1));
+      uint32_t y = static_cast<uint32_t>(((p.y - b.y_min) / len)*(hilbert_side - 1));
+      keys.push_back(hilbert_index(x, y));
+    }
+
+    std::vector<unsigned> order(sites.size());
+    std::iota(begin(order), end(order), 0);
+    std::stable_sort(begin(order), end(order), [&keys](const unsigned l, const unsigned r) {
+	return keys[l] < keys[r];
+      });
+    return order;
+  }
+
+  // The k nearest other sites of every site, found by searching rings
+  // of grid cells outward until no closer site can remain
+  static std::vector<std::vector<unsigned>>
+  nearest_sites(const std::vector<point>& sites, const box b, const unsigned k) {
+    unsigned n = sites.size();
+    int cells_per_side = std::max(1, static_cast<int>(sqrt(n / 2.0)));
+    int nx = b.x_len() > 0.0 ? cells_per_side : 1;
+    int ny = b.y_len() > 0.0 ? cells_per_side : 1;
+    double cell_x = b.x_len() > 0.0 ? b.x_len() / nx : 1.0;
+    double cell_y = b.y_len() > 0.0 ? b.y_len() / ny : 1.0;
+
+    auto cell_of = [&](const point p, int* ix, int* iy) {
+      *ix = std::min(nx - 1, static_cast<int>((p.x - b.x_min) / cell_x));
+      *iy = std::min(ny - 1, static_cast<int>((p.y - b.y_min) / cell_y));
+    };
+
+    std::vector<std::vector<unsigned>> cells(nx*ny);
+    for (unsigned i = 0; i < n; i++) {
+      int ix, iy;
+      cell_of(sites[i], &ix, &iy);
+      cells[ix*ny + iy].push_back(i);
+    }
+
+    double min_cell = std::min(nx > 1 ? cell_x : cell_y, ny > 1 ? cell_y : cell_x);
+    int max_ring = std::max(nx, ny);
+
+    std::vector<std::vector<unsigned>> neighbors(n);
+    std::vector<std::pair<double, unsigned>> candidates;
+    for (unsigned i = 0; i < n; i++) {
+      int cx, cy;
+      cell_of(sites[i], &cx, &cy);
+
+      candidates.clear();
+      for (int r = 0; r <= max_ring; r++) {
+	for (int ix = cx - r; ix <= cx + r; ix++) {
+	  for (int iy = cy - r; iy <= cy + r; iy++) {
+	    bool on_ring = ix == cx - r || ix == cx + r || iy == cy - r || iy == cy + r;
+	    if (!on_ring || ix < 0 || iy < 0 || ix >= nx || iy >= ny) { continue; }
+
+	    for (auto j : cells[ix*ny + iy]) {
+	      if (j == i) { continue; }
+	      candidates.push_back(std::make_pair(site_distance(sites[i], sites[j]), j));
+	    }
+	  }
+	}
+
+	// Sites in later rings are at least r cells away
+	if (candidates.size() >= k) {
+	  std::nth_element(begin(candidates), begin(candidates) + k - 1, end(candidates));
+	  if ((candidates[k - 1].first) <= r*min_cell) { break; }
+	}
+      }
+
+      unsigned num = std::min(k, static_cast<unsigned>(candidates.size()));
+      std::partial_sort(begin(candidates), begin(candidates) + num, end(candidates));
+      for (unsigned c = 0; c < num; c++) {
+	neighbors[i].push_back(candidates[c].second);
+      }
+    }
+
+    return neighbors;
+  }
+
+  class hole_tour {
+  protected:
+    const std::vector<point>& sites;
+    std::vector<unsigned> tour;
+    std::vector<unsigned> pos;
+
+    inline double d(const unsigned i, const unsigned j) const
+    { return site_distance(sites[tour[i]], sites[tour[j]]); }
+
+    inline unsigned size() const { return tour.size(); }
+
+    void update_positions(const unsigned start, const unsigned end) {
+      for (unsigned i = start; i < end; i++) {
+	pos[tour[i]] = i;
+      }
+    }
+
+  public:
+    hole_tour(const std::vector<point>& p_sites,
+	      const std::vector<unsigned>& p_tour) :
+      sites(p_sites), tour(p_tour), pos(p_tour.size()) {
+      update_positions(0, size());
+    }
+
+    const std::vector<unsigned>& order() const { return tour; }
+
+    // Reverses tour[lo + 1 .. hi] if that shortens the path
+    bool try_two_opt(const unsigned lo, const unsigned hi) {
+      if (hi <= lo + 1 || hi - lo > max_move_span) { return false; }
+
+      double before = d(lo, lo + 1);
+      double after = d(lo, hi);
+      if (hi + 1 < size()) {
+	before += d(hi, hi + 1);
+	after += d(lo + 1, hi + 1);
+      }
+
+      if (!(after < before - 1e-12)) { return false; }
+
+      std::reverse(begin(tour) + lo + 1, begin(tour) + hi + 1);
+      update_positions(lo + 1, hi + 1);
+      return true;
+    }
+
+    // Moves the run of len sites starting at s so that it follows the
+    // site at position j, reversed if that is shorter
+    bool try_or_opt(const unsigned s, const unsigned len, const unsigned j) {
+      unsigned e = s + len - 1;
+      if (e >= size()) { return false; }
+      if (j + 1 >= s && j <= e) { return false; }
+      if ((j > e ? j - s : e - j) > max_move_span) { return false; }
+
+      double removed = 0.0;
+      double added = 0.0;
+      if (s > 0) { removed += d(s - 1, s); }
+      if (e + 1 < size()) { removed += d(e, e + 1); }
+      if (s > 0 && e + 1 < size()) { added += d(s - 1, e + 1); }
+
+      removed += j + 1 < size() ? d(j, j + 1) : 0.0;
+
+      double forward = d(j, s) + (j + 1 < size() ? d(e, j + 1) : 0.0);
+      double backward = d(j, e) + (j + 1 < size() ? d(s, j + 1) : 0.0);
+      bool reversed = backward < forward;
+      added += std::min(forward, backward);
+
+      if (!(added < removed - 1e-12)) { return false; }
+
+      if (reversed) {
+	std::reverse(begin(tour) + s, begin(tour) + e + 1);
+      }
+
+      if (j > e) {
+	std::rotate(begin(tour) + s, begin(tour) + e + 1, begin(tour) + j + 1);
+	update_positions(s, j + 1);
+      } else {
+	std::rotate(begin(tour) + j + 1, begin(tour) + s, begin(tour) + e + 1);
+	update_positions(j + 1, e + 1);
+      }
+      return true;
+    }
+
+    bool improve(const std::vector<std::vector<unsigned>>& neighbors) {
+      bool improved = false;
+
+      for (unsigned i = 0; i + 1 < size(); i++) {
+	for (auto c : neighbors[tour[i]]) {
+	  unsigned j = pos[c];
+	  bool moved = i < j ? try_two_opt(i, j) : try_two_opt(j, i);
+	  if (moved) {
+	    improved = true;
+	    break;
+	  }
+	}
+      }
+
+      for (unsigned len = 1; len <= 3; len++) {
+	for (unsigned s = 0; s + len <= size(); s++) {
+	  for (auto c : neighbors[tour[s]]) {
+	    unsigned j = pos[c];
+	    // Place the run after c or just before it
+	    if (try_or_opt(s, len, j) || (j > 0 && try_or_opt(s, len, j - 1))) {
+	      improved = true;
+	      break;
+	    }
+	  }
+	}
+      }
+
+      return improved;
+    }
+  };
+
+  std::vector<unsigned> hole_visit_order(const std::vector<point>& sites) {
+    std::vector<unsigned> order(sites.size());
+    std::iota(begin(order), end(order), 0);
+
+    if (sites.size() < 3) { return order; }
+
+    box b = bound_positions(sites);
+
+    hole_tour tour(sites, hilbert_order(sites, b));
+    std::vector<std::vector<unsigned>> neighbors =
+      nearest_sites(sites, b, std::min(num_neighbors, static_cast<unsigned>(sites.size() - 1)));
+
+    for (unsigned pass = 0; pass < max_improvement_passes; pass++) {
+      if (!tour.improve(neighbors)) { break; }
+    }
+
+    return tour.order();
+  }
+
+  static std::vector<toolpath>
+  order_hole_run(const std::vector<toolpath>& run) {
+    std::vector<int> tool_numbers;
+    for (auto& tp : run) {
+      if (find(begin(tool_numbers), end(tool_numbers), tp.tool_number()) ==
+	  end(tool_numbers)) {
+	tool_numbers.push_back(tp.tool_number());
+      }
+    }
+
+    std::vector<toolpath> ordered;
+    for (auto tool_number : tool_numbers) {
+      std::vector<toolpath> same_tool;
+      std::vector<point> sites;
+      for (auto& tp : run) {
+	if (tp.tool_number() == tool_number) {
+	  same_tool.push_back(tp);
+	  sites.push_back(tp.start_location());
+	}
+      }
+
+      for (auto i : hole_visit_order(sites)) {
+	ordered.push_back(same_tool[i]);
+      }
+    }
+
+    return ordered;
+  }
+
+  std::vector<toolpath>
+  order_drilled_holes(const std::vector<toolpath>& toolpaths) {
+    std::vector<toolpath> ordered;
+    std::vector<toolpath> run;
+
+    for (auto& tp : toolpaths) {
+      if (tp.pocket_type() == DRILLED_HOLE_POCKET) {
+	run.push_back(tp);
+	continue;
+      }
+
+      concat(ordered, order_hole_run(run));
+      run.clear();
+      ordered.push_back(tp);
+    }
+
+    concat(ordered, order_hole_run(run));
+
+    return ordered;
+  }
+
+}
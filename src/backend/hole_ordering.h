@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+#include "backend/toolpath.h"
+#include "geometry/point.h"
+
+namespace gca {
+
+  // Order in which to visit sites so that the rapids between them
+  // are short, as indexes into sites. Only x and y are used. Sites
+  // are seeded in Hilbert curve order and then refined with 2-opt and
+  // Or-opt moves between near neighbours, so large hole patterns are
+  // ordered in roughly O(n log n)
+  std::vector<unsigned> hole_visit_order(const std::vector<point>& sites);
+
+  // Reorders every run of consecutive drilled hole toolpaths. Within
+  // a run the holes for each tool are ordered together, and the tools
+  // are used in the order they first appear
+  std::vector<toolpath>
+  order_drilled_holes(const std::vector<toolpath>& toolpaths);
+
+}
@@ -8,9 +8,20 @@
 
 namespace gca {
 
+  // Moves from the end of last_cut to the start of next_cut, last_cut
+  // is NULL before the first cut
+  vector<cut*> move_to_next_cut(cut* last_cut,
+				cut* next_cut,
+				const cut_params& params);
+
+  void insert_move_home(vector<cut*>& cuts,
+			const cut_params& params);
+
   vector<cut*> insert_transitions(const vector<cut*>& cuts,
 				  const cut_params& params);
 
+  vector<cut*> shift_cuts(const vector<cut*>& cuts, point p);
+
   void set_feedrates(vector<cut*>& cuts,
 		     const cut_params& params);
 
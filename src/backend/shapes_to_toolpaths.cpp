@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <numeric>
 
+#include "geometry/endpoint_hash.h"
 #include "geometry/polyline.h"
 #include "gcode/circular_arc.h"
 #include "gcode/linear_cut.h"
@@ -58,19 +59,6 @@ namespace gca {
     }
   }
 
-  vector<point> cuts_to_points(vector<cut*> cuts) {
-    vector<point> pts;
-    for (auto c : cuts) {
-      point s = c->get_start();
-      point e = c->get_end();
-      if (pts.size() == 0) {
-	pts.push_back(s);
-      }
-      pts.push_back(e);      
-    }
-    return pts;
-  }
-
   vector<point> lines_to_points(vector<line> cuts) {
     vector<point> pts;
     for (auto c : cuts) {
@@ -84,20 +72,26 @@ namespace gca {
     return pts;
   }
   
-  vector<polyline> make_polylines_from(vector<cut*> lines) {
-    auto adj_test = [](cut* c, cut* n) { return within_eps(c->get_end(), n->get_start()); };
-    auto not_adj_test = [](cut* c, cut* n) {
-      bool touching = within_eps(c->get_end(),n->get_start());
-      return !touching; // || !small_orientation_diff;
-    };
-    greedy_adjacent_chains(lines.begin(), lines.end(), adj_test);
+  // Lines may be drawn in any order and direction, so they are
+  // chained by their endpoints and reversed where needed
+  vector<polyline> make_polylines_from(const vector<cut*>& lines) {
+    vector<pair<point, point>> segments;
+    for (auto c : lines) {
+      segments.push_back(make_pair(c->get_start(), c->get_end()));
+    }
+
     vector<polyline> pls;
-    auto it = lines.begin();
-    while (it != lines.end()) {
-      auto r = find_between(it, lines.end(), not_adj_test);
-      vector<point> lts = cuts_to_points(vector<cut*>(it, r.first + 1));
-      pls.push_back(polyline(lts));
-      it = r.second;
+    for (auto& chain : chain_segments(segments, 0.0000001, true)) {
+      vector<point> pts;
+      for (auto l : chain.links) {
+	point s = l.reversed ? segments[l.index].second : segments[l.index].first;
+	point e = l.reversed ? segments[l.index].first : segments[l.index].second;
+	if (pts.size() == 0) {
+	  pts.push_back(s);
+	}
+	pts.push_back(e);
+      }
+      pls.push_back(polyline(pts));
     }
     return pls;
   }
@@ -1,5 +1,8 @@
 #include <cmath>
+#include <functional>
+#include <numeric>
 
+#include "backend/drop_cutter.h"
 #include "backend/face_toolpaths.h"
 #include "backend/feedrate_optimization.h"
 #include "feature_recognition/feature_decomposition.h"
@@ -14,10 +17,38 @@
 #include "backend/shape_layout.h"
 #include "backend/shapes_to_gcode.h"
 #include "backend/toolpath_generation.h"
+#include "backend/toolpath_linking.h"
 #include "utils/algorithm.h"
+#include "utils/arena_allocator.h"
+#include "utils/log.h"
+#include "utils/parallel.h"
 
 namespace gca {
 
+  static bool parallel_generation = false;
+
+  void set_parallel_toolpath_generation(const bool parallel) {
+    parallel_generation = parallel;
+  }
+
+  bool parallel_toolpath_generation() { return parallel_generation; }
+
+  // Runs independent passes of one pocket, in parallel if the
+  // parallel mode is on. Results are in the order of passes
+  static std::vector<toolpath>
+  generate_passes(const std::vector<std::function<toolpath()>>& passes) {
+    if (!parallel_toolpath_generation()) {
+      vector<toolpath> tps;
+      for (auto& p : passes) { tps.push_back(p()); }
+      return tps;
+    }
+
+    return parallel_map_with_arenas(passes,
+				    [](const std::function<toolpath()>& p) {
+				      return p();
+				    });
+  }
+
   struct cut_move_parameters {
     double feed;
     double plunge_feed;
@@ -45,7 +76,7 @@ namespace gca {
       feed = 30.0;
     }
     
-    cout << "Chip Load Per Tooth = " << chip_load_per_tooth(t, feed, speed) << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "Chip Load Per Tooth = " << chip_load_per_tooth(t, feed, speed));
 
     return cut_move_parameters{feed, feed / t.num_flutes(), speed, cut_depth};
   }
@@ -69,7 +100,7 @@ namespace gca {
       DBG_ASSERT(false);
     }
 
-    cout << "Chip Load Per Tooth = " << chip_load_per_tooth(t, feed, speed) << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "Chip Load Per Tooth = " << chip_load_per_tooth(t, feed, speed));
 
     return cut_move_parameters{feed, feed / t.num_flutes(), speed, cut_depth};
   }
@@ -194,13 +225,6 @@ namespace gca {
       DBG_ASSERT((rough_start - rough_end) > 0.0);
     }
 
-    toolpath rough_tp = rough_face(rough_params,
-				   safe_z,
-				   rough_start,
-				   rough_end,
-				   build_clean_polygon_3(base.vertices()),
-				   t);
-
     double finish_feedrate = 15.0;
     double finish_spindle_speed = 2500;
 
@@ -218,14 +242,16 @@ namespace gca {
 	finish_feedrate,
 	finish_spindle_speed};
 
-    toolpath finish_tp = rough_face(finish_params,
-				    safe_z,
-				    finish_start,
-				    finish_end,
-				    build_clean_polygon_3(base.vertices()),
-				    t);
+    polygon_3 face_area = build_clean_polygon_3(base.vertices());
 
-    return {rough_tp, finish_tp};
+    return generate_passes({
+	[&]() {
+	  return rough_face(rough_params, safe_z, rough_start, rough_end, face_area, t);
+	},
+	[&]() {
+	  return rough_face(finish_params, safe_z, finish_start, finish_end, face_area, t);
+	}
+      });
   }
   
   std::vector<toolpath>
@@ -410,10 +436,9 @@ namespace gca {
 
 	if (offset_base.holes().size() == base_poly.holes().size()) {
 
-	  cout << "Chosen tool: " << endl;
-	  cout << t << endl;
-	  cout << "Cut area    = " << area(offset_base) << endl;
-	  cout << "Pocket area = " << area(base_poly) << endl;
+	  GCA_LOG_DEBUG(BACKEND_LOG, "Chosen tool: " << t);
+	  GCA_LOG_DEBUG(BACKEND_LOG, "Cut area    = " << area(offset_base));
+	  GCA_LOG_DEBUG(BACKEND_LOG, "Pocket area = " << area(base_poly));
 
 	  return t;
 	}
@@ -559,6 +584,173 @@ namespace gca {
     return inner_bound;
   }
   
+  // Along line coordinate and constant coordinate of p for lines
+  // running along x (axis 0) or along y (axis 1)
+  static inline double scan_u(const point p, const int axis)
+  { return axis == 0 ? p.x : p.y; }
+
+  static inline double scan_v(const point p, const int axis)
+  { return axis == 0 ? p.y : p.x; }
+
+  // 0 if every point of l has the same y and x strictly increases,
+  // 1 for the same along y, -1 otherwise
+  static int scan_axis(const polyline& l) {
+    if (l.num_points() < 2) { return -1; }
+
+    for (int axis = 0; axis < 2; axis++) {
+      bool along_axis = true;
+      for (unsigned i = 1; i < l.num_points(); i++) {
+	if (scan_v(l.pt(i), axis) != scan_v(l.pt(0), axis) ||
+	    scan_u(l.pt(i), axis) <= scan_u(l.pt(i - 1), axis)) {
+	  along_axis = false;
+	  break;
+	}
+      }
+
+      if (along_axis) { return axis; }
+    }
+
+    return -1;
+  }
+
+  struct scan_edge {
+    double u_a, v_a, u_b, v_b;
+    double v_min, v_max;
+    unsigned poly;
+  };
+
+  static void add_scan_edges(const std::vector<point>& ring,
+			     const unsigned poly,
+			     const int axis,
+			     std::vector<scan_edge>& edges) {
+    for (unsigned i = 0; i < ring.size(); i++) {
+      point a = ring[i];
+      point b = ring[(i + 1) % ring.size()];
+
+      scan_edge e{scan_u(a, axis), scan_v(a, axis),
+	  scan_u(b, axis), scan_v(b, axis),
+	  0.0, 0.0, poly};
+
+      // Edges parallel to the scanlines never cross one
+      if (e.v_a == e.v_b) { continue; }
+
+      e.v_min = min(e.v_a, e.v_b);
+      e.v_max = max(e.v_a, e.v_b);
+      edges.push_back(e);
+    }
+  }
+
+  // Clips lines that all run along the same axis to the inside of
+  // bound and the outside of every hole. Edges are swept in order of
+  // the scanlines, so each line only intersects the edges that span
+  // it, and the spans of a line are read off its sorted crossings
+  static std::vector<polyline>
+  scanline_clip_lines(const std::vector<polyline>& lines,
+		      const polygon_3& bound,
+		      const std::vector<polygon_3>& hole_polys,
+		      const int axis,
+		      const double z) {
+    // Polygon 0 is the bound, holes are 1 and up. Crossing a ring of
+    // a hole, including the rings of islands inside it, toggles
+    // whether the scanline is inside that hole
+    std::vector<scan_edge> edges;
+    add_scan_edges(bound.vertices(), 0, axis, edges);
+    for (unsigned i = 0; i < hole_polys.size(); i++) {
+      add_scan_edges(hole_polys[i].vertices(), i + 1, axis, edges);
+      for (auto& h : hole_polys[i].holes()) {
+	add_scan_edges(h, i + 1, axis, edges);
+      }
+    }
+
+    sort(begin(edges), end(edges),
+	 [](const scan_edge& l, const scan_edge& r) { return l.v_min < r.v_min; });
+
+    std::vector<unsigned> line_order(lines.size());
+    std::iota(begin(line_order), end(line_order), 0);
+    sort(begin(line_order), end(line_order), [&lines, axis](const unsigned l, const unsigned r) {
+	return scan_v(lines[l].front(), axis) < scan_v(lines[r].front(), axis);
+      });
+
+    std::vector<std::vector<polyline>> clipped(lines.size());
+    std::vector<scan_edge> active;
+    std::vector<std::pair<double, unsigned>> crossings;
+    std::vector<bool> inside(hole_polys.size() + 1);
+    unsigned next_edge = 0;
+
+    for (auto li : line_order) {
+      const polyline& l = lines[li];
+      double v = scan_v(l.front(), axis);
+
+      // An edge crosses the scanline when v_min <= v < v_max, so
+      // shared vertices are only counted once
+      while (next_edge < edges.size() && edges[next_edge].v_min <= v) {
+	active.push_back(edges[next_edge]);
+	next_edge++;
+      }
+      active.erase(remove_if(begin(active), end(active),
+			     [v](const scan_edge& e) { return e.v_max <= v; }),
+		   end(active));
+
+      crossings.clear();
+      for (auto& e : active) {
+	double u = e.u_a + (v - e.v_a)*(e.u_b - e.u_a) / (e.v_b - e.v_a);
+	crossings.push_back(std::make_pair(u, e.poly));
+      }
+      sort(begin(crossings), end(crossings));
+
+      // Spans where the scanline is inside the bound and no hole
+      std::vector<std::pair<double, double>> spans;
+      std::fill(begin(inside), end(inside), false);
+      int num_holes_inside = 0;
+      bool kept = false;
+      double span_start = 0.0;
+      for (auto& c : crossings) {
+	if (c.second > 0) {
+	  num_holes_inside += inside[c.second] ? -1 : 1;
+	}
+	inside[c.second] = !inside[c.second];
+
+	bool now_kept = inside[0] && num_holes_inside == 0;
+	if (now_kept && !kept) {
+	  span_start = c.first;
+	} else if (!now_kept && kept) {
+	  spans.push_back(std::make_pair(span_start, c.first));
+	}
+	kept = now_kept;
+      }
+
+      double u_first = scan_u(l.front(), axis);
+      double u_last = scan_u(l.back(), axis);
+
+      auto to_point = [axis, v, z](const double u) {
+	return axis == 0 ? point(u, v, z) : point(v, u, z);
+      };
+
+      for (auto& span : spans) {
+	double s = max(span.first, u_first);
+	double e = min(span.second, u_last);
+	if (!(s < e)) { continue; }
+
+	std::vector<point> pts{to_point(s)};
+	for (auto p : l) {
+	  double u = scan_u(p, axis);
+	  if (s < u && u < e) {
+	    pts.push_back(to_point(u));
+	  }
+	}
+	pts.push_back(to_point(e));
+
+	clipped[li].push_back(polyline(pts));
+      }
+    }
+
+    std::vector<polyline> result;
+    for (auto& c : clipped) {
+      concat(result, c);
+    }
+    return result;
+  }
+
   std::vector<polyline>
   clip_lines(const std::vector<polyline>& lines,
 	     const polygon_3& bound,
@@ -568,6 +760,22 @@ namespace gca {
 
     
     double z = lines.front().front().z;
+
+    // Zig lines all run along one axis, which is clipped by scanning
+    // instead of with polygon differences
+    int axis = scan_axis(lines.front());
+    bool all_scanlines = axis >= 0;
+    for (auto& l : lines) {
+      if (scan_axis(l) != axis) {
+	all_scanlines = false;
+	break;
+      }
+    }
+
+    if (all_scanlines) {
+      return scanline_clip_lines(lines, bound, hole_polys, axis, z);
+    }
+
     boost_multilinestring_2 ml = to_boost_multilinestring_2(lines);
     boost_multipoly_2 hole_poly = to_boost_multipoly_2(hole_polys);
 
@@ -602,7 +810,7 @@ namespace gca {
     DBG_ASSERT(bound.holes().size() == 0);
 
     box b = bounding_box(bound);
-    cout << "Zig lines bounding box = " << endl << b << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "Zig lines bounding box = " << b);
 
     vector<polyline> lines;
     double current_y = b.y_min;
@@ -615,11 +823,15 @@ namespace gca {
       current_y += stepover;
     }
 
-    cout << "# of lines = " << lines.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines = " << lines.size());
 
     lines = clip_lines(lines, bound, holes, t);
 
-    cout << "# of lines after clipping = " << lines.size() << endl;
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines after clipping = " << lines.size());
+
+    lines = link_lines(order_lines(lines), bound, holes, t.diameter());
+
+    GCA_LOG_DEBUG(BACKEND_LOG, "# of lines after linking = " << lines.size());
 
     return lines;
   }
@@ -822,14 +1034,17 @@ namespace gca {
 
   // TODO: Actually compensate for tool radius and shape
   std::vector<point> drop_points_onto(const std::vector<point>& pts_z,
-				      const std::vector<index_t>& faces,
-				      const triangular_mesh& mesh,
+				      const drop_cutter& surface,
 				      const tool& tool) {
+    vector<maybe<double>> zs =
+      parallel_map(pts_z, [&surface](const point pt) {
+	  return surface.surface_z(pt.x, pt.y);
+	});
+
     vector<point> pts;
-    for (auto pt : pts_z) {
-      maybe<double> za = z_at(pt.x, pt.y, faces, mesh);
-      if (za.just) {
-	pts.push_back(point(pt.x, pt.y, za.t));
+    for (unsigned i = 0; i < pts_z.size(); i++) {
+      if (zs[i].just) {
+	pts.push_back(point(pts_z[i].x, pts_z[i].y, zs[i].t));
       }
     }
     return pts;
@@ -838,33 +1053,21 @@ namespace gca {
   // TODO: Compensate for tool radius / shape and come up with a
   // more descriptive name
   std::vector<point> drop_points_onto_max(const std::vector<point>& pts_z,
-					  const std::vector<index_t>& faces,
-					  const triangular_mesh& mesh,
+					  const drop_cutter& surface,
+					  const drop_cutter& whole_mesh,
 					  const double max,
 					  const tool& tool) {
-    vector<point> pts;
-    for (auto pt : pts_z) {
-      maybe<double> za = z_at(pt.x, pt.y, faces, mesh);
-      if (za.just) {
-	if (za.t > max) {
-	  pts.push_back(point(pt.x, pt.y, za.t));
-	} else {
-	  pts.push_back(point(pt.x, pt.y, max));
+    return parallel_map(pts_z, [&surface, &whole_mesh, max](const point pt) {
+	maybe<double> za = surface.surface_z(pt.x, pt.y);
+	if (!za.just) {
+	  za = whole_mesh.surface_z(pt.x, pt.y);
 	}
-      } else {
-	maybe<double> zb = mesh.z_at(pt.x, pt.y);
-	if (zb.just) {
-	  if (zb.t > max) {
-	    pts.push_back(point(pt.x, pt.y, zb.t));
-	  } else {
-	    pts.push_back(point(pt.x, pt.y, max));
-	  }
-	} else {
-	  pts.push_back(point(pt.x, pt.y, max));
+
+	if (za.just && za.t > max) {
+	  return point(pt.x, pt.y, za.t);
 	}
-      }
-    }
-    return pts;
+	return point(pt.x, pt.y, max);
+      });
   }
   
   std::vector<polyline> drop_sample(const triangular_mesh& mesh,
@@ -876,16 +1079,15 @@ namespace gca {
 
     vector<point> pts_z = sample_points_2d(b, tool.radius(), tool.radius(), 1.0);
 
-    vector<point> pts = drop_points_onto(pts_z, mesh.face_indexes(), mesh, tool);
+    drop_cutter surface(mesh);
+    vector<point> pts = drop_points_onto(pts_z, surface, tool);
 
     vector<polyline> lines;
     lines.push_back(pts);
     return shift_lines(lines, point(0, 0, tool.length()));
   }
 
-  // TODO: Does pocket list need to be non-const?
-  vector<toolpath> mill_pockets(const vector<pocket>& pockets,
-				const material& stock_material) {
+  static double pockets_safe_z(const vector<pocket>& pockets) {
     DBG_ASSERT(pockets.size() > 0);
 
     double h = (*(max_element(begin(pockets), end(pockets),
@@ -893,12 +1095,45 @@ namespace gca {
       { return l.get_start_depth() < r.get_start_depth(); }))).get_start_depth();
 
     double clearance = 0.20;
-    double safe_z = h + clearance;
-    
-    vector<toolpath> toolpaths;
-    for (auto pocket : pockets) {
-      vector<toolpath> tps = pocket.make_toolpaths(stock_material, safe_z); //, tools);
-      concat(toolpaths, tps);
+    return h + clearance;
+  }
+
+  // TODO: Does pocket list need to be non-const?
+  vector<toolpath> mill_pockets(const vector<pocket>& pockets,
+				const material& stock_material) {
+    return mill_pocket_lists({pockets}, stock_material).front();
+  }
+
+  vector<vector<toolpath>>
+  mill_pocket_lists(const vector<vector<pocket>>& pocket_lists,
+		    const material& stock_material) {
+    // One job per pocket, tagged with the list it came from
+    vector<pair<unsigned, const pocket*>> jobs;
+    vector<double> safe_zs;
+    for (unsigned i = 0; i < pocket_lists.size(); i++) {
+      safe_zs.push_back(pockets_safe_z(pocket_lists[i]));
+      for (auto& p : pocket_lists[i]) {
+	jobs.push_back(make_pair(i, &p));
+      }
+    }
+
+    auto make_job_toolpaths =
+      [&safe_zs, &stock_material](const pair<unsigned, const pocket*>& job) {
+      return job.second->make_toolpaths(stock_material, safe_zs[job.first]);
+    };
+
+    vector<vector<toolpath>> job_toolpaths;
+    if (parallel_toolpath_generation()) {
+      job_toolpaths = parallel_map_with_arenas(jobs, make_job_toolpaths);
+    } else {
+      for (auto& job : jobs) {
+	job_toolpaths.push_back(make_job_toolpaths(job));
+      }
+    }
+
+    vector<vector<toolpath>> toolpaths(pocket_lists.size());
+    for (unsigned i = 0; i < jobs.size(); i++) {
+      concat(toolpaths[jobs[i].first], job_toolpaths[i]);
     }
 
     return toolpaths;
@@ -1216,15 +1451,15 @@ namespace gca {
       double smallest_access_area = area(smallest_access_region);
       double second_smallest_access_area = area(second_smallest_access_region);
 
-      cout << "Smallest diameter           = " << smallest.cut_diameter() << endl;
-      cout << "Smallest access area        = " << smallest_access_area << endl;
-      cout << "Second smallest diameter    = " << second_smallest.cut_diameter() << endl;
-      cout << "Second smallest access area = " << second_smallest_access_area << endl;
+      GCA_LOG_DEBUG(BACKEND_LOG, "Smallest diameter           = " << smallest.cut_diameter());
+      GCA_LOG_DEBUG(BACKEND_LOG, "Smallest access area        = " << smallest_access_area);
+      GCA_LOG_DEBUG(BACKEND_LOG, "Second smallest diameter    = " << second_smallest.cut_diameter());
+      GCA_LOG_DEBUG(BACKEND_LOG, "Second smallest access area = " << second_smallest_access_area);
 
       double fraction_diff =
 	(smallest_access_area - second_smallest_access_area) / smallest_access_area;
 
-      cout << "Fraction difference = " << fraction_diff << endl;
+      GCA_LOG_DEBUG(BACKEND_LOG, "Fraction difference = " << fraction_diff);
 
       double check_tol = 0.01;
       // NOTE: Horrible naming issue
@@ -1259,17 +1494,13 @@ namespace gca {
 
     DBG_ASSERT(tools.size() > 0);
 
-    toolpath rough_path = rough_flat_region(r, safe_z, tools);
-    toolpath rough_finish = finish_path(r, safe_z, rough_path.t);
-    toolpath finish_path = finish_flat_region(r, safe_z, tools);
-
-    std::vector<toolpath> all_paths{rough_path, rough_finish, finish_path};
-
-    double emco_hp = 0.737;
-    double aluminum_unit_hp = 0.3;
-    //optimize_feedrates_by_MRR_simulation(r, all_paths, emco_hp, aluminum_unit_hp);
+    tool rough_tool = select_roughing_tool(r, tools);
 
-    return all_paths;
+    return generate_passes({
+	[&]() { return zig_rough_path(r, safe_z, rough_tool); },
+	[&]() { return finish_path(r, safe_z, rough_tool); },
+	[&]() { return finish_flat_region(r, safe_z, tools); }
+      });
   }
 
   std::vector<polyline> contour_level(const flat_region& r,
@@ -1298,14 +1529,39 @@ namespace gca {
     vector<polygon_3> outer_bound =
       exterior_offset(r.machine_area, outer_offset);
 
-    vector<polygon_3> paths;
-    while (!contains(cut_rings, outer_bound)) {
-      vector<polygon_3> path_rings =
-	polygon_union(polygon_intersection(outer_bound, cut_rings), safe_islands);
+    // No ring needs to be offset further than the width of the
+    // region, so every ring can be read off of one set of island
+    // skeletons built up front
+    vector<point> bound_pts;
+    for (auto& p : outer_bound) {
+      concat(bound_pts, p.vertices());
+    }
+    box bb = bound_positions(bound_pts);
+    double max_offset =
+      sqrt(bb.x_len()*bb.x_len() + bb.y_len()*bb.y_len() + bb.z_len()*bb.z_len()) +
+      stepover_value;
 
-      concat(paths, path_rings);
+    exterior_offset_rings island_rings(safe_islands, max_offset);
+
+    vector<vector<polygon_3>> level_rings;
+    double d = 0.0;
+    while (safe_islands.size() > 0 && !contains(cut_rings, outer_bound)) {
+      level_rings.push_back(cut_rings);
 
-      cut_rings = exterior_offset(cut_rings, stepover_value);
+      d += stepover_value;
+      if (d > max_offset) { break; }
+
+      cut_rings = island_rings.at(d);
+    }
+
+    vector<vector<polygon_3>> level_paths =
+      parallel_map(level_rings, [&outer_bound, &safe_islands](const vector<polygon_3>& rings) {
+	  return polygon_union(polygon_intersection(outer_bound, rings), safe_islands);
+	});
+
+    vector<polygon_3> paths;
+    for (auto& path_rings : level_paths) {
+      concat(paths, path_rings);
     }
 
     vector<polygon_3> final_rings =
@@ -1380,24 +1636,17 @@ namespace gca {
     tool rough_tool = select_roughing_tool(r, tools);
     tool finish_tool = select_finishing_tool(r, tools);
 
-    toolpath rough_path = contour_rough_path(r, safe_z, rough_tool);
-
-    toolpath rough_finish = finish_path(r, safe_z, rough_path.t);
-
     // TODO: fix horrible names
-    std::vector<toolpath> all_paths{rough_path,
-	rough_finish};
+    std::vector<std::function<toolpath()>> passes{
+      [&]() { return contour_rough_path(r, safe_z, rough_tool); },
+      [&]() { return finish_path(r, safe_z, rough_tool); }
+    };
 
     if (finish_tool.tool_number() != rough_tool.tool_number()) {
-      toolpath finishing_path = finish_path(r, safe_z, finish_tool);
-      all_paths.push_back(finishing_path);
+      passes.push_back([&]() { return finish_path(r, safe_z, finish_tool); });
     }
-    
-    // double emco_hp = 0.737;
-    // double aluminum_unit_hp = 0.3;
-    //optimize_feedrates_by_MRR_simulation(r, all_paths, emco_hp, aluminum_unit_hp);
 
-    return all_paths;
+    return generate_passes(passes);
   }
 
   std::vector<toolpath>
@@ -2,6 +2,7 @@
 #define GCA_TOOLPATH_GENERATION_H
 
 #include "geometry/box.h"
+#include "backend/drop_cutter.h"
 #include "backend/operation.h"
 
 namespace gca {
@@ -251,20 +252,35 @@ namespace gca {
   std::vector<polyline> drop_sample(const triangular_mesh& mesh,
 				    const tool& tool);
 
+  // The surfaces are drop_cutters so their BVH can be built once
+  // per surface and shared by every call for its toolpaths
   std::vector<point> drop_points_onto(const std::vector<point>& pts_z,
-				      const std::vector<index_t>& faces,
-				      const triangular_mesh& mesh,
+				      const drop_cutter& surface,
 				      const tool& tool);
 
+  // Points not over surface fall back to whole_mesh, and none end up
+  // below max
   std::vector<point> drop_points_onto_max(const std::vector<point>& pts_z,
-					  const std::vector<index_t>& faces,
-					  const triangular_mesh& mesh,
+					  const drop_cutter& surface,
+					  const drop_cutter& whole_mesh,
 					  const double max,
 					  const tool& tool);
 
+  // In parallel mode pockets and the passes within each pocket are
+  // generated on worker threads, each with its own cut arena. The
+  // toolpaths and their order are the same as in serial mode
+  void set_parallel_toolpath_generation(const bool parallel);
+  bool parallel_toolpath_generation();
+
   vector<toolpath> mill_pockets(const vector<pocket>& pockets,
 				const material& stock_material);
 
+  // Toolpaths for each list of pockets, the pockets of all lists
+  // share one pool of worker threads in parallel mode
+  vector<vector<toolpath>>
+  mill_pocket_lists(const vector<vector<pocket>>& pocket_lists,
+		    const material& stock_material);
+
 
   class flat_region {
   public:
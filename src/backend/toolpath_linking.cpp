@@ -0,0 +1,255 @@
+#include <algorithm>
+
+#include "backend/toolpath_linking.h"
+
+namespace gca {
+
+  // Improvement passes stop after this many even if 2-opt is still
+  // finding shorter tours
+  static const unsigned max_two_opt_passes = 10;
+
+  // Distance within which a point counts as on a region boundary
+  static const double on_ring_tolerance = 1e-7;
+
+  struct oriented_line {
+    unsigned line;
+    bool flip;
+  };
+
+  static inline point line_start(const std::vector<polyline>& lines,
+				 const oriented_line& l) {
+    return l.flip ? lines[l.line].back() : lines[l.line].front();
+  }
+
+  static inline point line_end(const std::vector<polyline>& lines,
+			       const oriented_line& l) {
+    return l.flip ? lines[l.line].front() : lines[l.line].back();
+  }
+
+  static std::vector<oriented_line>
+  nearest_neighbor_tour(const std::vector<polyline>& lines) {
+    std::vector<oriented_line> tour{{0, false}};
+    std::vector<bool> used(lines.size(), false);
+    used[0] = true;
+
+    for (unsigned k = 1; k < lines.size(); k++) {
+      point current = line_end(lines, tour.back());
+
+      oriented_line next{0, false};
+      double next_dist = -1.0;
+      for (unsigned i = 0; i < lines.size(); i++) {
+	if (used[i]) { continue; }
+
+	double d_front = (lines[i].front() - current).len();
+	double d_back = (lines[i].back() - current).len();
+
+	if (next_dist < 0.0 || d_front < next_dist) {
+	  next = {i, false};
+	  next_dist = d_front;
+	}
+	if (d_back < next_dist) {
+	  next = {i, true};
+	  next_dist = d_back;
+	}
+      }
+
+      used[next.line] = true;
+      tour.push_back(next);
+    }
+
+    return tour;
+  }
+
+  // Reversing the run tour[i + 1 .. j], and every line in it, only
+  // changes the move into the run and the move out of it
+  static void two_opt(const std::vector<polyline>& lines,
+		      std::vector<oriented_line>& tour) {
+    bool improved = true;
+    for (unsigned pass = 0; improved && pass < max_two_opt_passes; pass++) {
+      improved = false;
+
+      for (unsigned i = 0; i + 2 < tour.size(); i++) {
+	point a = line_end(lines, tour[i]);
+	point b = line_start(lines, tour[i + 1]);
+
+	for (unsigned j = i + 1; j < tour.size(); j++) {
+	  point c = line_end(lines, tour[j]);
+	  bool last = j + 1 == tour.size();
+
+	  double before = (b - a).len();
+	  double after = (c - a).len();
+	  if (!last) {
+	    point d = line_start(lines, tour[j + 1]);
+	    before += (d - c).len();
+	    after += (d - b).len();
+	  }
+
+	  if (after < before - 1e-10) {
+	    reverse(begin(tour) + i + 1, begin(tour) + j + 1);
+	    for (unsigned k = i + 1; k <= j; k++) {
+	      tour[k].flip = !tour[k].flip;
+	    }
+
+	    b = line_start(lines, tour[i + 1]);
+	    improved = true;
+	  }
+	}
+      }
+    }
+  }
+
+  std::vector<polyline> order_lines(const std::vector<polyline>& lines) {
+    if (lines.size() < 2) { return lines; }
+
+    std::vector<oriented_line> tour = nearest_neighbor_tour(lines);
+    two_opt(lines, tour);
+
+    std::vector<polyline> ordered;
+    for (auto& l : tour) {
+      std::vector<point> pts(begin(lines[l.line]), end(lines[l.line]));
+      if (l.flip) {
+	reverse(begin(pts), end(pts));
+      }
+      ordered.push_back(polyline(pts));
+    }
+    return ordered;
+  }
+
+  static inline double orient_xy(const point a, const point b, const point c) {
+    return (b.x - a.x)*(c.y - a.y) - (b.y - a.y)*(c.x - a.x);
+  }
+
+  // True if a -> b and p -> q cross at a point interior to both,
+  // touching at an end does not count
+  static bool properly_crosses(const point a, const point b,
+			       const point p, const point q) {
+    double o1 = orient_xy(a, b, p);
+    double o2 = orient_xy(a, b, q);
+    double o3 = orient_xy(p, q, a);
+    double o4 = orient_xy(p, q, b);
+    return ((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) &&
+      ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0));
+  }
+
+  static bool crosses_ring(const point a, const point b,
+			   const std::vector<point>& ring) {
+    for (unsigned i = 0; i < ring.size(); i++) {
+      if (properly_crosses(a, b, ring[i], ring[(i + 1) % ring.size()])) {
+	return true;
+      }
+    }
+    return false;
+  }
+
+  static bool on_ring(const point p, const std::vector<point>& ring) {
+    for (unsigned i = 0; i < ring.size(); i++) {
+      point a = ring[i];
+      point b = ring[(i + 1) % ring.size()];
+      point ab(b.x - a.x, b.y - a.y, 0);
+      point ap(p.x - a.x, p.y - a.y, 0);
+
+      double l2 = ab.x*ab.x + ab.y*ab.y;
+      double s = l2 > 0.0 ? std::max(0.0, std::min(1.0, (ap.x*ab.x + ap.y*ab.y) / l2)) : 0.0;
+      point closest = ap - s*ab;
+      if (closest.x*closest.x + closest.y*closest.y < on_ring_tolerance*on_ring_tolerance) {
+	return true;
+      }
+    }
+    return false;
+  }
+
+  static bool inside_ring(const point p, const std::vector<point>& ring) {
+    bool inside = false;
+    for (unsigned i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+      const point& r_i = ring[i];
+      const point& r_j = ring[j];
+      if ((r_i.y > p.y) != (r_j.y > p.y) &&
+	  p.x < (r_j.x - r_i.x)*(p.y - r_i.y) / (r_j.y - r_i.y) + r_i.x) {
+	inside = !inside;
+      }
+    }
+    return inside;
+  }
+
+  // Points on the boundary of poly count as inside when on_boundary
+  // is set and as outside otherwise
+  static bool inside_polygon(const point p,
+			     const polygon_3& poly,
+			     const bool on_boundary) {
+    if (on_ring(p, poly.vertices())) { return on_boundary; }
+    for (auto& h : poly.holes()) {
+      if (on_ring(p, h)) { return on_boundary; }
+    }
+
+    if (!inside_ring(p, poly.vertices())) { return false; }
+
+    for (auto& h : poly.holes()) {
+      if (inside_ring(p, h)) { return false; }
+    }
+    return true;
+  }
+
+  // Ends on a boundary are fine since clipped lines start and stop
+  // there, and so are moves along the boundary. A move that properly
+  // crosses a ring or whose midpoint is outside the region is not
+  static bool move_inside_region(const point a, const point b,
+				 const polygon_3& bound,
+				 const std::vector<polygon_3>& holes) {
+    if (crosses_ring(a, b, bound.vertices())) { return false; }
+    for (auto& h : bound.holes()) {
+      if (crosses_ring(a, b, h)) { return false; }
+    }
+
+    for (auto& hole : holes) {
+      if (crosses_ring(a, b, hole.vertices())) { return false; }
+      for (auto& h : hole.holes()) {
+	if (crosses_ring(a, b, h)) { return false; }
+      }
+    }
+
+    point mid = 0.5*(a + b);
+    if (!inside_polygon(mid, bound, true)) { return false; }
+
+    for (auto& hole : holes) {
+      if (inside_polygon(mid, hole, false)) { return false; }
+    }
+
+    return true;
+  }
+
+  std::vector<polyline>
+  link_lines(const std::vector<polyline>& lines,
+	     const polygon_3& bound,
+	     const std::vector<polygon_3>& holes,
+	     const double max_link_length) {
+    std::vector<polyline> linked;
+    std::vector<point> current;
+
+    for (auto& l : lines) {
+      if (current.size() > 0) {
+	point a = current.back();
+	point b = l.front();
+
+	if (within_eps(a.z, b.z, 1e-8) &&
+	    (b - a).len() <= max_link_length &&
+	    move_inside_region(a, b, bound, holes)) {
+	  auto start = begin(l);
+	  if (within_eps(a, b, 1e-8)) { start++; }
+	  current.insert(end(current), start, end(l));
+	  continue;
+	}
+
+	linked.push_back(polyline(current));
+      }
+
+      current = std::vector<point>(begin(l), end(l));
+    }
+
+    if (current.size() > 0) {
+      linked.push_back(polyline(current));
+    }
+
+    return linked;
+  }
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "geometry/polygon_3.h"
+#include "geometry/polyline.h"
+
+namespace gca {
+
+  // Reorders and reverses lines to shorten the moves between the end
+  // of each line and the start of the next. Starts from a greedy
+  // nearest neighbour tour over both ends of every line and improves
+  // it with 2-opt, so parallel passes come out as a zig-zag
+  std::vector<polyline> order_lines(const std::vector<polyline>& lines);
+
+  // Joins each line to the next one when the move between them is at
+  // the same height, no longer than max_link_length and stays inside
+  // bound and outside every hole, so the tool can feed across instead
+  // of retracting
+  std::vector<polyline>
+  link_lines(const std::vector<polyline>& lines,
+	     const polygon_3& bound,
+	     const std::vector<polygon_3>& holes,
+	     const double max_link_length);
+
+}
@@ -12,6 +12,7 @@
 #include "synthesis/contour_planning.h"
 #include "utils/arena_allocator.h"
 #include "utils/check.h"
+#include "utils/instrumentation.h"
 
 namespace gca {
 
@@ -671,6 +672,8 @@ namespace gca {
   build_feature_decomposition(const triangular_mesh& stock,
 			      const std::vector<triangular_mesh>& meshes,
 			      const point n) {
+    phase_timer phase("build_feature_decomposition");
+
     triangular_mesh lowest = min_e(meshes, [n](const triangular_mesh& m) {
 	return min_distance_along(m.vertex_list(), n);
       });
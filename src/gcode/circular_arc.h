@@ -87,6 +87,19 @@ namespace gca {
       return arc;
     }
 
+    virtual cut* reflect_x() const {
+      point ro = start_offset;
+      ro.x = -1*ro.x;
+      circular_arc* arc = circular_arc::make(point(-1*get_start().x, get_start().y, get_start().z),
+					     point(-1*get_end().x, get_end().y, get_end().z),
+					     ro,
+					     dir == CLOCKWISE ? COUNTERCLOCKWISE : CLOCKWISE,
+					     pl);
+      arc->tool_no = tool_no;
+      arc->settings = settings;
+      return arc;
+    }
+
     void print(ostream& other) const {
       other << "CIRCULAR ARC: " << tool_no << " ";
       if (!get_feedrate()->is_omitted()) {
@@ -64,12 +64,11 @@ namespace gca {
       return false;
     }
 
-    cut* shift(point sh) const {
-      //circular_helix_cut* mem = allocate<circular_helix_cut>();
-      circular_helix_cut* arc = static_cast<circular_helix_cut*>(copy()); // new (mem) circular_helix_cut(start + sh, end + sh, start_offset, dir, pl);
-      arc->set_start(get_start() + sh);
-      arc->set_end(get_end() + sh);
-      return arc;
+    void translate(point sh) {
+      point s = get_start();
+      point e = get_end();
+      set_start(s + sh);
+      set_end(e + sh);
     }
 
     cut* scale(double s) const {
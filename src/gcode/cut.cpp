@@ -296,7 +296,38 @@ namespace gca {
 		      (is_vertical(c) || is_horizontal(c)); });
   }
 
-  // TODO: Make this account for cut shape
+  template<typename A>
+  double arc_swept_angle(const A* arc) {
+    point u = arc->get_start() - arc->center();
+    point v = arc->get_end() - arc->center();
+    double theta = atan2(u.x*v.y - u.y*v.x, u.x*v.x + u.y*v.y);
+    if (arc->dir == CLOCKWISE) { theta = -theta; }
+    if (theta <= 0.0) { theta += 2*M_PI; }
+    return theta;
+  }
+
+  double swept_angle(const cut* c) {
+    if (c->is_circular_arc()) {
+      return arc_swept_angle(static_cast<const circular_arc*>(c));
+    }
+
+    DBG_ASSERT(c->is_circular_helix_cut());
+    return arc_swept_angle(static_cast<const circular_helix_cut*>(c));
+  }
+
+  double travel_distance(const cut* c) {
+    if (!c->is_circular_arc() && !c->is_circular_helix_cut()) {
+      return (c->get_end() - c->get_start()).len();
+    }
+
+    point so = c->is_circular_arc() ?
+      static_cast<const circular_arc*>(c)->start_offset :
+      static_cast<const circular_helix_cut*>(c)->start_offset;
+    double horizontal = sqrt(so.x*so.x + so.y*so.y)*swept_angle(c);
+    double vertical = c->get_end().z - c->get_start().z;
+    return sqrt(horizontal*horizontal + vertical*vertical);
+  }
+
   double cut_execution_time_minutes(const cut* c) {
     value* f = c->get_feedrate();
     double fr;
@@ -309,7 +340,7 @@ namespace gca {
       // G0 moves?
       fr = 1000;
     }
-    return (c->get_end() - c->get_start()).len() / fr;
+    return travel_distance(c) / fr;
   }
 
   double execution_time_seconds(const std::vector<cut*>& cs) {
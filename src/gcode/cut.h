@@ -55,9 +55,14 @@ namespace gca {
     
     virtual bool operator==(const cut& other) const = 0;
 
-    virtual cut* shift(point shift) const {
+    // Moves this cut, for cuts nothing else refers to
+    virtual void translate(point shift) {
+      c = c.shift(shift);
+    }
+
+    cut* shift(point shift) const {
       cut* new_c = copy();
-      new_c->c = c.shift(shift);
+      new_c->translate(shift);
       return new_c;
     }
 
@@ -96,7 +101,14 @@ namespace gca {
   bool is_vertical(const cut* c);
   bool is_horizontal(const cut* c);
   bool is_prismatic(vector<cut*>& path);
-  // TODO: Make this account for cut shape
+  // Angle in radians that an arc or helix turns through about its
+  // center in the XY plane, a full turn when it ends where it starts
+  double swept_angle(const cut* c);
+
+  // Distance the tool moves along c, arcs and helices are measured
+  // along the curve rather than across their chord
+  double travel_distance(const cut* c);
+
   double cut_execution_time_minutes(const cut* c);
   double cut_execution_time_seconds(const cut* c);
 
@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdio>
+
+#include "gcode/gcode_writer.h"
+
+namespace gca {
+
+  gcode_writer::gcode_writer(std::ostream& p_out, const size_t buffer_size)
+    : out(p_out), buf(buffer_size), used(0) {
+    DBG_ASSERT(buffer_size >= 64);
+  }
+
+  gcode_writer::~gcode_writer() { flush(); }
+
+  void gcode_writer::flush() {
+    if (used > 0) {
+      out.write(buf.data(), used);
+      used = 0;
+    }
+  }
+
+  void gcode_writer::put_int(const long v) {
+    char digits[24];
+    int n = 0;
+
+    unsigned long u = v < 0 ? -static_cast<unsigned long>(v) : v;
+    do {
+      digits[n++] = '0' + (u % 10);
+      u /= 10;
+    } while (u > 0);
+
+    if (v < 0) { put('-'); }
+    while (n > 0) { put(digits[--n]); }
+  }
+
+  // Numbers past this size, and those whose seventh decimal digit is
+  // too close to a tie to round the same way printf does, go through
+  // snprintf instead
+  static const double max_fast_fixed = 1e6;
+  static const double tie_window = 1e-3;
+
+  void gcode_writer::put_fixed(const double v) {
+    double a = fabs(v);
+
+    if (std::isfinite(v) && a < max_fast_fixed) {
+      double scaled = a*1e6;
+      double whole = floor(scaled);
+      double frac = scaled - whole;
+
+      if (fabs(frac - 0.5) > tie_window) {
+	unsigned long n = static_cast<unsigned long>(whole) + (frac > 0.5 ? 1 : 0);
+
+	if (std::signbit(v)) { put('-'); }
+	put_int(n / 1000000);
+	put('.');
+
+	unsigned long f = n % 1000000;
+	for (unsigned long d = 100000; d > 0; d /= 10) {
+	  put('0' + (f / d) % 10);
+	}
+	return;
+      }
+    }
+
+    char s[64];
+    int len = snprintf(s, sizeof(s), "%f", v);
+    for (int i = 0; i < len && i < static_cast<int>(sizeof(s)) - 1; i++) {
+      put(s[i]);
+    }
+  }
+
+  void gcode_writer::word(const char c, const double v) {
+    reserve(80);
+    put(c);
+    put_fixed(v);
+    put(' ');
+  }
+
+  void gcode_writer::word(const char c, const int v) {
+    reserve(32);
+    put(c);
+    put_int(v);
+    put(' ');
+  }
+
+  void gcode_writer::word(const char c, const value* v) {
+    if (v->is_lit()) {
+      word(c, static_cast<const lit*>(v)->v);
+    } else if (v->is_ilit()) {
+      word(c, static_cast<const ilit*>(v)->v);
+    } else if (v->is_var()) {
+      reserve(32);
+      put(c);
+      put('#');
+      put_int(static_cast<const var*>(v)->n);
+      put(' ');
+    } else {
+      DBG_ASSERT(v->is_omitted());
+      reserve(2);
+      put(c);
+      put(' ');
+    }
+  }
+
+  void gcode_writer::comment(const std::string& text,
+			     const token_type comment_style) {
+    if (comment_style == PAREN_COMMENT) {
+      gcode_writer::text("(*** " + text + " ***) ");
+    } else if (comment_style == BRACKET_COMMENT) {
+      gcode_writer::text("[*** " + text + " ***] ");
+    } else {
+      DBG_ASSERT(comment_style == LINE_SEMICOLON_COMMENT);
+      gcode_writer::text("; " + text + " ");
+    }
+  }
+
+  void gcode_writer::end_block() {
+    reserve(1);
+    put('\n');
+  }
+
+  void gcode_writer::write(const token& t) {
+    if (t.ttp == ICODE) {
+      word(t.c, t.v);
+    } else {
+      comment(t.text, t.ttp);
+    }
+  }
+
+  void gcode_writer::write(const block& b) {
+    for (auto& t : b) { write(t); }
+    end_block();
+  }
+
+  void gcode_writer::write(const std::vector<block>& blocks) {
+    for (auto& b : blocks) { write(b); }
+  }
+
+  void gcode_writer::text(const std::string& s) {
+    if (s.size() > buf.size()) {
+      flush();
+      out.write(s.data(), s.size());
+      return;
+    }
+
+    reserve(s.size());
+    for (auto c : s) { put(c); }
+  }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gcode/lexer.h"
+
+namespace gca {
+
+  // Formats G-code into a fixed size buffer that is written to out
+  // in large chunks. Output is the same text as printing blocks to a
+  // stream set to ios::fixed, but numbers are formatted without
+  // iostreams and no tokens are built
+  class gcode_writer {
+  protected:
+    std::ostream& out;
+    std::vector<char> buf;
+    size_t used;
+
+    inline void reserve(const size_t n) {
+      if (used + n > buf.size()) { flush(); }
+    }
+
+    inline void put(const char c) { buf[used++] = c; }
+
+    void put_fixed(const double v);
+    void put_int(const long v);
+
+  public:
+    gcode_writer(std::ostream& p_out, const size_t buffer_size = 1 << 16);
+    ~gcode_writer();
+
+    // Each word is followed by a space, like a token in a block
+    void word(const char c, const double v);
+    void word(const char c, const int v);
+    void word(const char c, const value* v);
+
+    void comment(const std::string& text, const token_type comment_style);
+
+    void end_block();
+
+    void write(const token& t);
+    void write(const block& b);
+    void write(const std::vector<block>& blocks);
+
+    void text(const std::string& s);
+
+    void flush();
+  };
+
+}
@@ -25,11 +25,11 @@ namespace gca {
     
     inline bool is_hole_punch() const { return true; }
 
-    cut* shift(point sh) const {
-      hole_punch* hole = static_cast<hole_punch*>(copy());
-      hole->set_start(get_start() + sh);
-      hole->set_end(get_end() + sh);
-      return hole;
+    void translate(point sh) {
+      point s = get_start();
+      point e = get_end();
+      set_start(s + sh);
+      set_end(e + sh);
     }
 
     cut* scale(double s) const {
@@ -48,8 +48,13 @@ namespace gca {
     arc shift(point s) const
     { return arc(start + s, end + s, start_offset(), dir); }
 
+    // Mirroring reverses the direction of travel around the center
     arc reflect_x() const {
-      DBG_ASSERT(false);
+      point rs(-1*start.x, start.y, start.z);
+      point re(-1*end.x, end.y, end.z);
+      point ro = start_offset();
+      ro.x = -1*ro.x;
+      return arc(rs, re, ro, dir == CLOCKWISE ? COUNTERCLOCKWISE : CLOCKWISE);
     }
     
     arc scale(double s) const {
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "utils/arena_allocator.h"
+#include "utils/check.h"
 #include "geometry/point.h"
 
 using namespace std;
@@ -31,17 +32,81 @@ namespace gca {
 
     inline void push_knot(double k) { knots.push_back(k); }
     inline void push_control_point(point p) { control_points.push_back(p); }
-    inline unsigned num_control_points() { return control_points.size(); }
-    inline unsigned num_knots() { return knots.size(); }
+    inline unsigned num_control_points() const { return control_points.size(); }
+    inline unsigned num_knots() const { return knots.size(); }
+    inline double knot(unsigned i) const { return knots[i]; }
 
+    // Parameter range the spline is defined over
+    inline double start_param() const { return knots[degree]; }
+    inline double end_param() const { return knots[control_points.size()]; }
+
+    // Index k of the knot span [knots[k], knots[k + 1]) holding v,
+    // parameters outside the curve map to its first or last span
+    unsigned find_span(double v) const {
+      unsigned n = control_points.size() - 1;
+      if (v >= knots[n + 1]) { return n; }
+      if (v <= knots[degree]) { return degree; }
+
+      unsigned low = degree;
+      unsigned high = n + 1;
+      while (high - low > 1) {
+	unsigned mid = (low + high) / 2;
+	if (v < knots[mid]) {
+	  high = mid;
+	} else {
+	  low = mid;
+	}
+      }
+      return low;
+    }
+
+    // de Boor's algorithm over the degree + 1 control points that
+    // affect v, O(degree^2) instead of evaluating every basis function
     point eval(double v) const {
-      point res = point(0, 0, 0);
-      for (unsigned i = 0; i < control_points.size(); i++) {
-	res = res + basis(i, degree, v) * control_points[i];
+      DBG_ASSERT(knots.size() == control_points.size() + degree + 1);
+
+      unsigned k = find_span(v);
+      vector<point> d(control_points.begin() + (k - degree),
+		      control_points.begin() + (k + 1));
+      for (int r = 1; r <= degree; r++) {
+	for (int j = degree; j >= r; j--) {
+	  unsigned i = k - degree + j;
+	  double denom = knots[i + degree - r + 1] - knots[i];
+	  double alpha = denom == 0.0 ? 0.0 : (v - knots[i]) / denom;
+	  d[j] = (1.0 - alpha)*d[j - 1] + alpha*d[j];
+	}
       }
-      return res;
+      return d[degree];
+    }
+
+    // First derivative with respect to v, the derivative of a
+    // spline is a spline of one lower degree over the same knots
+    point derivative(double v) const {
+      DBG_ASSERT(knots.size() == control_points.size() + degree + 1);
+      if (degree == 0) { return point(0, 0, 0); }
+
+      unsigned k = find_span(v);
+      vector<point> d;
+      for (unsigned i = k - degree + 1; i <= k; i++) {
+	double denom = knots[i + degree] - knots[i];
+	point q = denom == 0.0 ? point(0, 0, 0) :
+	  (degree / denom)*(control_points[i] - control_points[i - 1]);
+	d.push_back(q);
+      }
+
+      int p = degree - 1;
+      for (int r = 1; r <= p; r++) {
+	for (int j = p; j >= r; j--) {
+	  unsigned i = k - p + j;
+	  double denom = knots[i + p - r + 1] - knots[i];
+	  double alpha = denom == 0.0 ? 0.0 : (v - knots[i]) / denom;
+	  d[j] = (1.0 - alpha)*d[j - 1] + alpha*d[j];
+	}
+      }
+      return d[p];
     }
 
+    // Cox-de Boor recursion for the basis function N_{i,k}(x)
     double basis(int i, int k, double x) const {
       if (k == 0) {
 	double ti = knots[i];
@@ -1,6 +1,61 @@
+#include <algorithm>
+
+#include "geometry/box.h"
 #include "geometry/depth_field.h"
+#include "geometry/polygon_3.h"
 
 namespace gca {
 
-  
+  static void append_ring_crossings(const std::vector<point>& ring,
+				    const double x,
+				    std::vector<double>& ys) {
+    for (unsigned i = 0; i < ring.size(); i++) {
+      point a = ring[i];
+      point b = ring[(i + 1) % ring.size()];
+
+      if ((a.x <= x && x < b.x) || (b.x <= x && x < a.x)) {
+	ys.push_back(a.y + (x - a.x)*(b.y - a.y)/(b.x - a.x));
+      }
+    }
+  }
+
+  // Cells of df whose sample point lies inside the xy projection of
+  // p, found with one scanline per column instead of a point in
+  // polygon test per cell
+  std::vector<std::pair<int, int>>
+  rasterize_polygon(const polygon_3& p, const depth_field& df) {
+    std::vector<std::pair<int, int>> cells;
+
+    box bb = bound_positions(p.vertices());
+    int first_i = max(df.x_index(bb.x_min) - 1, 0);
+    int last_i = min(df.x_index(bb.x_max) + 1, df.num_x_elems - 1);
+
+    std::vector<double> ys;
+    for (int i = first_i; i <= last_i; i++) {
+      double x = df.x_coord(i);
+
+      ys.clear();
+      append_ring_crossings(p.vertices(), x, ys);
+      for (auto& h : p.holes()) {
+	append_ring_crossings(h, x, ys);
+      }
+
+      sort(begin(ys), end(ys));
+
+      for (unsigned k = 0; k + 1 < ys.size(); k += 2) {
+	int first_j = max(df.y_index(ys[k]), 0);
+	int last_j = min(df.y_index(ys[k + 1]) + 1, df.num_y_elems - 1);
+
+	for (int j = first_j; j <= last_j; j++) {
+	  double y = df.y_coord(j);
+	  if (ys[k] < y && y < ys[k + 1]) {
+	    cells.push_back(std::make_pair(i, j));
+	  }
+	}
+      }
+    }
+
+    return cells;
+  }
+
 }
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <cstdlib>
+#include <utility>
+#include <vector>
 
 #include "geometry/point.h"
 #include "utils/check.h"
 
 namespace gca {
 
+  class polygon_3;
+
   class depth_field {
   protected:
     point origin;
@@ -157,4 +161,7 @@ namespace gca {
 
   };
 
+  std::vector<std::pair<int, int>>
+  rasterize_polygon(const polygon_3& p, const depth_field& df);
+
 }
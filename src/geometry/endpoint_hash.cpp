@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+
+#include "geometry/endpoint_hash.h"
+#include "utils/check.h"
+
+namespace gca {
+
+  endpoint_hash::endpoint_hash(const double tol) : tolerance(tol) {
+    DBG_ASSERT(tolerance > 0.0);
+  }
+
+  endpoint_hash::cell endpoint_hash::cell_of(const point p) const {
+    return cell{static_cast<long>(floor(p.x / tolerance)),
+	static_cast<long>(floor(p.y / tolerance)),
+	static_cast<long>(floor(p.z / tolerance))};
+  }
+
+  void endpoint_hash::insert(const point p, const unsigned id) {
+    cells[cell_of(p)].push_back(std::make_pair(p, id));
+  }
+
+  // The hash holds the start of segment i as id 2i and its end as 2i + 1
+  std::vector<segment_chain>
+  chain_segments(const std::vector<std::pair<point, point>>& segments,
+		 const double tol,
+		 const bool allow_reversal) {
+    endpoint_hash endpoints(tol);
+    for (unsigned i = 0; i < segments.size(); i++) {
+      endpoints.insert(segments[i].first, 2*i);
+      endpoints.insert(segments[i].second, 2*i + 1);
+    }
+
+    std::vector<bool> used(segments.size(), false);
+    const unsigned none = 2*segments.size();
+
+    // Link keys order candidates by index with the unreversed
+    // traversal first, key 2i is segment i as is and 2i + 1 reversed
+    auto link_of = [](const unsigned key) {
+      return chain_link{key / 2, key % 2 == 1};
+    };
+    auto next_after = [&](const point p) {
+      unsigned best = none;
+      endpoints.for_each_near(p, [&](const unsigned id) {
+	  if (used[id / 2] || (id % 2 == 1 && !allow_reversal)) { return; }
+	  best = std::min(best, id);
+	});
+      return best;
+    };
+    auto next_before = [&](const point p) {
+      unsigned best = none;
+      endpoints.for_each_near(p, [&](const unsigned id) {
+	  if (used[id / 2] || (id % 2 == 0 && !allow_reversal)) { return; }
+	  best = std::min(best, id % 2 == 1 ? id - 1 : id + 1);
+	});
+      return best;
+    };
+    auto entry = [&](const chain_link l) {
+      return l.reversed ? segments[l.index].second : segments[l.index].first;
+    };
+    auto exit = [&](const chain_link l) {
+      return l.reversed ? segments[l.index].first : segments[l.index].second;
+    };
+
+    std::vector<segment_chain> chains;
+    for (unsigned i = 0; i < segments.size(); i++) {
+      if (used[i]) { continue; }
+
+      segment_chain chain{{chain_link{i, false}}, false};
+      used[i] = true;
+      point head = segments[i].first;
+
+      chain.closed = within_eps(exit(chain.links.back()), head, tol);
+      while (!chain.closed) {
+	unsigned key = next_after(exit(chain.links.back()));
+	if (key == none) { break; }
+	chain.links.push_back(link_of(key));
+	used[key / 2] = true;
+	chain.closed = within_eps(exit(chain.links.back()), head, tol);
+      }
+
+      if (!chain.closed) {
+	std::vector<chain_link> before;
+	while (true) {
+	  unsigned key = next_before(head);
+	  if (key == none) { break; }
+	  before.push_back(link_of(key));
+	  used[key / 2] = true;
+	  head = entry(before.back());
+	}
+	chain.links.insert(chain.links.begin(), before.rbegin(), before.rend());
+      }
+
+      chains.push_back(chain);
+    }
+
+    return chains;
+  }
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "geometry/point.h"
+
+namespace gca {
+
+  // Buckets points on a grid with cells as wide as the tolerance, so
+  // every point within tolerance of a query lies in one of the 27
+  // cells around it and lookups cost O(1) instead of a scan
+  class endpoint_hash {
+  protected:
+
+    struct cell {
+      long x, y, z;
+
+      bool operator==(const cell& other) const {
+	return x == other.x && y == other.y && z == other.z;
+      }
+    };
+
+    struct cell_hash {
+      size_t operator()(const cell& c) const {
+	size_t h = std::hash<long>()(c.x);
+	h = h*31 + std::hash<long>()(c.y);
+	return h*31 + std::hash<long>()(c.z);
+      }
+    };
+
+    double tolerance;
+    std::unordered_map<cell, std::vector<std::pair<point, unsigned>>, cell_hash> cells;
+
+    cell cell_of(const point p) const;
+
+  public:
+    endpoint_hash(const double tol);
+
+    void insert(const point p, const unsigned id);
+
+    // Calls f on the id of every inserted point within tolerance of p
+    template<typename F>
+    void for_each_near(const point p, F f) const {
+      cell c = cell_of(p);
+      for (long i = c.x - 1; i <= c.x + 1; i++) {
+	for (long j = c.y - 1; j <= c.y + 1; j++) {
+	  for (long k = c.z - 1; k <= c.z + 1; k++) {
+	    auto it = cells.find(cell{i, j, k});
+	    if (it == cells.end()) { continue; }
+	    for (auto& entry : it->second) {
+	      if (within_eps(entry.first, p, tolerance)) {
+		f(entry.second);
+	      }
+	    }
+	  }
+	}
+      }
+    }
+  };
+
+  // Segment index in a chain, reversed segments are traversed from
+  // their end to their start
+  struct chain_link {
+    unsigned index;
+    bool reversed;
+  };
+
+  struct segment_chain {
+    std::vector<chain_link> links;
+
+    // The chain ends within tolerance of where it starts
+    bool closed;
+  };
+
+  // Links segments (start, end) whose endpoints are within tol into
+  // chains in O(n) expected time. Each chain grows from the first
+  // unused segment, forward until it closes or no segment continues
+  // it and then backward from its start. Ties go to the lowest index
+  std::vector<segment_chain>
+  chain_segments(const std::vector<std::pair<point, point>>& segments,
+		 const double tol,
+		 const bool allow_reversal);
+
+}
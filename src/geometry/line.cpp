@@ -28,6 +28,15 @@ namespace gca {
       within_eps(l.end, r.start);
   }
 
+  double distance_to_segment(const point p, const point a, const point b) {
+    point d = b - a;
+    double l2 = d.dot(d);
+    if (l2 == 0.0) { return (p - a).len(); }
+
+    double t = max(0.0, min(1.0, (p - a).dot(d) / l2));
+    return (p - (a + t*d)).len();
+  }
+
   // Returns 1 if the lines intersect, otherwise 0. In addition, if the lines 
   // intersect the intersection point may be stored in the floats i_x and i_y.
   char get_line_intersection(double p0_x, double p0_y, double p1_x, double p1_y, 
@@ -49,6 +49,9 @@ namespace gca {
   bool same_line(const line l, const line r, double tolerance=0.0000001);  
   int count_in(const line l, const vector<line> ls);  
   bool adj_segment(const line l, const line r);  
+
+  // Distance from p to the closest point of the segment from a to b
+  double distance_to_segment(const point p, const point a, const point b);
   ostream& operator<<(ostream& out, line l);
   maybe<point> trim_or_extend(line prev, line next);
   point trim_or_extend_unsafe(line prev, line next);
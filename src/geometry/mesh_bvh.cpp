@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <numeric>
+
+#include "geometry/mesh_bvh.h"
+#include "utils/parallel.h"
+
+namespace gca {
+
+  static const unsigned max_leaf_size = 4;
+
+  mesh_bvh::mesh_bvh(const triangular_mesh& m) {
+    std::vector<index_t> face_inds = m.face_indexes();
+    build(m.triangle_list(), face_inds);
+  }
+
+  mesh_bvh::mesh_bvh(const triangular_mesh& m,
+		     const std::vector<index_t>& face_inds) {
+    std::vector<triangle> input_tris;
+    for (auto i : face_inds) {
+      input_tris.push_back(m.face_triangle(i));
+    }
+    build(input_tris, face_inds);
+  }
+
+  mesh_bvh::mesh_bvh(const std::vector<triangle>& triangles,
+		     const std::vector<index_t>& face_inds) {
+    build(triangles, face_inds);
+  }
+
+  static box triangle_range_bounds(const std::vector<triangle>& input_tris,
+				   const std::vector<unsigned>& order,
+				   const unsigned start,
+				   const unsigned end) {
+    DBG_ASSERT(start < end);
+
+    const triangle& f = input_tris[order[start]];
+    double x_min = f.v1.x, x_max = f.v1.x;
+    double y_min = f.v1.y, y_max = f.v1.y;
+    double z_min = f.v1.z, z_max = f.v1.z;
+
+    for (unsigned i = start; i < end; i++) {
+      const triangle& t = input_tris[order[i]];
+      for (auto p : {t.v1, t.v2, t.v3}) {
+	x_min = min(x_min, p.x);
+	x_max = max(x_max, p.x);
+	y_min = min(y_min, p.y);
+	y_max = max(y_max, p.y);
+	z_min = min(z_min, p.z);
+	z_max = max(z_max, p.z);
+      }
+    }
+
+    // Pad so that hits on faces lying in a box plane are not
+    // rejected by rounding in the slab test
+    double pad = 1e-6*max(1.0, max(x_max - x_min, max(y_max - y_min, z_max - z_min)));
+    return box(x_min - pad, x_max + pad,
+	       y_min - pad, y_max + pad,
+	       z_min - pad, z_max + pad);
+  }
+
+  void mesh_bvh::build(const std::vector<triangle>& input_tris,
+		       const std::vector<index_t>& input_ids) {
+    DBG_ASSERT(input_tris.size() == input_ids.size());
+
+    if (input_tris.size() == 0) { return; }
+
+    std::vector<point> centroids;
+    for (auto& t : input_tris) {
+      centroids.push_back(t.centroid());
+    }
+
+    std::vector<unsigned> order(input_tris.size());
+    std::iota(begin(order), end(order), 0);
+
+    // Build over the input triangles, reading them through order
+    tris = input_tris;
+    build_node(order, centroids, 0, order.size());
+
+    std::vector<triangle> sorted_tris;
+    for (auto i : order) {
+      sorted_tris.push_back(input_tris[i]);
+      face_ids.push_back(input_ids[i]);
+      input_order.push_back(i);
+    }
+    tris = sorted_tris;
+  }
+
+  int mesh_bvh::build_node(std::vector<unsigned>& order,
+			   const std::vector<point>& centroids,
+			   const unsigned start,
+			   const unsigned end) {
+    int node_ind = nodes.size();
+    nodes.push_back(bvh_node(triangle_range_bounds(tris, order, start, end)));
+
+    if (end - start <= max_leaf_size) {
+      nodes[node_ind].start = start;
+      nodes[node_ind].end = end;
+      return node_ind;
+    }
+
+    // Split at the median centroid along the longest axis
+    // of the centroid bounds
+    point c_min = centroids[order[start]];
+    point c_max = c_min;
+    for (unsigned i = start; i < end; i++) {
+      point c = centroids[order[i]];
+      c_min = point(min(c_min.x, c.x), min(c_min.y, c.y), min(c_min.z, c.z));
+      c_max = point(max(c_max.x, c.x), max(c_max.y, c.y), max(c_max.z, c.z));
+    }
+
+    point ext = c_max - c_min;
+    int axis = 0;
+    if (ext.y > ext.x) { axis = 1; }
+    if (ext.z > max(ext.x, ext.y)) { axis = 2; }
+
+    auto coord = [axis](const point p) {
+      return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+    };
+
+    unsigned mid = start + (end - start) / 2;
+    std::nth_element(begin(order) + start,
+		     begin(order) + mid,
+		     begin(order) + end,
+		     [&centroids, coord](const unsigned l, const unsigned r) {
+		       return coord(centroids[l]) < coord(centroids[r]);
+		     });
+
+    int left = build_node(order, centroids, start, mid);
+    int right = build_node(order, centroids, mid, end);
+
+    nodes[node_ind].left = left;
+    nodes[node_ind].right = right;
+
+    return node_ind;
+  }
+
+  // Smallest parameter at which s + t*d, t in [0, 1], is inside b,
+  // false if the segment misses b entirely
+  static bool segment_enters_box(const point s,
+				 const point d,
+				 const box& b,
+				 double* t_enter) {
+    double t0 = 0.0;
+    double t1 = 1.0;
+
+    const double starts[3] = {s.x, s.y, s.z};
+    const double dirs[3] = {d.x, d.y, d.z};
+    const double mins[3] = {b.x_min, b.y_min, b.z_min};
+    const double maxs[3] = {b.x_max, b.y_max, b.z_max};
+
+    for (int a = 0; a < 3; a++) {
+      if (dirs[a] == 0.0) {
+	if (starts[a] < mins[a] || starts[a] > maxs[a]) { return false; }
+	continue;
+      }
+
+      double ta = (mins[a] - starts[a]) / dirs[a];
+      double tb = (maxs[a] - starts[a]) / dirs[a];
+      if (ta > tb) { swap(ta, tb); }
+
+      t0 = max(t0, ta);
+      t1 = min(t1, tb);
+
+      if (t0 > t1) { return false; }
+    }
+
+    *t_enter = t0;
+    return true;
+  }
+
+  // Parameter along l at which l crosses the plane of t
+  static double crossing_parameter(const triangle& t, const line l) {
+    point n = cross(t.v2 - t.v1, t.v3 - t.v1);
+    point d = l.end - l.start;
+    double denom = dot(n, d);
+    if (denom == 0.0) { return 0.0; }
+    return dot(n, t.v1 - l.start) / denom;
+  }
+
+  std::vector<unsigned> mesh_bvh::hit_positions(const line l) const {
+    std::vector<unsigned> hits;
+    if (nodes.size() == 0) { return hits; }
+
+    point d = l.end - l.start;
+
+    std::vector<int> stack{0};
+    while (stack.size() > 0) {
+      const bvh_node& n = nodes[stack.back()];
+      stack.pop_back();
+
+      double t_enter;
+      if (!segment_enters_box(l.start, d, n.bounds, &t_enter)) { continue; }
+
+      if (n.is_leaf()) {
+	for (unsigned i = n.start; i < n.end; i++) {
+	  if (intersects(tris[i], l)) {
+	    hits.push_back(i);
+	  }
+	}
+      } else {
+	stack.push_back(n.left);
+	stack.push_back(n.right);
+      }
+    }
+
+    return hits;
+  }
+
+  std::vector<index_t> mesh_bvh::all_hits(const line l) const {
+    std::vector<unsigned> hits = hit_positions(l);
+
+    sort(begin(hits), end(hits), [this](const unsigned i, const unsigned j) {
+	return input_order[i] < input_order[j];
+      });
+
+    std::vector<index_t> faces;
+    for (auto i : hits) {
+      faces.push_back(face_ids[i]);
+    }
+    return faces;
+  }
+
+  bool mesh_bvh::any_hit(const line l) const {
+    if (nodes.size() == 0) { return false; }
+
+    point d = l.end - l.start;
+
+    std::vector<int> stack{0};
+    while (stack.size() > 0) {
+      const bvh_node& n = nodes[stack.back()];
+      stack.pop_back();
+
+      double t_enter;
+      if (!segment_enters_box(l.start, d, n.bounds, &t_enter)) { continue; }
+
+      if (n.is_leaf()) {
+	for (unsigned i = n.start; i < n.end; i++) {
+	  if (intersects(tris[i], l)) { return true; }
+	}
+      } else {
+	stack.push_back(n.left);
+	stack.push_back(n.right);
+      }
+    }
+
+    return false;
+  }
+
+  boost::optional<index_t> mesh_bvh::first_hit(const line l) const {
+    if (nodes.size() == 0) { return boost::none; }
+
+    point d = l.end - l.start;
+
+    boost::optional<unsigned> best;
+    double best_t = 0.0;
+
+    std::vector<int> stack{0};
+    while (stack.size() > 0) {
+      const bvh_node& n = nodes[stack.back()];
+      stack.pop_back();
+
+      double t_enter;
+      if (!segment_enters_box(l.start, d, n.bounds, &t_enter)) { continue; }
+      if (best && t_enter > best_t) { continue; }
+
+      if (n.is_leaf()) {
+	for (unsigned i = n.start; i < n.end; i++) {
+	  if (!intersects(tris[i], l)) { continue; }
+
+	  double t = crossing_parameter(tris[i], l);
+	  if (!best || t < best_t ||
+	      (t == best_t && input_order[i] < input_order[*best])) {
+	    best = i;
+	    best_t = t;
+	  }
+	}
+      } else {
+	stack.push_back(n.left);
+	stack.push_back(n.right);
+      }
+    }
+
+    if (!best) { return boost::none; }
+
+    return face_ids[*best];
+  }
+
+  std::vector<std::vector<index_t>>
+  mesh_bvh::all_hits(const std::vector<line>& ls) const {
+    return parallel_map(ls, [this](const line l) { return all_hits(l); });
+  }
+
+  std::vector<bool> mesh_bvh::any_hits(const std::vector<line>& ls) const {
+    return parallel_map(ls, [this](const line l) { return any_hit(l); });
+  }
+
+  std::vector<boost::optional<index_t>>
+  mesh_bvh::first_hits(const std::vector<line>& ls) const {
+    return parallel_map(ls, [this](const line l) { return first_hit(l); });
+  }
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "geometry/box.h"
+#include "geometry/line.h"
+#include "geometry/triangle.h"
+#include "geometry/triangular_mesh.h"
+
+namespace gca {
+
+  // Bounding volume hierarchy over the faces of a mesh, answers
+  // segment queries in roughly O(log faces) instead of testing
+  // every face. Hits use the same test as intersects(triangle, line)
+  class mesh_bvh {
+  protected:
+
+    struct bvh_node {
+      box bounds;
+
+      // Child node indexes, both -1 in a leaf
+      int left, right;
+
+      // Range of tris covered by a leaf
+      unsigned start, end;
+
+      bvh_node(const box b) :
+	bounds(b), left(-1), right(-1), start(0), end(0) {}
+
+      inline bool is_leaf() const { return left < 0; }
+    };
+
+    // Triangles in tree order, with the face index and the position
+    // in the input list of each one
+    std::vector<triangle> tris;
+    std::vector<index_t> face_ids;
+    std::vector<unsigned> input_order;
+
+    std::vector<bvh_node> nodes;
+
+    void build(const std::vector<triangle>& input_tris,
+	       const std::vector<index_t>& input_ids);
+
+    int build_node(std::vector<unsigned>& order,
+		   const std::vector<point>& centroids,
+		   const unsigned start,
+		   const unsigned end);
+
+    std::vector<unsigned> hit_positions(const line l) const;
+
+  public:
+    mesh_bvh(const triangular_mesh& m);
+
+    // Only the faces in face_inds are candidates for hits
+    mesh_bvh(const triangular_mesh& m,
+	     const std::vector<index_t>& face_inds);
+
+    mesh_bvh(const std::vector<triangle>& triangles,
+	     const std::vector<index_t>& face_inds);
+
+    inline unsigned num_faces() const { return tris.size(); }
+
+    // Faces by position in tree order, leaves cover contiguous
+    // ranges of positions
+    inline const triangle& tree_triangle(const unsigned i) const
+    { return tris[i]; }
+    inline index_t tree_face(const unsigned i) const
+    { return face_ids[i]; }
+    inline unsigned tree_input_position(const unsigned i) const
+    { return input_order[i]; }
+
+    // Calls f(start, end) with the tree order range of every leaf
+    // whose bounds overlap the rectangle [x_min, x_max] x [y_min, y_max]
+    template<typename F>
+    void for_each_leaf_in_xy(const double x_min, const double x_max,
+			     const double y_min, const double y_max,
+			     F f) const {
+      if (nodes.size() == 0) { return; }
+
+      std::vector<int> stack{0};
+      while (stack.size() > 0) {
+	const bvh_node& n = nodes[stack.back()];
+	stack.pop_back();
+
+	if (n.bounds.x_max < x_min || n.bounds.x_min > x_max ||
+	    n.bounds.y_max < y_min || n.bounds.y_min > y_max) {
+	  continue;
+	}
+
+	if (n.is_leaf()) {
+	  f(n.start, n.end);
+	} else {
+	  stack.push_back(n.left);
+	  stack.push_back(n.right);
+	}
+      }
+    }
+
+    // Every face hit by l, in the order the faces were given
+    std::vector<index_t> all_hits(const line l) const;
+
+    bool any_hit(const line l) const;
+
+    // The face whose crossing is nearest to l.start
+    boost::optional<index_t> first_hit(const line l) const;
+
+    // Batched versions of the queries above, each segment is
+    // answered in parallel and results are in the order of ls
+    std::vector<std::vector<index_t>>
+    all_hits(const std::vector<line>& ls) const;
+
+    std::vector<bool> any_hits(const std::vector<line>& ls) const;
+
+    std::vector<boost::optional<index_t>>
+    first_hits(const std::vector<line>& ls) const;
+  };
+
+}
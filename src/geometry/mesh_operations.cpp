@@ -1,3 +1,5 @@
+#include <numeric>
+
 #include <vtkMassProperties.h>
 #include <vtkSTLWriter.h>
 #include <vtkImplicitDataSet.h>
@@ -33,6 +35,8 @@
 #include "geometry/surface.h"
 #include "geometry/vtk_debug.h"
 #include "geometry/vtk_utils.h"
+#include "utils/instrumentation.h"
+#include "utils/log.h"
 
 namespace gca {
 
@@ -109,6 +113,8 @@ namespace gca {
   }
 
   std::vector<triangle> nef_to_triangle_list(const Nef_polyhedron& p) {
+    count_event("nef_conversions");
+
     //    DBG_DBG_ASSERT(p.is_simple());
 
     Polyhedron poly;
@@ -140,7 +146,9 @@ namespace gca {
   }
   
   Nef_polyhedron trimesh_to_nef_polyhedron(const triangular_mesh& m) {
-    cout << "Converting to nef" << endl;
+    count_event("nef_conversions");
+
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Converting to nef");
     //vtk_debug_mesh(m);
 
     build_mesh<HalfedgeDS> mesh_builder(m);
@@ -152,7 +160,7 @@ namespace gca {
 
     DBG_ASSERT(N.is_simple());
 
-    cout << "Done converting to nef" << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Done converting to nef");
 
     return N.regularization();
   }
@@ -421,6 +429,7 @@ namespace gca {
     auto a_nef = trimesh_to_nef_polyhedron(a);
     auto b_nef = trimesh_to_nef_polyhedron(b);
     auto res = a_nef - b_nef;
+    count_event("nef_booleans");
 
     return nef_polyhedron_to_trimesh(res);
   }
@@ -430,17 +439,84 @@ namespace gca {
     auto a_nef = trimesh_to_nef_polyhedron(a);
     auto b_nef = trimesh_to_nef_polyhedron(b);
     auto res = a_nef.intersection(b_nef);
+    count_event("nef_booleans");
 
     return nef_polyhedron_to_trimesh(res);
   }
 
+  // CGAL is not known to be safe to use from several threads at once
+  // for the lazy exact kernel, so the Nef work below stays serial
+  Nef_polyhedron union_nef_polyhedra(const std::vector<Nef_polyhedron>& nefs) {
+    if (nefs.size() == 0) { return Nef_polyhedron(Nef_polyhedron::EMPTY); }
+
+    count_event("nef_booleans", nefs.size() - 1);
+
+    // Joined as a balanced tree so each join is between operands of
+    // about the same size
+    vector<Nef_polyhedron> level = nefs;
+    while (level.size() > 1) {
+      vector<Nef_polyhedron> next;
+      for (unsigned i = 0; i + 1 < level.size(); i += 2) {
+	next.push_back(level[i].join(level[i + 1]));
+      }
+      if (level.size() % 2 == 1) { next.push_back(level.back()); }
+      level = next;
+    }
+
+    return level.front();
+  }
+
+  // Nef polyhedra of the meshes in bs, each converted the first time
+  // it is needed
+  class subtrahend_set {
+  protected:
+    const std::vector<triangular_mesh>& bs;
+    std::vector<box> b_boxes;
+    std::vector<boost::optional<Nef_polyhedron>> b_nefs;
+
+  public:
+    subtrahend_set(const std::vector<triangular_mesh>& p_bs)
+      : bs(p_bs), b_nefs(p_bs.size()) {
+      for (auto& b : bs) { b_boxes.push_back(b.bounding_box()); }
+    }
+
+    // The union of every mesh whose bounding box overlaps target, so
+    // callers do one difference instead of one per operand
+    boost::optional<Nef_polyhedron> overlapping(const box target) {
+      vector<unsigned> inds(bs.size());
+      std::iota(begin(inds), end(inds), 0);
+      delete_if(inds, [this, target](const unsigned i) {
+	  return !overlap(target, b_boxes[i]);
+	});
+
+      if (inds.size() == 0) { return boost::none; }
+
+      vector<Nef_polyhedron> nefs;
+      for (auto i : inds) {
+	if (!b_nefs[i]) { b_nefs[i] = trimesh_to_nef_polyhedron(bs[i]); }
+	nefs.push_back(*(b_nefs[i]));
+      }
+
+      return union_nef_polyhedra(nefs);
+    }
+  };
+
   std::vector<triangular_mesh>
   boolean_difference(const std::vector<triangular_mesh>& as,
 		     const std::vector<triangular_mesh>& bs) {
+    subtrahend_set subs(bs);
+
     vector<triangular_mesh> res;
+    for (auto& a : as) {
+      Nef_polyhedron a_nef = trimesh_to_nef_polyhedron(a);
 
-    for (auto a : as) {
-      concat(res, boolean_difference(a, bs));
+      auto sub = subs.overlapping(a.bounding_box());
+      if (sub) {
+	a_nef = a_nef - *sub;
+	count_event("nef_booleans");
+      }
+
+      concat(res, nef_polyhedron_to_trimeshes(a_nef));
     }
 
     return res;
@@ -449,25 +525,16 @@ namespace gca {
   std::vector<triangular_mesh>
   boolean_difference(const triangular_mesh& a,
 		     const std::vector<triangular_mesh>& bs) {
-    cout << "Converting a" << endl;
     Nef_polyhedron res = trimesh_to_nef_polyhedron(a);
-    cout << "Done converting a" << endl;
-
-    box a_box = a.bounding_box();
-    
-    for (auto b : bs) {
-      box b_box = b.bounding_box();
 
-      if (overlap(a_box, b_box)) {
-	Nef_polyhedron b_nef = trimesh_to_nef_polyhedron(b);
-
-	res = res - b_nef;
-      }
+    subtrahend_set subs(bs);
+    auto sub = subs.overlapping(a.bounding_box());
+    if (sub) {
+      res = res - *sub;
+      count_event("nef_booleans");
     }
 
-    auto result_meshes = nef_polyhedron_to_trimeshes(res);
-
-    return result_meshes;
+    return nef_polyhedron_to_trimeshes(res);
   }
 
   // TODO: Delete? Not sure this is ever used
@@ -536,12 +603,14 @@ namespace gca {
   
   exact_volume exact_volume::subtract(const exact_volume& other) const {
     Nef_polyhedron n = impl->nef - other.impl->nef;
+    count_event("nef_booleans");
     volume_impl* impl = new volume_impl(n);
     return exact_volume(impl);
   }
 
   exact_volume exact_volume::intersection(const exact_volume& other) const {
     Nef_polyhedron n = (impl->nef).intersection(other.impl->nef);
+    count_event("nef_booleans");
     volume_impl* impl = new volume_impl(n);
     return exact_volume(impl);
   }
@@ -58,6 +58,8 @@ namespace gca {
   boost::optional<triangular_mesh>
   boolean_intersection(const triangular_mesh& a, const triangular_mesh& b);
 
+  // Operands whose bounding boxes miss a are skipped, the rest are
+  // unioned in a balanced tree and subtracted once
   std::vector<triangular_mesh>
   boolean_difference(const triangular_mesh& a,
 		     const std::vector<triangular_mesh>& bs);
@@ -67,6 +69,8 @@ namespace gca {
 
   double volume(const triangular_mesh& m);
 
+  // Each mesh in as is pruned against bs separately, the meshes of
+  // bs are converted to Nef polyhedra at most once
   std::vector<triangular_mesh>
   boolean_difference(const std::vector<triangular_mesh>& as,
 		     const std::vector<triangular_mesh>& bs);
@@ -75,6 +79,8 @@ namespace gca {
 
   Nef_polyhedron trimesh_to_nef_polyhedron(const triangular_mesh& m);
 
+  Nef_polyhedron union_nef_polyhedra(const std::vector<Nef_polyhedron>& nefs);
+
   triangular_mesh nef_to_single_merged_trimesh(const Nef_polyhedron& nef);
 
 }
@@ -0,0 +1,153 @@
+#include <unordered_map>
+
+#include "geometry/nef_cache.h"
+
+namespace gca {
+
+  struct mesh_nef_entry {
+    std::vector<point> vertices;
+    std::vector<triangle_t> triangles;
+    Nef_polyhedron nef;
+  };
+
+  struct nef_meshes_entry {
+    Nef_polyhedron nef;
+    std::vector<triangular_mesh> meshes;
+  };
+
+  struct nef_volume_entry {
+    Nef_polyhedron nef;
+    double volume;
+  };
+
+  static std::unordered_multimap<size_t, mesh_nef_entry> mesh_nef_cache;
+  static std::unordered_map<size_t, nef_meshes_entry> nef_meshes_cache;
+  static std::unordered_map<size_t, nef_volume_entry> nef_volume_cache;
+  static nef_cache_stats cache_stats;
+
+  static inline void hash_combine(size_t& seed, const size_t v) {
+    seed ^= v + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+
+  size_t mesh_content_hash(const triangular_mesh& m) {
+    std::hash<double> double_hash;
+    std::hash<index_t> index_hash;
+
+    size_t h = m.vertex_list().size();
+    for (auto& p : m.vertex_list()) {
+      hash_combine(h, double_hash(p.x));
+      hash_combine(h, double_hash(p.y));
+      hash_combine(h, double_hash(p.z));
+    }
+
+    for (auto& t : m.triangle_verts()) {
+      hash_combine(h, index_hash(t.v[0]));
+      hash_combine(h, index_hash(t.v[1]));
+      hash_combine(h, index_hash(t.v[2]));
+    }
+
+    return h;
+  }
+
+  static bool same_triangles(const std::vector<triangle_t>& l,
+			     const std::vector<triangle_t>& r) {
+    if (l.size() != r.size()) { return false; }
+
+    for (unsigned i = 0; i < l.size(); i++) {
+      if (l[i].v[0] != r[i].v[0] ||
+	  l[i].v[1] != r[i].v[1] ||
+	  l[i].v[2] != r[i].v[2]) {
+	return false;
+      }
+    }
+
+    return true;
+  }
+
+  Nef_polyhedron cached_trimesh_to_nef_polyhedron(const triangular_mesh& m) {
+    size_t h = mesh_content_hash(m);
+    std::vector<triangle_t> tris = m.triangle_verts();
+
+    auto candidates = mesh_nef_cache.equal_range(h);
+    for (auto it = candidates.first; it != candidates.second; it++) {
+      const mesh_nef_entry& e = it->second;
+      if (elems_equal(e.vertices, m.vertex_list()) &&
+	  same_triangles(e.triangles, tris)) {
+	cache_stats.mesh_to_nef_hits++;
+	return e.nef;
+      }
+    }
+
+    cache_stats.mesh_to_nef_misses++;
+
+    Nef_polyhedron nef = trimesh_to_nef_polyhedron(m);
+    mesh_nef_cache.insert(std::make_pair(h, mesh_nef_entry{m.vertex_list(), tris, nef}));
+    return nef;
+  }
+
+  std::vector<triangular_mesh>
+  cached_nef_polyhedron_to_trimeshes(const Nef_polyhedron& p) {
+    auto it = nef_meshes_cache.find(p.id());
+    if (it != end(nef_meshes_cache) && it->second.nef.identical(p)) {
+      cache_stats.nef_to_mesh_hits++;
+      return it->second.meshes;
+    }
+
+    cache_stats.nef_to_mesh_misses++;
+
+    std::vector<triangular_mesh> meshes = nef_polyhedron_to_trimeshes(p);
+    nef_meshes_cache[p.id()] = nef_meshes_entry{p, meshes};
+    return meshes;
+  }
+
+  triangular_mesh cached_nef_to_single_trimesh(const Nef_polyhedron& p) {
+    std::vector<triangular_mesh> meshes = cached_nef_polyhedron_to_trimeshes(p);
+
+    // Let the uncached version report the error
+    if (meshes.size() != 1) {
+      return nef_to_single_trimesh(p);
+    }
+
+    return meshes.front();
+  }
+
+  double cached_nef_volume(const Nef_polyhedron& p) {
+    auto it = nef_volume_cache.find(p.id());
+    if (it != end(nef_volume_cache) && it->second.nef.identical(p)) {
+      cache_stats.volume_hits++;
+      return it->second.volume;
+    }
+
+    cache_stats.volume_misses++;
+
+    double vol = 0.0;
+    for (auto& m : cached_nef_polyhedron_to_trimeshes(p)) {
+      vol += volume(m);
+    }
+
+    nef_volume_cache[p.id()] = nef_volume_entry{p, vol};
+    return vol;
+  }
+
+  nef_cache_stats nef_cache_statistics() {
+    return cache_stats;
+  }
+
+  void clear_nef_cache() {
+    mesh_nef_cache.clear();
+    nef_meshes_cache.clear();
+    nef_volume_cache.clear();
+    cache_stats = nef_cache_stats();
+  }
+
+  std::ostream& operator<<(std::ostream& out, const nef_cache_stats& s) {
+    out << "mesh -> nef hits   = " << s.mesh_to_nef_hits << endl;
+    out << "mesh -> nef misses = " << s.mesh_to_nef_misses << endl;
+    out << "nef -> mesh hits   = " << s.nef_to_mesh_hits << endl;
+    out << "nef -> mesh misses = " << s.nef_to_mesh_misses << endl;
+    out << "nef volume hits    = " << s.volume_hits << endl;
+    out << "nef volume misses  = " << s.volume_misses;
+    return out;
+  }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <iostream>
+
+#include "geometry/mesh_operations.h"
+
+namespace gca {
+
+  struct nef_cache_stats {
+    int mesh_to_nef_hits, mesh_to_nef_misses;
+    int nef_to_mesh_hits, nef_to_mesh_misses;
+    int volume_hits, volume_misses;
+
+    nef_cache_stats() :
+      mesh_to_nef_hits(0), mesh_to_nef_misses(0),
+      nef_to_mesh_hits(0), nef_to_mesh_misses(0),
+      volume_hits(0), volume_misses(0) {}
+  };
+
+  // Memoized versions of the mesh <-> Nef_polyhedron conversions.
+  // Meshes are keyed by a hash of their vertices and triangles,
+  // Nef polyhedra by the identity of their shared representation,
+  // which the cache keeps alive so it cannot be reused.
+  //
+  // The cache is not locked and must only be used from one thread
+  // at a time. Nef polyhedra share their representations through
+  // reference counts that are not atomic either, so a lock would not
+  // make it safe to hand cached values to workers
+  Nef_polyhedron cached_trimesh_to_nef_polyhedron(const triangular_mesh& m);
+
+  std::vector<triangular_mesh>
+  cached_nef_polyhedron_to_trimeshes(const Nef_polyhedron& p);
+
+  triangular_mesh cached_nef_to_single_trimesh(const Nef_polyhedron& p);
+
+  // Sum of the volumes of the meshes in p
+  double cached_nef_volume(const Nef_polyhedron& p);
+
+  size_t mesh_content_hash(const triangular_mesh& m);
+
+  nef_cache_stats nef_cache_statistics();
+
+  void clear_nef_cache();
+
+  std::ostream& operator<<(std::ostream& out, const nef_cache_stats& s);
+
+}
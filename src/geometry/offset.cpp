@@ -4,10 +4,12 @@
 #include "geometry/ring.h"
 #include "geometry/rotation.h"
 
+#include <CGAL/create_straight_skeleton_2.h>
 #include <CGAL/create_offset_polygons_2.h>
 #include <CGAL/create_offset_polygons_from_polygon_with_holes_2.h>
 
 #include "geometry/vtk_debug.h"
+#include "utils/instrumentation.h"
 
 namespace gca {
 
@@ -104,6 +106,7 @@ namespace gca {
   std::vector<oriented_polygon> exterior_offset(const oriented_polygon& q,
 						const double inc) {
     DBG_ASSERT(q.vertices().size() > 0);
+    count_event("offsets");
 
     oriented_polygon p;
     if (signed_area(q) < 0) {
@@ -151,6 +154,7 @@ namespace gca {
 						const double inc) {
 
     DBG_ASSERT(p.vertices().size() > 0);
+    count_event("offsets");
 
     check_simplicity(p);
 
@@ -441,130 +445,139 @@ namespace gca {
   }
   
 
-  polygon_3 exterior_offset_flat(const polygon_3& poly,
-				 const double d) {
-    DBG_ASSERT(angle_eps(poly.normal(), point(0, 0, 1), 0.0, 1.0));
-    DBG_ASSERT(poly.vertices().size() >= 3);
+  // Straight skeletons of a polygon rotated into the xy plane, the
+  // exterior skeleton of the outer ring and the interior skeleton of
+  // each hole. Every exterior offset of the polygon up to the max
+  // offset the outer skeleton was built with can be read off of them
+  struct offset_skeletons {
+    rotation r_inv;
+    point normal;
+    double z_level;
+    SsPtr outer;
+    std::vector<SsPtr> holes;
+  };
+
+  std::shared_ptr<offset_skeletons>
+  build_offset_skeletons(const polygon_3& poly,
+			 const double max_offset) {
+    point n(0, 0, 1);
+    const rotation r = rotate_from_to(poly.normal(), n);
 
-    double z_level = poly.vertices().front().z;
+    polygon_3 r_poly = apply(r, poly);
 
-    Polygon_2 outer;
-    for (auto p : poly.vertices()) {
-      outer.push_back(Point(p.x, p.y));
-    }
+    check_simplicity(r_poly);
+
+    DBG_ASSERT(angle_eps(r_poly.normal(), n, 0.0, 1.0));
+    DBG_ASSERT(r_poly.vertices().size() >= 3);
 
+    Polygon_2 outer = CGAL_polygon_for_points(r_poly.vertices());
     set_orientation(outer);
 
-    PolygonPtrVector offset_poly_with_holes =
-      create_exterior_skeleton_and_offset_polygons_2(d, outer);
+    SsPtr outer_ss = CGAL::create_exterior_straight_skeleton_2(max_offset, outer);
+    DBG_ASSERT(outer_ss);
 
-    DBG_ASSERT(offset_poly_with_holes.size() > 1);
+    vector<SsPtr> hole_skeletons;
+    for (auto h : r_poly.holes()) {
+      polygon_3 hole_polygon =
+	clean_polygon_for_offsetting(build_clean_polygon_3(h));
 
-    offset_poly_with_holes.erase(begin(offset_poly_with_holes));
+      Polygon_2 hole = CGAL_polygon_for_points(hole_polygon.vertices());
+      set_orientation(hole);
 
-    vector<vector<point>> pts;
+      SsPtr hole_ss = CGAL::create_interior_straight_skeleton_2(hole);
+      DBG_ASSERT(hole_ss);
 
-    for (PolygonPtr& p : offset_poly_with_holes) {
-      pts.push_back(clean_ring_for_offsetting(ring_for_CGAL_polygon(*p, z_level)));
+      hole_skeletons.push_back(hole_ss);
     }
 
-    vector<polygon_3> result_polys = arrange_rings(pts);
+    return std::shared_ptr<offset_skeletons>(
+      new offset_skeletons{inverse(r),
+	  poly.normal(),
+	  r_poly.vertices().front().z,
+	  outer_ss,
+	  hole_skeletons});
+  }
 
-    DBG_ASSERT(result_polys.size() == 1);
+  polygon_3 exterior_offset(const offset_skeletons& s,
+			    const double d) {
+    count_event("offsets");
+
+    PolygonPtrVector offset_polys =
+      CGAL::create_offset_polygons_2<Polygon_2>(d, *(s.outer));
+
+    DBG_ASSERT(offset_polys.size() > 1);
+
+    // The largest contour is the offset of the frame CGAL places
+    // around the polygon to build the exterior skeleton
+    auto frame =
+      max_element(begin(offset_polys), end(offset_polys),
+		  [](const PolygonPtr& l, const PolygonPtr& r) {
+		    return fabs(l->area()) < fabs(r->area());
+		  });
+    offset_polys.erase(frame);
+
+    vector<vector<point>> pts;
+    for (PolygonPtr& p : offset_polys) {
+      pts.push_back(clean_ring_for_offsetting(ring_for_CGAL_polygon(*p, s.z_level)));
+    }
 
-    polygon_3 result_poly = result_polys.front();
+    vector<polygon_3> result_polys = arrange_rings(pts);
 
-    // // NOTE: Assumes the 2nd polygon returned by CGAL is always the exteriormost
-    // // ring of the exterior offset after the containing rectangle
-    // vector<point> outer_ring =
-    //   ring_for_CGAL_polygon(*(offset_poly_with_holes.front()), z_level);
+    DBG_ASSERT(result_polys.size() == 1);
 
-    boost_poly_2 outer_poly = to_boost_poly_2(result_poly);
+    boost_poly_2 outer_poly = to_boost_poly_2(result_polys.front());
 
     boost_multipoly_2 holes_to_subtract;
-    for (auto h : poly.holes()) {
-      polygon_3 hole_polygon = build_clean_polygon_3(h);
-      vector<polygon_3> hole_interior_offsets =
-	interior_offset({hole_polygon}, d);
+    for (auto& hole_ss : s.holes) {
+      PolygonPtrVector hole_offsets =
+	CGAL::create_offset_polygons_2<Polygon_2>(d, *hole_ss);
+
+      vector<vector<point>> hole_pts;
+      for (PolygonPtr& p : hole_offsets) {
+	auto r_new =
+	  clean_ring_for_offsetting_no_fail(ring_for_CGAL_polygon(*p, s.z_level));
+
+	if (r_new.size() >= 3) {
+	  check_simplicity(r_new);
+	  hole_pts.push_back(r_new);
+	}
+      }
 
-      for (polygon_3& hole_poly : hole_interior_offsets) {
+      for (polygon_3& hole_poly : arrange_rings(hole_pts)) {
 	DBG_ASSERT(hole_poly.holes().size() == 0);
 
 	holes_to_subtract.push_back(to_boost_poly_2(hole_poly));
       }
     }
 
-    // for (unsigned i = 1; i < offset_poly_with_holes.size(); i++) {
-    //   vector<point> h_ring =
-    // 	ring_for_CGAL_polygon(*(offset_poly_with_holes[i]), z_level);
-
-    //   holes_to_subtract.push_back(to_boost_poly_2(h_ring));
-    // }
-
     boost_multipoly_2 ext_offset;
     bg::difference(outer_poly, holes_to_subtract, ext_offset);
 
     if (!(ext_offset.size() == 1)) {
       cout << "OFFSETTING POLYGON BY " << d << endl;
       cout << "ext_offset.size() = " << ext_offset.size() << endl;
-      vtk_debug_polygon(poly);
 
       cout << "OFFSET RESULTS" << endl;
-      for (auto r : offset_poly_with_holes) {
+      for (auto r : offset_polys) {
 	vector<point> outer_ring =
-	  ring_for_CGAL_polygon(*r, z_level);
+	  ring_for_CGAL_polygon(*r, s.z_level);
 	vtk_debug_ring(outer_ring);
-
       }
 
       DBG_ASSERT(ext_offset.size() == 1);
     }
 
-    polygon_3 exterior_poly = to_polygon_3(z_level, ext_offset.front());
+    polygon_3 exterior_poly = to_polygon_3(s.z_level, ext_offset.front());
 
-    return exterior_poly;
-    
-    // TODO: Convert result of outer exterior offset into a boost polygon,
-    // do interior offsets of holes, convert results to boost polygons and
-    // then subtract them from original result
-
-    //DBG_ASSERT(false);
-
-    // vector<polygon_3> result_polys;
-
-    // for (PolygonWithHolesPtr& p : offset_poly_with_holes) {
-    //   PolygonWithHoles& pg = *p;
-    //   Polygon_2 outer = pg.outer_boundary();
-    //   vector<point> outer_pts = ring_for_CGAL_polygon(outer, z_level);
+    polygon_3 final_res = apply(s.r_inv, exterior_poly);
+    final_res.correct_winding_order(s.normal);
 
-    //   vector<vector<point>> holes;
-    //   for (auto it = pg.holes_begin(); it != pg.holes_end(); ++it) {
-    // 	Polygon_2& cgal_hole = *it;
-    // 	holes.push_back(ring_for_CGAL_polygon(cgal_hole, z_level));
-    //   }
-
-    //   result_polys.push_back(polygon_3(outer_pts, holes));
-    // }
-
-    // return result_polys;
+    return final_res;
   }
 
   polygon_3 exterior_offset(const polygon_3& poly,
   			    const double d) {
-    point n(0, 0, 1);
-    const rotation r = rotate_from_to(poly.normal(), n);
-    const rotation r_inv = inverse(r);
-
-    polygon_3 r_poly = apply(r, poly);
-
-    check_simplicity(r_poly);
-
-    polygon_3 res = exterior_offset_flat(r_poly, d);
-
-    polygon_3 final_res = apply(r_inv, res);
-    final_res.correct_winding_order(poly.normal());
-
-    return final_res;
+    return exterior_offset(*build_offset_skeletons(poly, d), d);
   }
   
   std::vector<polygon_3> exterior_offset(const std::vector<polygon_3>& polys,
@@ -577,11 +590,31 @@ namespace gca {
     return planar_polygon_union(exter_offsets);
   }
 
+  exterior_offset_rings::exterior_offset_rings(const std::vector<polygon_3>& polys,
+					       const double p_max_offset) :
+    max_offset(p_max_offset) {
+    for (auto& poly : polys) {
+      skeletons.push_back(build_offset_skeletons(poly, max_offset));
+    }
+  }
+
+  std::vector<polygon_3> exterior_offset_rings::at(const double d) const {
+    DBG_ASSERT(d <= max_offset);
+
+    vector<polygon_3> exter_offsets;
+    for (auto& s : skeletons) {
+      exter_offsets.push_back(exterior_offset(*s, d));
+    }
+
+    return planar_polygon_union(exter_offsets);
+  }
+
   std::vector<polygon_3> interior_offsets_flat(const polygon_3& ply,
 					       const double d) {
 
     DBG_ASSERT(angle_eps(ply.normal(), point(0, 0, 1), 0.0, 1.0));
     DBG_ASSERT(ply.vertices().size() >= 3);
+    count_event("offsets");
 
     polygon_3 poly = clean_polygon_for_offsetting(ply);
 
@@ -1,6 +1,8 @@
 #ifndef GCA_OFFSET_H
 #define GCA_OFFSET_H
 
+#include <memory>
+
 #include <boost/shared_ptr.hpp>
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
@@ -53,6 +55,27 @@ namespace gca {
   std::vector<polygon_3> interior_offset(const std::vector<polygon_3>& polys,
 					 const double d);
 
+  struct offset_skeletons;
+
+  // Exterior offsets of a set of polygons at any distance up to
+  // max_offset. The straight skeletons are built once and each
+  // offset is read off of them, rather than rebuilding them for
+  // every distance as exterior_offset does
+  class exterior_offset_rings {
+  protected:
+    double max_offset;
+    std::vector<std::shared_ptr<offset_skeletons>> skeletons;
+
+  public:
+    exterior_offset_rings(const std::vector<polygon_3>& polys,
+			  const double max_offset);
+
+    inline double max_distance() const { return max_offset; }
+
+    // Same rings as exterior_offset(polys, d)
+    std::vector<polygon_3> at(const double d) const;
+  };
+
 }
 
 #endif
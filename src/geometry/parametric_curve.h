@@ -1,65 +1,78 @@
 #ifndef GCA_PARAMETRIC_CURVE_H
 #define GCA_PARAMETRIC_CURVE_H
 
+#include <new>
+
+#include "geometry/arc.h"
+#include "geometry/line.h"
 #include "utils/check.h"
 
 namespace gca {
 
+  // Cuts only ever follow lines and arcs (helical cuts keep a line and
+  // add the helix on top), so the curve is a closed variant stored
+  // inline. Copies are plain memberwise copies and value() is a switch
+  // instead of a heap allocated model behind a virtual call
   class parametric_curve {
-  private:
-    struct concept_t {
-      virtual ~concept_t() = default;
-      virtual concept_t* copy() const = 0;
-      virtual point value(double t) const = 0;
-      virtual parametric_curve shift(point t) const = 0;
-      virtual parametric_curve scale(double t) const = 0;
-      virtual parametric_curve scale_xy(double t) const = 0;
-      virtual parametric_curve reflect_x() const = 0;
-    };
+  public:
+    enum curve_kind { LINE, ARC };
 
-    template<typename T>
-    struct model : concept_t {
-      T data;
-      model(T x) : data(move(x)) {}
-      virtual concept_t* copy() const { return new model<T>(*this); }
-      virtual point value(double t) const { return data.value(t); }
-      virtual parametric_curve shift(point t) const { return data.shift(t); }
-      virtual parametric_curve scale(double t) const { return data.scale(t); }
-      virtual parametric_curve scale_xy(double t) const { return data.scale_xy(t); }
-      virtual parametric_curve reflect_x() const { return data.reflect_x(); }
+  private:
+    curve_kind k;
+    union {
+      line l;
+      arc a;
     };
-  
-    unique_ptr<concept_t> self;
 
   public:
-    template<typename T>
-    parametric_curve(T x) : self(new model<T>(move(x))) {}
-    parametric_curve(const parametric_curve& x) : self(x.self->copy()) {}
-    parametric_curve(parametric_curve&&) noexcept = default;
+    parametric_curve(const line& x) : k(LINE), l(x) {}
+    parametric_curve(const arc& x) : k(ARC), a(x) {}
 
-    parametric_curve& operator=(const parametric_curve& x)
-    { parametric_curve tmp(x); *this = move(tmp); return *this; }
+    parametric_curve(const parametric_curve& x) : k(x.k) {
+      if (k == LINE) { new (&l) line(x.l); }
+      else { new (&a) arc(x.a); }
+    }
+
+    parametric_curve& operator=(const parametric_curve& x) {
+      k = x.k;
+      if (k == LINE) { new (&l) line(x.l); }
+      else { new (&a) arc(x.a); }
+      return *this;
+    }
+
+    inline curve_kind kind() const { return k; }
 
-    parametric_curve& operator=(parametric_curve&&) noexcept = default;
-    
     inline point value(double t) const
-    { return self->value(t); }
-
-    virtual parametric_curve shift(point t) const
-    { return self->shift(t); }
-    virtual parametric_curve scale(double t) const
-    { return self->scale(t); }
-    virtual parametric_curve scale_xy(double t) const
-    { return self->scale_xy(t); }
-
-    virtual parametric_curve reflect_x() const
-    { return self->reflect_x(); }
-    
-    template<typename T>
-    T& get_obj() {
-      concept_t* cptr = self.get();
-      parametric_curve::model<T>* mt = static_cast<parametric_curve::model<T>*>(cptr);
-      return mt->data;
+    { return k == LINE ? l.value(t) : a.value(t); }
+
+    inline parametric_curve shift(point t) const {
+      if (k == LINE) { return l.shift(t); }
+      return a.shift(t);
+    }
+
+    inline parametric_curve scale(double t) const {
+      if (k == LINE) { return l.scale(t); }
+      return a.scale(t);
+    }
+
+    inline parametric_curve scale_xy(double t) const {
+      if (k == LINE) { return l.scale_xy(t); }
+      return a.scale_xy(t);
+    }
+
+    inline parametric_curve reflect_x() const {
+      if (k == LINE) { return l.reflect_x(); }
+      return a.reflect_x();
+    }
+
+    const line& get_line() const {
+      DBG_ASSERT(k == LINE);
+      return l;
+    }
+
+    const arc& get_arc() const {
+      DBG_ASSERT(k == ARC);
+      return a;
     }
   };
 
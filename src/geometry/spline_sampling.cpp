@@ -1,22 +1,73 @@
+#include <algorithm>
+
+#include "geometry/line.h"
 #include "geometry/spline_sampling.h"
 
 namespace gca {
-  
-  void append_spline(const b_spline* s,
-		     vector<polyline>& polys) {
-    // TODO: Come up with a better sampling strategy
-    unsigned points_per_spline = 100;
-    double next = 0.0;
-    double inc = 1.0 / points_per_spline;
-    vector<point> pts;
-    for (unsigned i = 1; i < points_per_spline; i++) {
-      next = next + inc;
-      pts.push_back(s->eval(next));
+
+  // Deep enough to resolve a 1 inch span to about 1e-5 inches
+  static const int max_flattening_depth = 16;
+
+  // Appends the points after s(a) up to and including s(b). The chord
+  // is checked at three interior samples so that a span curving back
+  // across its chord is still split
+  static void flatten_span(const b_spline* s,
+			   const double a,
+			   const point pa,
+			   const double b,
+			   const point pb,
+			   const double tolerance,
+			   const int depth,
+			   vector<point>& pts) {
+    double m = (a + b) / 2.0;
+    point pm = s->eval(m);
+
+    bool flat = depth >= max_flattening_depth;
+    if (!flat) {
+      double q1 = (3*a + b) / 4.0;
+      double q3 = (a + 3*b) / 4.0;
+      flat = distance_to_segment(pm, pa, pb) <= tolerance &&
+	distance_to_segment(s->eval(q1), pa, pb) <= tolerance &&
+	distance_to_segment(s->eval(q3), pa, pb) <= tolerance;
     }
-    polys.push_back(polyline(pts));
+
+    if (flat) {
+      pts.push_back(pb);
+      return;
+    }
+
+    flatten_span(s, a, pa, m, pm, tolerance, depth + 1, pts);
+    flatten_span(s, m, pm, b, pb, tolerance, depth + 1, pts);
   }
-  
+
+  vector<point> flatten_spline(const b_spline* s, const double tolerance) {
+    DBG_ASSERT(tolerance > 0.0);
+
+    // Each knot span is a single polynomial piece, flattening them
+    // separately keeps a piece from hiding behind its neighbors
+    vector<double> breaks;
+    for (unsigned i = s->find_span(s->start_param());
+	 i <= s->find_span(s->end_param()); i++) {
+      breaks.push_back(s->knot(i));
+    }
+    breaks.push_back(s->end_param());
+
+    vector<point> pts{s->eval(breaks.front())};
+    for (unsigned i = 0; i + 1 < breaks.size(); i++) {
+      double a = breaks[i];
+      double b = breaks[i + 1];
+      if (b <= a) { continue; }
+      flatten_span(s, a, pts.back(), b, s->eval(b), tolerance, 0, pts);
+    }
+    return pts;
+  }
+
   void append_splines(const vector<b_spline*>& splines,
-		      vector<polyline>& polys)
-  { for (auto s : splines) { append_spline(s, polys); } }
+		      vector<polyline>& polys,
+		      const double tolerance) {
+    for (auto s : splines) {
+      polys.push_back(polyline(flatten_spline(s, tolerance)));
+    }
+  }
+
 }
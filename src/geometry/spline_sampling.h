@@ -5,9 +5,14 @@
 #include "geometry/polyline.h"
 
 namespace gca {
-  
+
+  // Points along s such that no chord between neighbors strays more
+  // than tolerance from the curve
+  vector<point> flatten_spline(const b_spline* s, const double tolerance);
+
   void append_splines(const vector<b_spline*>& splines,
-		      vector<polyline>& polys);
+		      vector<polyline>& polys,
+		      const double tolerance = 0.001);
   
 }
 
@@ -2,6 +2,7 @@
 #include "geometry/vtk_debug.h"
 #include "geometry/winding_order.h"
 #include "utils/algorithm.h"
+#include "utils/log.h"
 
 namespace gca {
 
@@ -167,7 +168,7 @@ namespace gca {
 
     }
 
-    cout << "Deleted " << inds_removed << " hanging triangles" << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Deleted " << inds_removed << " hanging triangles");
   }
   
   void
@@ -195,7 +196,7 @@ namespace gca {
 
     }
 
-    cout << "Deleted " << inds_removed << " degenerate triangles" << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Deleted " << inds_removed << " degenerate triangles");
   }
 
   void
@@ -223,7 +224,7 @@ namespace gca {
 
     }
 
-    cout << "Deleted " << inds_removed << " duplicate triangles" << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Deleted " << inds_removed << " duplicate triangles");
   }
   
   void
@@ -245,10 +246,10 @@ namespace gca {
 
       if (neighbors.size() != 3) {
 
-	cout << "ERROR: Non manifold triangle " << t << endl;
-	cout << " has " << neighbors.size() << " neighbors" << endl;
+	GCA_LOG_ERROR(GEOMETRY_LOG, "Non manifold triangle " << t);
+	GCA_LOG_ERROR(GEOMETRY_LOG, " has " << neighbors.size() << " neighbors");
 	for (auto r : neighbors) {
-	  cout << r << endl;
+	  GCA_LOG_ERROR(GEOMETRY_LOG, r);
 	}
 
 	DBG_ASSERT(false);
@@ -315,10 +316,10 @@ namespace gca {
 
     int wind_errs = num_winding_order_errors(vertex_triangles);
     if (wind_errs > 0) {
-      cout << "Num winding errors = " << wind_errs << endl;
+      GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors = " << wind_errs);
       auto fixed_triangles = fix_winding_order_errors(vertex_triangles);
       int new_wind_errs = num_winding_order_errors(fixed_triangles);
-      cout << "Num winding errors after fixing = " << new_wind_errs << endl;
+      GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors after fixing = " << new_wind_errs);
       DBG_ASSERT(new_wind_errs == 0);
       return fixed_triangles;
     }
@@ -369,8 +370,8 @@ namespace gca {
 
       point fi = (face_orientations[i]).normalize();
       if (!angle_eps(fi, computed_normal, 0.0, 0.5)) {
-	cout << "Computed normal = " << computed_normal << endl;
-	cout << "Listed normal   = " << fi << endl;
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Computed normal = " << computed_normal);
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Listed normal   = " << fi);
 
 	return false;
       }
@@ -393,8 +394,8 @@ namespace gca {
 
       point fi = (face_orientations[i]).normalize();
       if (!angle_eps(fi, computed_normal, 0.0, 0.5)) {
-	cout << "Computed normal = " << computed_normal << endl;
-	cout << "Listed normal   = " << fi << endl;
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Computed normal = " << computed_normal);
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Listed normal   = " << fi);
 
 	return false;
       }
@@ -414,9 +415,9 @@ namespace gca {
   correct_winding_and_build(std::vector<triangle_t>& vertex_triangles,
 			    const std::vector<point>& vertices,
 			    const std::vector<point>& face_orientations) {
-    cout << "Correcting order and building" << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Correcting order and building");
     if (!all_normals_consistent(vertex_triangles, vertices, face_orientations)) {
-      cout << "Flipped winding order!" << endl;
+      GCA_LOG_DEBUG(GEOMETRY_LOG, "Flipped winding order!");
       vertex_triangles = flip_winding_orders(vertex_triangles);
     }
 
@@ -431,9 +432,9 @@ namespace gca {
       connected_components_by_elems(vertex_triangles, [](const triangle_t l, const triangle_t r)
 				    { return share_edge(l, r); });
 
-    cout << "# of comps = " << initial_comps.size() << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "# of comps = " << initial_comps.size());
     for (auto c : initial_comps) {
-      cout << c.size() << endl;
+      GCA_LOG_DEBUG(GEOMETRY_LOG, c.size());
     }
 
     if (initial_comps.size() > 1) {
@@ -464,7 +465,7 @@ namespace gca {
     delete_degenerate_triangles(vertex_triangles, vertices, face_orientations);
     delete_hanging_triangles(vertex_triangles, vertices, face_orientations);
 
-    cout << "# of triangles left = " << vertex_triangles.size() << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "# of triangles left = " << vertex_triangles.size());
 
     if (vertex_triangles.size() == 0) { return {}; }
 
@@ -492,7 +493,7 @@ namespace gca {
   std::vector<triangular_mesh>
   make_meshes(const std::vector<triangle>& triangles,
 	      double tolerance) {
-    cout << "# of triangles = " << triangles.size() << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "# of triangles = " << triangles.size());
 
     DBG_ASSERT(triangles.size() > 0);
 
@@ -514,12 +515,12 @@ namespace gca {
       int wind_errs = num_winding_order_errors(c);
       if (wind_errs > 0) {
 
-	cout << "Num winding errors = " << wind_errs << endl;
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors = " << wind_errs);
 
 	auto fixed_triangles = fix_winding_order_errors(c);
 	int new_wind_errs = num_winding_order_errors(fixed_triangles);
 
-	cout << "Num winding errors after fixing = " << new_wind_errs << endl;
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors after fixing = " << new_wind_errs);
 
 	DBG_ASSERT(new_wind_errs == 0);
 
@@ -540,7 +541,7 @@ namespace gca {
   
   triangular_mesh make_mesh(const std::vector<triangle>& triangles,
 			    double tolerance) {
-    cout << "# of triangles = " << triangles.size() << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "# of triangles = " << triangles.size());
 
     DBG_ASSERT(triangles.size() > 0);
 
@@ -559,7 +560,7 @@ namespace gca {
     delete_degenerate_triangles(vertex_triangles, vertices, face_orientations);
     delete_hanging_triangles(vertex_triangles, vertices, face_orientations);
 
-    cout << "# of triangles left = " << vertex_triangles.size() << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "# of triangles left = " << vertex_triangles.size());
 
     check_degenerate_triangles(vertex_triangles, vertices);
     check_non_manifold_triangles(vertex_triangles, vertices);
@@ -569,12 +570,12 @@ namespace gca {
     int wind_errs = num_winding_order_errors(vertex_triangles);
     if (wind_errs > 0) {
 
-      cout << "Num winding errors = " << wind_errs << endl;
+      GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors = " << wind_errs);
 
       auto fixed_triangles = fix_winding_order_errors(vertex_triangles);
       int new_wind_errs = num_winding_order_errors(fixed_triangles);
 
-      cout << "Num winding errors after fixing = " << new_wind_errs << endl;
+      GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors after fixing = " << new_wind_errs);
 
       DBG_ASSERT(new_wind_errs == 0);
 
@@ -587,7 +588,7 @@ namespace gca {
   triangular_mesh make_merged_mesh(const std::vector<triangle>& triangles,
 				   double tolerance) {
 
-    cout << "# of triangles = " << triangles.size() << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "# of triangles = " << triangles.size());
 
     DBG_ASSERT(triangles.size() > 0);
 
@@ -611,12 +612,12 @@ namespace gca {
       int wind_errs = num_winding_order_errors(c);
       if (wind_errs > 0) {
 
-	cout << "Num winding errors = " << wind_errs << endl;
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors = " << wind_errs);
 
 	auto fixed_triangles = fix_winding_order_errors(c);
 	int new_wind_errs = num_winding_order_errors(fixed_triangles);
 
-	cout << "Num winding errors after fixing = " << new_wind_errs << endl;
+	GCA_LOG_DEBUG(GEOMETRY_LOG, "Num winding errors after fixing = " << new_wind_errs);
 
 	DBG_ASSERT(new_wind_errs == 0);
 
@@ -1053,7 +1054,7 @@ namespace gca {
   }
 
   triangular_mesh triangulate(const oriented_polygon& p) {
-    cout << "Making triangular mesh" << endl;
+    GCA_LOG_DEBUG(GEOMETRY_LOG, "Making triangular mesh");
     auto tris = triangulate_polygon(p);
     return make_mesh(tris, 0.001);
   }
@@ -305,6 +305,8 @@ namespace gca {
   connect_regions(std::vector<index_t>& indices,
 		  const triangular_mesh& part);
 
+  bool point_in_triangle_2d(point pt, point v1, point v2, point v3);
+
   maybe<double> z_at(const double x,
 		     const double y,
 		     const std::vector<index_t>& faces,
@@ -1,3 +1,6 @@
+#include <algorithm>
+
+#include "geometry/triangular_mesh.h"
 #include "geometry/voxel_volume.h"
 
 namespace gca {
@@ -14,8 +17,331 @@ namespace gca {
     resolution(p_resolution),
     nx_elems(x_len / resolution),
     ny_elems(y_len / resolution),
-    nz_elems(z_len / resolution) {
-    
+    nz_elems(z_len / resolution),
+    words_per_column((nz_elems + 63) / 64),
+    voxels(nx_elems*ny_elems*words_per_column, 0) {
+
+  }
+
+  // Mask with bits [s, e) of a word set, 0 <= s <= e <= 64
+  static inline uint64_t bit_range(const int s, const int e) {
+    if (s >= e) { return 0; }
+
+    uint64_t high = (e == 64) ? ~uint64_t(0) : ((uint64_t(1) << e) - 1);
+    uint64_t low = (uint64_t(1) << s) - 1;
+    return high & ~low;
+  }
+
+  void voxel_volume::fill_column(const int x_i, const int y_i,
+				 const int z_start, const int z_end) {
+    DBG_ASSERT(legal_column(x_i, y_i));
+
+    int s = max(z_start, 0);
+    int e = min(z_end, nz_elems);
+
+    uint64_t* col = column(x_i, y_i);
+    for (int w = s >> 6; w < words_per_column && (w << 6) < e; w++) {
+      int ws = max(s - (w << 6), 0);
+      int we = min(e - (w << 6), 64);
+      col[w] |= bit_range(ws, we);
+    }
+  }
+
+  int voxel_volume::clear_column_above(const int x_i, const int y_i,
+				       const double z) {
+    DBG_ASSERT(legal_column(x_i, y_i));
+
+    // First voxel whose center is at or above z
+    int s = static_cast<int>(ceil((z - z_min()) / resolution - 0.5));
+    s = max(s, 0);
+
+    if (s >= nz_elems) { return 0; }
+
+    int cleared = 0;
+    uint64_t* col = column(x_i, y_i);
+    for (int w = s >> 6; w < words_per_column; w++) {
+      int ws = max(s - (w << 6), 0);
+      uint64_t mask = bit_range(ws, 64);
+      cleared += __builtin_popcountll(col[w] & mask);
+      col[w] &= ~mask;
+    }
+
+    return cleared;
+  }
+
+  int voxel_volume::column_count(const int x_i, const int y_i) const {
+    const uint64_t* col = column(x_i, y_i);
+    int count = 0;
+    for (int w = 0; w < words_per_column; w++) {
+      count += __builtin_popcountll(col[w]);
+    }
+    return count;
+  }
+
+  int voxel_volume::num_occupied() const {
+    int count = 0;
+    for (auto w : voxels) {
+      count += __builtin_popcountll(w);
+    }
+    return count;
+  }
+
+  double voxel_volume::surface_area() const {
+    int num_faces = 0;
+    for (int i = 0; i < num_x_elems(); i++) {
+      for (int j = 0; j < num_y_elems(); j++) {
+	for (int k = 0; k < num_z_elems(); k++) {
+	  if (!is_occupied(i, j, k)) { continue; }
+
+	  num_faces += is_empty(i - 1, j, k) + is_empty(i + 1, j, k) +
+	    is_empty(i, j - 1, k) + is_empty(i, j + 1, k) +
+	    is_empty(i, j, k - 1) + is_empty(i, j, k + 1);
+	}
+      }
+    }
+
+    return num_faces*resolution*resolution;
+  }
+
+  void voxel_volume::subtract(const voxel_volume& other) {
+    DBG_ASSERT(same_grid(other));
+
+    for (unsigned i = 0; i < voxels.size(); i++) {
+      voxels[i] &= ~other.voxels[i];
+    }
+  }
+
+  void voxel_volume::intersect(const voxel_volume& other) {
+    DBG_ASSERT(same_grid(other));
+
+    for (unsigned i = 0; i < voxels.size(); i++) {
+      voxels[i] &= other.voxels[i];
+    }
+  }
+
+  void voxel_volume::unite(const voxel_volume& other) {
+    DBG_ASSERT(same_grid(other));
+
+    for (unsigned i = 0; i < voxels.size(); i++) {
+      voxels[i] |= other.voxels[i];
+    }
+  }
+
+  voxel_volume
+  boolean_difference(const voxel_volume& a, const voxel_volume& b) {
+    voxel_volume res = a;
+    res.subtract(b);
+    return res;
+  }
+
+  voxel_volume
+  boolean_intersection(const voxel_volume& a, const voxel_volume& b) {
+    voxel_volume res = a;
+    res.intersect(b);
+    return res;
+  }
+
+  voxel_volume
+  boolean_union(const voxel_volume& a, const voxel_volume& b) {
+    voxel_volume res = a;
+    res.unite(b);
+    return res;
+  }
+
+  static inline double edge_function(const point a,
+				     const point b,
+				     const double x,
+				     const double y) {
+    return (b.x - a.x)*(y - a.y) - (b.y - a.y)*(x - a.x);
+  }
+
+  // Top-left fill rule for a counter clockwise edge, keeps a ray
+  // that passes exactly through a shared edge from hitting both
+  // triangles
+  static inline bool is_top_left(const point a, const point b) {
+    return (a.y == b.y && b.x < a.x) || (b.y < a.y);
+  }
+
+  static inline bool inside_edge(const double w,
+				 const point a,
+				 const point b) {
+    return w > 0 || (w == 0 && is_top_left(a, b));
+  }
+
+  // Height at which the vertical line through (x, y) crosses t,
+  // if it does
+  static bool vertical_crossing(const triangle& tri,
+				const double x,
+				const double y,
+				double* z) {
+    point a = tri.v1;
+    point b = tri.v2;
+    point c = tri.v3;
+
+    double area = edge_function(a, b, c.x, c.y);
+
+    // Vertical triangles are never crossed by a vertical line
+    if (fabs(area) < 1e-14) { return false; }
+
+    if (area < 0) {
+      swap(b, c);
+      area = -area;
+    }
+
+    double w0 = edge_function(b, c, x, y);
+    double w1 = edge_function(c, a, x, y);
+    double w2 = edge_function(a, b, x, y);
+
+    if (!(inside_edge(w0, b, c) &&
+	  inside_edge(w1, c, a) &&
+	  inside_edge(w2, a, b))) {
+      return false;
+    }
+
+    *z = (w0*a.z + w1*b.z + w2*c.z) / area;
+    return true;
   }
-  
+
+  voxel_volume voxelize(const std::vector<triangle>& tris,
+			const box bounds,
+			const double resolution) {
+    voxel_volume vv(point(bounds.x_min, bounds.y_min, bounds.z_min),
+		    bounds.x_len(),
+		    bounds.y_len(),
+		    bounds.z_len(),
+		    resolution);
+
+    int nx = vv.num_x_elems();
+    int ny = vv.num_y_elems();
+
+    if (nx == 0 || ny == 0 || vv.num_z_elems() == 0) { return vv; }
+
+    // Bin each triangle into the columns its xy bounding box covers
+    // so each column ray is only tested against nearby triangles
+    vector<vector<unsigned>> column_tris(nx*ny);
+    for (unsigned t = 0; t < tris.size(); t++) {
+      const triangle& tri = tris[t];
+      double tx_min = min(tri.v1.x, min(tri.v2.x, tri.v3.x));
+      double tx_max = max(tri.v1.x, max(tri.v2.x, tri.v3.x));
+      double ty_min = min(tri.v1.y, min(tri.v2.y, tri.v3.y));
+      double ty_max = max(tri.v1.y, max(tri.v2.y, tri.v3.y));
+
+      // Column i has its center ray at x_min + (i + 0.5)*resolution
+      int first_x = max(static_cast<int>(ceil((tx_min - vv.x_min()) / resolution - 0.5)), 0);
+      int last_x = min(static_cast<int>(floor((tx_max - vv.x_min()) / resolution - 0.5)), nx - 1);
+      int first_y = max(static_cast<int>(ceil((ty_min - vv.y_min()) / resolution - 0.5)), 0);
+      int last_y = min(static_cast<int>(floor((ty_max - vv.y_min()) / resolution - 0.5)), ny - 1);
+
+      for (int i = first_x; i <= last_x; i++) {
+	for (int j = first_y; j <= last_y; j++) {
+	  column_tris[i*ny + j].push_back(t);
+	}
+      }
+    }
+
+    vector<double> crossings;
+    for (int i = 0; i < nx; i++) {
+      for (int j = 0; j < ny; j++) {
+	double x = vv.x_center(i);
+	double y = vv.y_center(j);
+
+	crossings.clear();
+	for (auto t : column_tris[i*ny + j]) {
+	  double z;
+	  if (vertical_crossing(tris[t], x, y, &z)) {
+	    crossings.push_back(z);
+	  }
+	}
+
+	if (crossings.size() < 2) { continue; }
+
+	sort(begin(crossings), end(crossings));
+
+	// Parity fill, a voxel is inside if its center lies between
+	// an entering and an exiting crossing
+	for (unsigned c = 0; c + 1 < crossings.size(); c += 2) {
+	  int z_s = static_cast<int>(ceil((crossings[c] - vv.z_min()) / resolution - 0.5));
+	  int z_e = static_cast<int>(floor((crossings[c + 1] - vv.z_min()) / resolution - 0.5)) + 1;
+	  vv.fill_column(i, j, z_s, z_e);
+	}
+      }
+    }
+
+    return vv;
+  }
+
+  voxel_volume voxelize(const triangular_mesh& m,
+			const box bounds,
+			const double resolution) {
+    return voxelize(m.triangle_list(), bounds, resolution);
+  }
+
+  voxel_volume voxelize(const triangular_mesh& m,
+			const double resolution) {
+    return voxelize(m, m.bounding_box(), resolution);
+  }
+
+  static void append_face(const point n,
+			  const point a,
+			  const point b,
+			  const point c,
+			  const point d,
+			  std::vector<triangle>& tris) {
+    tris.push_back(triangle(n, a, b, c));
+    tris.push_back(triangle(n, a, c, d));
+  }
+
+  std::vector<triangle> boundary_triangles(const voxel_volume& v) {
+    std::vector<triangle> tris;
+    double r = v.get_resolution();
+
+    for (int i = 0; i < v.num_x_elems(); i++) {
+      for (int j = 0; j < v.num_y_elems(); j++) {
+	for (int k = 0; k < v.num_z_elems(); k++) {
+	  if (!v.is_occupied(i, j, k)) { continue; }
+
+	  double x0 = v.x_min() + i*r;
+	  double y0 = v.y_min() + j*r;
+	  double z0 = v.z_min() + k*r;
+	  double x1 = x0 + r;
+	  double y1 = y0 + r;
+	  double z1 = z0 + r;
+
+	  if (v.is_empty(i - 1, j, k)) {
+	    append_face(point(-1, 0, 0),
+			point(x0, y0, z0), point(x0, y0, z1),
+			point(x0, y1, z1), point(x0, y1, z0), tris);
+	  }
+	  if (v.is_empty(i + 1, j, k)) {
+	    append_face(point(1, 0, 0),
+			point(x1, y0, z0), point(x1, y1, z0),
+			point(x1, y1, z1), point(x1, y0, z1), tris);
+	  }
+	  if (v.is_empty(i, j - 1, k)) {
+	    append_face(point(0, -1, 0),
+			point(x0, y0, z0), point(x1, y0, z0),
+			point(x1, y0, z1), point(x0, y0, z1), tris);
+	  }
+	  if (v.is_empty(i, j + 1, k)) {
+	    append_face(point(0, 1, 0),
+			point(x0, y1, z0), point(x0, y1, z1),
+			point(x1, y1, z1), point(x1, y1, z0), tris);
+	  }
+	  if (v.is_empty(i, j, k - 1)) {
+	    append_face(point(0, 0, -1),
+			point(x0, y0, z0), point(x0, y1, z0),
+			point(x1, y1, z0), point(x1, y0, z0), tris);
+	  }
+	  if (v.is_empty(i, j, k + 1)) {
+	    append_face(point(0, 0, 1),
+			point(x0, y0, z1), point(x1, y0, z1),
+			point(x1, y1, z1), point(x0, y1, z1), tris);
+	  }
+	}
+      }
+    }
+
+    return tris;
+  }
+
 }
@@ -1,28 +1,19 @@
 #pragma once
 
-#include <boost/container/flat_set.hpp>
+#include <cstdint>
+#include <vector>
 
 #include "geometry/point.h"
+#include "geometry/triangle.h"
+#include "utils/check.h"
 
 namespace gca {
 
-  struct voxel {
-    int xi, yi, zi;
-  };
-
-  static inline bool operator<(const voxel l, const voxel r) {
-    if (l.xi < r.xi) { return true; }
-    if (l.xi > r.xi) { return false; }
-
-    if (l.yi < r.yi) { return true; }
-    if (l.yi > r.yi) { return false; }
-
-    if (l.zi < r.zi) { return true; }
-
-    return false;
-      
-  }
+  class triangular_mesh;
 
+  // Dense occupancy grid. Each (x, y) column is stored as a run of
+  // 64 bit words along z, so point queries are O(1) and whole column
+  // updates (tool sweeps, boolean ops, counting) work a word at a time
   class voxel_volume {
 
   protected:
@@ -32,8 +23,17 @@ namespace gca {
     double resolution;
     int nx_elems, ny_elems, nz_elems;
 
-    boost::container::flat_set<voxel> voxels;
-    
+    int words_per_column;
+    std::vector<uint64_t> voxels;
+
+    inline uint64_t* column(const int x_i, const int y_i) {
+      return voxels.data() + (x_i*ny_elems + y_i)*words_per_column;
+    }
+
+    inline const uint64_t* column(const int x_i, const int y_i) const {
+      return voxels.data() + (x_i*ny_elems + y_i)*words_per_column;
+    }
+
   public:
     voxel_volume(const point origin,
 		 const double x_len,
@@ -45,18 +45,70 @@ namespace gca {
 
     inline point get_origin() const { return origin; }
 
+    inline bool legal_voxel(int x_i, int y_i, int z_i) const {
+      return (0 <= x_i && x_i < nx_elems) &&
+	(0 <= y_i && y_i < ny_elems) &&
+	(0 <= z_i && z_i < nz_elems);
+    }
+
+    inline bool legal_column(int x_i, int y_i) const {
+      return (0 <= x_i && x_i < nx_elems) && (0 <= y_i && y_i < ny_elems);
+    }
+
     inline bool is_empty(int x_i, int y_i, int z_i) const {
       return !is_occupied(x_i, y_i, z_i);
     }
 
     inline bool is_occupied(int x_i, int y_i, int z_i) const {
-      return voxels.find( voxel{x_i, y_i, z_i} ) != voxels.end();
+      if (!legal_voxel(x_i, y_i, z_i)) { return false; }
+
+      return (column(x_i, y_i)[z_i >> 6] >> (z_i & 63)) & 1;
     }
 
     inline void set_occupied(int x_i, int y_i, int z_i) {
-      voxels.insert( voxel{x_i, y_i, z_i} );
+      DBG_ASSERT(legal_voxel(x_i, y_i, z_i));
+
+      column(x_i, y_i)[z_i >> 6] |= (uint64_t(1) << (z_i & 63));
+    }
+
+    inline void set_empty(int x_i, int y_i, int z_i) {
+      DBG_ASSERT(legal_voxel(x_i, y_i, z_i));
+
+      column(x_i, y_i)[z_i >> 6] &= ~(uint64_t(1) << (z_i & 63));
+    }
+
+    // Sets voxels [z_start, z_end) in column (x_i, y_i)
+    void fill_column(const int x_i, const int y_i,
+		     const int z_start, const int z_end);
+
+    // Clears every voxel in column (x_i, y_i) whose center is at
+    // or above z, returns the number of voxels that were cleared
+    int clear_column_above(const int x_i, const int y_i, const double z);
+
+    int column_count(const int x_i, const int y_i) const;
+
+    int num_occupied() const;
+
+    inline double voxel_volume_size() const
+    { return resolution*resolution*resolution; }
+
+    inline double volume() const
+    { return num_occupied()*voxel_volume_size(); }
+
+    double surface_area() const;
+
+    inline bool same_grid(const voxel_volume& other) const {
+      return (origin == other.origin) &&
+	(resolution == other.resolution) &&
+	(nx_elems == other.nx_elems) &&
+	(ny_elems == other.ny_elems) &&
+	(nz_elems == other.nz_elems);
     }
 
+    void subtract(const voxel_volume& other);
+    void intersect(const voxel_volume& other);
+    void unite(const voxel_volume& other);
+
     inline double x_center(const int i) const {
       return x_min() + resolution*i + (resolution/2.0);
     }
@@ -69,6 +121,18 @@ namespace gca {
       return z_min() + resolution*i + (resolution/2.0);
     }
 
+    inline int x_index(double x) const {
+      return static_cast<int>(floor((x - x_min()) / resolution));
+    }
+
+    inline int y_index(double y) const {
+      return static_cast<int>(floor((y - y_min()) / resolution));
+    }
+
+    inline int z_index(double z) const {
+      return static_cast<int>(floor((z - z_min()) / resolution));
+    }
+
     inline double x_length() const {
       return x_max() - x_min();
     }
@@ -80,7 +144,7 @@ namespace gca {
     inline double z_length() const {
       return z_max() - z_min();
     }
-    
+
     inline double x_min() const {
       return origin.x;
     }
@@ -100,7 +164,7 @@ namespace gca {
     inline double z_min() const {
       return origin.z;
     }
-    
+
     inline double z_max() const {
       return origin.z + z_len;
     }
@@ -116,8 +180,32 @@ namespace gca {
     inline int num_z_elems() const {
       return nz_elems;
     }
-    
+
   };
 
+  voxel_volume
+  boolean_difference(const voxel_volume& a, const voxel_volume& b);
+
+  voxel_volume
+  boolean_intersection(const voxel_volume& a, const voxel_volume& b);
+
+  voxel_volume
+  boolean_union(const voxel_volume& a, const voxel_volume& b);
+
+  // Voxelizes a closed surface into the grid of bounds
+  voxel_volume voxelize(const std::vector<triangle>& tris,
+			const box bounds,
+			const double resolution);
+
+  voxel_volume voxelize(const triangular_mesh& m,
+			const box bounds,
+			const double resolution);
+
+  voxel_volume voxelize(const triangular_mesh& m,
+			const double resolution);
+
+  // Every voxel face that borders empty space, as two triangles
+  // per face, oriented outward
+  std::vector<triangle> boundary_triangles(const voxel_volume& v);
 
 }
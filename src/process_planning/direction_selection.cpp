@@ -8,6 +8,7 @@
 #include "process_planning/direction_selection.h"
 #include "process_planning/feature_selection.h"
 #include "process_planning/mandatory_volumes.h"
+#include "utils/instrumentation.h"
 
 
 namespace gca {
@@ -267,6 +268,8 @@ namespace gca {
 			 const triangular_mesh& part,
 			 const fixtures& f,
 			 const std::vector<tool>& tools) {
+    phase_timer phase("select_mill_directions");
+
     vector<direction_info> norms =
       select_cut_directions(stock, part, f, tools);
 
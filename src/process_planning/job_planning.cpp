@@ -2,6 +2,7 @@
 #include "backend/freeform_toolpaths.h"
 #include "geometry/extrusion.h"
 #include "geometry/mesh_operations.h"
+#include "geometry/nef_cache.h"
 #include "geometry/offset.h"
 #include "geometry/vtk_debug.h"
 #include "geometry/vtk_utils.h"
@@ -14,6 +15,8 @@
 #include "synthesis/visual_debug.h"
 #include "synthesis/workpiece_clipping.h"
 #include "utils/check.h"
+#include "utils/instrumentation.h"
+#include "utils/log.h"
 
 //#define VIZ_DBG
 
@@ -76,7 +79,7 @@ namespace gca {
 
     //vtk_debug_meshes({m, part});
 
-    Nef_polyhedron mesh_nef = trimesh_to_nef_polyhedron(m);
+    Nef_polyhedron mesh_nef = cached_trimesh_to_nef_polyhedron(m);
 
     DBG_ASSERT(mesh_nef.is_simple());
 
@@ -92,7 +95,7 @@ namespace gca {
 
     //vtk_debug_meshes({m, part});
 
-    Nef_polyhedron mesh_nef = trimesh_to_nef_polyhedron(m);
+    Nef_polyhedron mesh_nef = cached_trimesh_to_nef_polyhedron(m);
 
     DBG_ASSERT(mesh_nef.is_simple());
 
@@ -141,11 +144,9 @@ namespace gca {
     auto res = m;
     for (auto f : features) {
       Nef_polyhedron f_nef =
-	trimesh_to_nef_polyhedron(feature_mesh(*f, 0.0000001 /*1*/, 1.0, 0.000001));
+	cached_trimesh_to_nef_polyhedron(feature_mesh(*f, 0.0000001 /*1*/, 1.0, 0.000001));
 
-      for (auto it = f_nef.volumes_begin(); it != f_nef.volumes_end(); it++) {
-	cout << "VOLUME" << endl;
-      }
+      GCA_LOG_DEBUG(PLANNING_LOG, "# of feature volumes = " << f_nef.number_of_volumes());
 
       res = (res - f_nef).regularization();
       
@@ -167,9 +168,9 @@ namespace gca {
 
   volume_info initial_volume_info(const feature& f,
 				  const Nef_polyhedron& stock_nef) {
-    cout << "Starting feature mesh" << endl;
-    cout << "Feature depth  = " << f.depth() << endl;
-    cout << "Feature normal = " << f.normal() << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Starting feature mesh");
+    GCA_LOG_DEBUG(PLANNING_LOG, "Feature depth  = " << f.depth());
+    GCA_LOG_DEBUG(PLANNING_LOG, "Feature normal = " << f.normal());
 
 // #ifdef VIZ_DBG
 //     vtk_debug_feature(f);
@@ -179,20 +180,20 @@ namespace gca {
 
     triangular_mesh mesh = feature_mesh(f);
 
-    cout << "Ending feature mesh" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Ending feature mesh");
     
-    auto feature_nef = trimesh_to_nef_polyhedron(mesh);
+    auto feature_nef = cached_trimesh_to_nef_polyhedron(mesh);
     feature_nef = stock_nef.intersection(feature_nef);
 
-    cout << "Got undilated feature mesh" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Got undilated feature mesh");
 
-    double vol = volume(nef_to_single_trimesh(feature_nef));
+    double vol = volume(cached_nef_to_single_trimesh(feature_nef));
 
     //	TODO: Refine the dilation tolerance, it may not matter but
     //	best to be safe
     triangular_mesh dilated_mesh = feature_mesh(f, 0.00005, 0.05, 0.0); //0.000005, 0.05, 0.0);
 
-    return volume_info{vol, feature_nef, trimesh_to_nef_polyhedron(dilated_mesh)};
+    return volume_info{vol, feature_nef, cached_trimesh_to_nef_polyhedron(dilated_mesh)};
   }
 
   volume_info
@@ -203,29 +204,25 @@ namespace gca {
     // TODO: Refine this to include feature normal etc.
     bool exact_match = false;
     for (auto& s : to_subtract) {
-      auto nef_meshes = nef_polyhedron_to_trimeshes(s);
-      double nef_volume = 0.0;
-      for (auto& nef_mesh : nef_meshes) {
-	nef_volume += volume(nef_mesh);
-      }
+      double nef_volume = cached_nef_volume(s);
 
-      cout << "nef volume           = " << nef_volume << endl;
-      cout << "old mandatory volume = " << inf.volume << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "nef volume           = " << nef_volume);
+      GCA_LOG_DEBUG(PLANNING_LOG, "old mandatory volume = " << inf.volume);
 
       if (within_eps(inf.volume, nef_volume, 0.0001)) {
-	cout << "Found exact match feature for mandatory volume" << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Found exact match feature for mandatory volume");
 	return volume_info{0.0, inf.remaining_volume, inf.dilated_mesh};
       }
     }
 
-    cout << "Starting subtractions" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Starting subtractions");
 
     Nef_polyhedron res = inf.remaining_volume;
     for (auto s : to_subtract) {
       res = res - s;
     }
 
-    cout << "Done with subtractions" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Done with subtractions");
 
     if (!res.is_simple()) {
       cout << "Result of subtraction is not simple!" << endl;
@@ -240,13 +237,10 @@ namespace gca {
       DBG_ASSERT(false);
     }
 
-    double new_volume = 0.0;
-    for (auto& m : nef_polyhedron_to_trimeshes(res)) {
-      new_volume += volume(m);
-    }
+    double new_volume = cached_nef_volume(res);
 
-    cout << "Old volume = " << inf.volume << endl;
-    cout << "New volume = " << new_volume << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Old volume = " << inf.volume);
+    GCA_LOG_DEBUG(PLANNING_LOG, "New volume = " << new_volume);
 
     return volume_info{new_volume, res, inf.dilated_mesh};
   }
@@ -256,32 +250,29 @@ namespace gca {
 		     const std::vector<Nef_polyhedron>& to_subtract) {
     if (inf.volume == 0.0) { return inf; }
 
-    cout << "Starting subtractions" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Starting subtractions");
 
     Nef_polyhedron res = inf.remaining_volume;
     for (auto s : to_subtract) {
       res = res - s;
     }
 
-    cout << "Done with subtractions" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Done with subtractions");
 
     if (!res.is_simple()) {
-      cout << "Result of subtraction is not simple!" << endl;
-      cout << "Initial volume to clip" << endl;
+      GCA_LOG_WARNING(PLANNING_LOG, "Result of subtraction is not simple!");
+      GCA_LOG_DEBUG(PLANNING_LOG, "Initial volume to clip");
       vtk_debug_meshes(nef_polyhedron_to_trimeshes(inf.remaining_volume));
 
       for (auto& nf : to_subtract) {
-	cout << "Nef subtracted" << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Nef subtracted");
 	vtk_debug_meshes(nef_polyhedron_to_trimeshes(nf));
       }
     }
-    double new_volume = 0.0;
-    for (auto& m : nef_polyhedron_to_trimeshes(res)) {
-      new_volume += volume(m);
-    }
+    double new_volume = cached_nef_volume(res);
 
-    cout << "Old volume = " << inf.volume << endl;
-    cout << "New volume = " << new_volume << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Old volume = " << inf.volume);
+    GCA_LOG_DEBUG(PLANNING_LOG, "New volume = " << new_volume);
 
     return volume_info{new_volume, res, inf.dilated_mesh};
   }
@@ -308,7 +299,7 @@ namespace gca {
 		   const std::vector<tool>& tools,
 		   feature_decomposition* decomp) {
     auto& feat_nef = vol_info.remaining_volume;
-    vector<triangular_mesh> meshes = nef_polyhedron_to_trimeshes(feat_nef);
+    vector<triangular_mesh> meshes = cached_nef_polyhedron_to_trimeshes(feat_nef);
 
     vector<feature*> clipped_features;
     for (auto& feature_mesh : meshes) {
@@ -599,6 +590,7 @@ namespace gca {
 			      const triangular_mesh& current_stock,
 			      const point n,
 			      const fixtures& f) {
+    phase_timer phase("fixture_search");
 
     boost::optional<double> par_plate =
       select_parallel_plate(decomp, current_stock, f);
@@ -645,11 +637,7 @@ namespace gca {
 					   surf.s.index_list(),
 					   surf.s.get_parent_mesh(),
 					   n);
-      auto meshes = nef_polyhedron_to_trimeshes(intersected);
-      double vol = 0.0;
-      for (auto& mesh : meshes) {
-	vol += volume(mesh);
-      }
+      double vol = cached_nef_volume(intersected);
 
       cout << "Total volume left = " << vol << endl;
       if (vol > 0.001) {
@@ -684,7 +672,7 @@ namespace gca {
     for (auto& mandatory : mandatories) {
 
       for (auto& mv : mandatory) {
-	Nef_polyhedron mv_nef = trimesh_to_nef_polyhedron(mv.volume);
+	Nef_polyhedron mv_nef = cached_trimesh_to_nef_polyhedron(mv.volume);
 
 	for (auto& feature_volume_info : volume_inf) {
 	  feature* f = feature_volume_info.first;
@@ -765,7 +753,7 @@ namespace gca {
     }
 
     for (auto& m : mandatory_group) {
-      auto mesh_nef = trimesh_to_nef_polyhedron(m.volume);
+      auto mesh_nef = cached_trimesh_to_nef_polyhedron(m.volume);
       vol_info[&m] = volume_info{volume(m.volume), mesh_nef, mesh_nef};
       clip_dirs[&m] = clip_dir_list;
     }
@@ -789,7 +777,7 @@ namespace gca {
     Nef_polyhedron result = current_stock;
     for (auto& mv : mandatory_info.mandatory_info) {
       if (angle_eps(mv.first->direction, n, 0.0, 0.5)) {
-	cout << "Subtracting mandatory volume" << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Subtracting mandatory volume");
 	result = result - mv.second.dilated_mesh;
       }
     }
@@ -804,8 +792,8 @@ namespace gca {
     double original_vol = volume(v.volume);
     double density = mv.volume / volume(v.volume);
 
-    cout << "Original volume = " << original_vol << endl;
-    cout << "Density         = " << density << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Original volume = " << original_vol);
+    GCA_LOG_DEBUG(PLANNING_LOG, "Density         = " << density);
 
     return density > 1e-4;
   }
@@ -820,7 +808,7 @@ namespace gca {
 			    const std::vector<tool>& tools) {
     vector<mandatory_volume*> mandatory_vols;
     for (auto& mv : mandatory_info.mandatory_info) {
-      cout << "Candidate has volume = " << mv.second.volume << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Candidate has volume = " << mv.second.volume);
       if (angle_eps(mv.first->direction, n, 0.0, 0.5) &&
 	  non_empty_volume(*(mv.first), mv.second)) {
 
@@ -829,33 +817,22 @@ namespace gca {
       }
     }
 
-    cout << "# of mandatory volumes in " << n << " = " << mandatory_vols.size() << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "# of mandatory volumes in " << n << " = " << mandatory_vols.size());
 
     if (mandatory_vols.size() == 0) { return feats_to_sub; }
 
     vector<Nef_polyhedron> to_sub;
-    vector<triangular_mesh> to_sub_meshes;
     for (auto& mv : mandatory_vols) {
       to_sub.push_back(map_find(mv, mandatory_info.mandatory_info).dilated_mesh);
-      concat(to_sub_meshes, nef_polyhedron_to_trimeshes(to_sub.back()));
     }
 
-    //vtk_debug_meshes(to_sub_meshes);
-    
     for (auto f : feats_to_sub) {
       volume_info& feature_info = volume_inf.find(f)->second; //map_find(f, volume_inf);
-      auto mesh_complex = to_sub_meshes;
-      concat(mesh_complex,
-	     nef_polyhedron_to_trimeshes(feature_info.remaining_volume));
 
-      
-
-      cout << "Feature volume before adjustment = " << feature_info.volume << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Feature volume before adjustment = " << feature_info.volume);
 
-      //vtk_debug_meshes(mesh_complex);
-      
       volume_inf[f] = update_volume_info(feature_info, to_sub);
-      cout << "Feature volume after adjustment = " << feature_info.volume << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Feature volume after adjustment = " << feature_info.volume);
     }
 
     vector<feature*> feats = feats_to_sub;
@@ -915,21 +892,21 @@ namespace gca {
 	       [n](const point p) { return angle_eps(n, p, 0.0, 0.5); });
 
       if (is_legal_clip_dir) {
-	cout << "Mandatory volume normals = " << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Mandatory volume normals = ");
 	for (auto dir : clip_dirs) {
-	  cout << dir << endl;
+	  GCA_LOG_DEBUG(PLANNING_LOG, dir);
 	}
 
-	cout << "Clipping feature normal = " << n << endl;
-	cout << "Volume before clipping = " << mandatory_info.mandatory_info[f].volume << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Clipping feature normal = " << n);
+	GCA_LOG_DEBUG(PLANNING_LOG, "Volume before clipping = " << mandatory_info.mandatory_info[f].volume);
 
-	cout << "Clipping nefs = " << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Clipping nefs = ");
 	//vtk_debug_nef_polyhedra(to_subtract);
 	
 	mandatory_info.mandatory_info[f] =
 	  update_clipped_volume_info(info_pair.second, to_subtract);
 
-	cout << "Volume after clipping = " << mandatory_info.mandatory_info[f].volume << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Volume after clipping = " << mandatory_info.mandatory_info[f].volume);
       }
     }
   }
@@ -940,13 +917,14 @@ namespace gca {
 			   const fixtures& f,
 			   std::vector<direction_process_info>& dir_info,
 			   const std::vector<tool>& tools) {
+    phase_timer phase("select_jobs_and_features");
 
 #ifdef VIZ_DBG
     vector<feature*> all_features{};
     visualize_initial_features(dir_info);
 #endif
 
-    Nef_polyhedron stock_nef = trimesh_to_nef_polyhedron(stock);
+    Nef_polyhedron stock_nef = cached_trimesh_to_nef_polyhedron(stock);
 
     volume_info_map volume_inf = initial_volume_info(dir_info, stock_nef);
 
@@ -961,11 +939,11 @@ namespace gca {
     while (dir_info.size() > 0) {
       direction_process_info info = select_next_dir(dir_info, volume_inf);
 
-      cout << "Trying direction " << normal(info.decomp) << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Trying direction " << normal(info.decomp));
 
-      cout << "In loop getting current stock" << endl;
-      auto current_stock = nef_to_single_trimesh(stock_nef);
-      cout << "In loop got current stock" << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "In loop getting current stock");
+      auto current_stock = cached_nef_to_single_trimesh(stock_nef);
+      GCA_LOG_DEBUG(PLANNING_LOG, "In loop got current stock");
 
       point n = normal(info.decomp);
 
@@ -985,7 +963,7 @@ namespace gca {
 	homogeneous_transform t = maybe_fix->second;
 	auto features = collect_viable_features(decomp, volume_inf, fix);
 
-	cout << "# of viable features = " << features.size() << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "# of viable features = " << features.size());
 
 #ifdef VIZ_DBG
 	fabrication_setup dummy(apply(t, current_stock), fix.v, {});
@@ -1042,7 +1020,7 @@ namespace gca {
 	  clear_mandatory_features(n, mandatory_info);
 
 	  cout << "Just before in loop nef to trimesh" << endl;
-	  current_stock = nef_to_single_trimesh(stock_nef);
+	  current_stock = cached_nef_to_single_trimesh(stock_nef);
 	  cout << "Just after in loop nef to trimesh" << endl;
 
 	  double stock_volume = volume(current_stock);
@@ -1061,7 +1039,7 @@ namespace gca {
     }
 
     cout << "Done with loop getting current stock" << endl;
-    auto current_stock = nef_to_single_trimesh(stock_nef);
+    auto current_stock = cached_nef_to_single_trimesh(stock_nef);
     cout << "Done with loop got current stock" << endl;
 
     double stock_volume = volume(current_stock);
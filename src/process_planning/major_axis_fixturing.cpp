@@ -2,10 +2,12 @@
 
 #include "backend/chamfer_operation.h"
 #include "backend/drilled_hole_operation.h"
+#include "backend/hole_ordering.h"
 #include "backend/slice_roughing_operation.h"
 #include "backend/freeform_toolpaths.h"
 #include "feature_recognition/vertical_wall.h"
 #include "feature_recognition/visual_debug.h"
+#include "geometry/nef_cache.h"
 #include "process_planning/feature_selection.h"
 #include "process_planning/feature_to_pocket.h"
 #include "process_planning/job_planning.h"
@@ -23,7 +25,7 @@ namespace gca {
   find_dir_fixture(const fixtures& f,
 		   const point n,
 		   const triangular_mesh& m) {
-    Nef_polyhedron part_nef = trimesh_to_nef_polyhedron(m);
+    Nef_polyhedron part_nef = cached_trimesh_to_nef_polyhedron(m);
 
     vice v = f.get_vice();
     if (f.parallel_plates().size() > 0) {
@@ -118,14 +120,14 @@ namespace gca {
 			      const triangular_mesh& stock,
 			      const point n,
 			      const fixtures& fixes) {
-    Nef_polyhedron stock_nef = trimesh_to_nef_polyhedron(stock);
+    Nef_polyhedron stock_nef = cached_trimesh_to_nef_polyhedron(stock);
     return find_next_fixture_side_vice(f, stock_nef, stock, n, fixes);
   }
 
 
   void test_stock_volume(const Nef_polyhedron& stock_nef,
 			 const triangular_mesh& part) {
-    auto current_stock = nef_to_single_trimesh(stock_nef);
+    auto current_stock = cached_nef_to_single_trimesh(stock_nef);
     cout << "Done with loop got current stock" << endl;
 
     double part_volume = volume(part);
@@ -322,7 +324,7 @@ namespace gca {
       concat(toolpaths, finish_toolpaths_for_feature(f->apply(t), tools, stock_material, safe_z));
     }
     
-    return toolpaths;
+    return order_drilled_holes(toolpaths);
   }
 
   depth_field
@@ -817,7 +819,7 @@ namespace gca {
     point pt = min_point_in_dir(part, n);
     plane slice_plane(n, pt);
 
-    Nef_polyhedron stock_nef = trimesh_to_nef_polyhedron(stock);
+    Nef_polyhedron stock_nef = cached_trimesh_to_nef_polyhedron(stock);
     double depth = signed_distance_along(slice_plane.pt(), slice_plane.normal());
     auto maybe_fix = find_next_fixture_side_vice(depth, stock_nef, stock, n, fixes);
     
@@ -1,18 +1,105 @@
+#include <mutex>
+#include <numeric>
+
 #include "feature_recognition/visual_debug.h"
 #include "geometry/offset.h"
 #include "process_planning/tool_access.h"
 #include "utils/check.h"
+#include "utils/log.h"
+#include "utils/parallel.h"
 
 namespace gca {
 
-  std::vector<feature> build_access_features(const feature& f,
+  // Offsets of a feature base depend only on its geometry and the
+  // tool dimensions, so they are keyed by polygon contents rather
+  // than by feature. Tools of equal radius share interior offsets,
+  // and the cache carries over between decompositions
+  struct offset_key {
+    std::vector<point> outer;
+    std::vector<std::vector<point>> holes;
+    std::vector<double> params;
+  };
+
+  bool operator==(const offset_key& l, const offset_key& r) {
+    return (l.params == r.params) &&
+      (l.outer == r.outer) &&
+      (l.holes == r.holes);
+  }
+
+  struct offset_key_hash {
+    size_t operator()(const offset_key& k) const {
+      std::hash<double> h;
+      size_t seed = k.outer.size();
+      auto combine = [&seed, &h](const double v) {
+	seed ^= h(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      };
+      for (auto v : k.params) { combine(v); }
+      for (auto& p : k.outer) { combine(p.x); combine(p.y); combine(p.z); }
+      for (auto& hole : k.holes) {
+	for (auto& p : hole) { combine(p.x); combine(p.y); combine(p.z); }
+      }
+      return seed;
+    }
+  };
+
+  typedef std::unordered_map<offset_key,
+			     std::vector<polygon_3>,
+			     offset_key_hash> offset_cache;
+
+  static std::mutex offset_cache_mutex;
+  static offset_cache interior_offset_cache;
+  static offset_cache tool_region_cache;
+  static tool_access_cache_stats offset_stats;
+
+  static boost::optional<std::vector<polygon_3>>
+  find_offsets(const offset_cache& cache,
+	       const offset_key& k,
+	       int& hits,
+	       int& misses) {
+    std::lock_guard<std::mutex> lock(offset_cache_mutex);
+    auto it = cache.find(k);
+    if (it == end(cache)) {
+      misses++;
+      return boost::none;
+    }
+    hits++;
+    return it->second;
+  }
+
+  static void insert_offsets(offset_cache& cache,
+			     const offset_key& k,
+			     const std::vector<polygon_3>& polys) {
+    std::lock_guard<std::mutex> lock(offset_cache_mutex);
+    cache[k] = polys;
+  }
+
+  void clear_tool_access_cache() {
+    std::lock_guard<std::mutex> lock(offset_cache_mutex);
+    interior_offset_cache.clear();
+    tool_region_cache.clear();
+    offset_stats = tool_access_cache_stats();
+  }
+
+  tool_access_cache_stats tool_access_cache_statistics() {
+    std::lock_guard<std::mutex> lock(offset_cache_mutex);
+    return offset_stats;
+  }
+
+  std::vector<polygon_3> tool_access_regions(const feature& f,
 					     const tool& t,
 					     const double diam,
-					     const double len,
 					     const double depth_offset) {
+    offset_key region_key{f.base().vertices(),
+	f.base().holes(),
+	{t.radius(), diam, depth_offset}};
+
+    auto cached_regions = find_offsets(tool_region_cache, region_key,
+		   offset_stats.region_hits, offset_stats.region_misses);
+    if (cached_regions) { return *cached_regions; }
+
     check_simplicity(f.base());
 
-    cout << "Checking access feature" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Checking access feature");
     //vtk_debug_feature(f);
 
     // boost::optional<labeled_polygon_3> a_region =
@@ -20,13 +107,26 @@ namespace gca {
 
     // if (!a_region) { return {}; }
 
-    vector<polygon_3> a_regions = interior_offset({f.base()}, t.radius());
+    offset_key interior_key{f.base().vertices(), f.base().holes(), {t.radius()}};
 
-    cout << "Interior offset by " << t.radius() << endl;
-    cout << "# of polygons = " << a_regions.size() << endl;
+    vector<polygon_3> a_regions;
+    auto cached_interior = find_offsets(interior_offset_cache, interior_key,
+		   offset_stats.interior_hits, offset_stats.interior_misses);
+    if (cached_interior) {
+      a_regions = *cached_interior;
+    } else {
+      a_regions = interior_offset({f.base()}, t.radius());
+      insert_offsets(interior_offset_cache, interior_key, a_regions);
+    }
+
+    GCA_LOG_DEBUG(PLANNING_LOG, "Interior offset by " << t.radius());
+    GCA_LOG_DEBUG(PLANNING_LOG, "# of polygons = " << a_regions.size());
     //vtk_debug_polygons(a_regions);
 
-    if (a_regions.size() == 0) { return {}; }
+    if (a_regions.size() == 0) {
+      insert_offsets(tool_region_cache, region_key, {});
+      return {};
+    }
 
     for (auto& a_region : a_regions) {
       check_simplicity(a_region);
@@ -40,10 +140,23 @@ namespace gca {
     //vtk_debug_polygon(tool_region);
 
     for (auto& tool_region : tool_regions) {
-      cout << "region normal = " << tool_region.normal() << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "region normal = " << tool_region.normal());
       check_simplicity(tool_region);
     }
 
+    insert_offsets(tool_region_cache, region_key, tool_regions);
+
+    return tool_regions;
+  }
+
+  std::vector<feature> build_access_features(const feature& f,
+					     const tool& t,
+					     const double diam,
+					     const double len,
+					     const double depth_offset) {
+    vector<polygon_3> tool_regions =
+      tool_access_regions(f, t, diam, depth_offset);
+
     // TODO: Correct this open closed issue
     vector<feature> access_features;
     for (auto tool_region : tool_regions) {
@@ -102,8 +215,8 @@ namespace gca {
     point n = top_feature->feature()->normal();
 
     if (!(angle_eps(n, f.normal(), 0.0, 1.0))) {
-      cout << "n          = " << n << endl;
-      cout << "f.normal() = " << f.normal() << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "n          = " << n);
+      GCA_LOG_DEBUG(PLANNING_LOG, "f.normal() = " << f.normal());
       DBG_ASSERT(angle_eps(n, f.normal(), 0.0, 1.0));
     }
 
@@ -127,7 +240,7 @@ namespace gca {
 
     const rotation r = rotate_from_to(n, point(0, 0, 1));
 
-    cout << "# bases to union = " << bases.size() << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "# bases to union = " << bases.size());
 
     boost_multipoly_2 result;
     result.push_back(to_boost_poly_2(apply(r, bases.front())));
@@ -172,7 +285,7 @@ namespace gca {
       point d2 = next_pt - current_pt;
 
       double angle = angle_between(d1, d2);
-      cout << "Interior angle between = " << angle << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Interior angle between = " << angle);
       angles.push_back(angle);
 
     }
@@ -188,8 +301,8 @@ namespace gca {
     double max = max_e(angles, [](const double angle) { return angle; });
     double min = min_e(angles, [](const double angle) { return angle; });
 
-    cout << "max angle = " << max << endl;
-    cout << "min angle = " << min << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "max angle = " << max);
+    GCA_LOG_DEBUG(PLANNING_LOG, "min angle = " << min);
 
     // NOTE: Make this tolerance smaller
     if (!within_eps(max, min, 1.0) || (angles.front() < 140)) {
@@ -198,7 +311,7 @@ namespace gca {
 
     double side_len = (base.vertices()[1] - base.vertices()[0]).len();
 
-    cout << "Side len = " << side_len << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Side len = " << side_len);
     double angle_rads = (180 / angles.size()) * (M_PI / 180);
     return side_len / sin(angle_rads);
   }
@@ -207,13 +320,13 @@ namespace gca {
   through_hole_properties(const feature& f) {
     if (!f.is_closed() || !f.is_through()) { return boost::none; }
 
-    cout << "Found closed through feature" << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "Found closed through feature");
     polygon_3 base = f.base();
     // TODO: Add segment length test
     boost::optional<double> diameter = circle_diameter(base);
 
     if (diameter) {
-      cout << "Found circle with diameter = " << *diameter << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Found circle with diameter = " << *diameter);
       return hole_properties{*diameter, f.depth()};
     }
 
@@ -235,13 +348,13 @@ namespace gca {
       access_features(f, decomp, t, t.shank_diameter(), t.shank_length(), t.cut_length());
 
     if (shank_regions.size() == 0) {
-      cout << "Degenerate shank region!" << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Degenerate shank region!");
       return false;
     }
 
     for (auto shank_region : shank_regions) {
       if (!feature_is_safe(shank_region, decomp)) {
-	cout << "Shank region is not safe" << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Shank region is not safe");
 	return false;
       }
     }
@@ -253,7 +366,7 @@ namespace gca {
 
     for (auto holder_region : holder_regions) {
       if (!feature_is_safe(holder_region, decomp)) {
-	cout << "Holder region is not safe" << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Holder region is not safe");
 	return false;
       }
     }
@@ -266,11 +379,11 @@ namespace gca {
 				    const tool& t,
 				    feature_decomposition* decomp) {
     if (t.type() == TWIST_DRILL) {
-      cout << "Looking for through hole" << endl;
+      GCA_LOG_DEBUG(PLANNING_LOG, "Looking for through hole");
       boost::optional<hole_properties> h = through_hole_properties(f);
 
       if (h) {
-	cout << "Found through hole" << endl;
+	GCA_LOG_DEBUG(PLANNING_LOG, "Found through hole");
       }
       if (h &&
 	  within_eps(h->diameter, t.cut_diameter(), 0.0001) &&
@@ -290,24 +403,45 @@ namespace gca {
   accessable_tools_for_flat_feature(const feature& feat,
 				    feature_decomposition* f,
 				    const std::vector<tool>& tools) {
+    vector<bool> accessable =
+      parallel_map(tools, [&feat, f](const tool& t) {
+	  return can_access_feature_with_tool(feat, t, f);
+	});
+
     vector<tool> viable;
-    for (auto t : tools) {
-      if (can_access_feature_with_tool(feat, t, f)) {
-	viable.push_back(t);
+    for (unsigned i = 0; i < tools.size(); i++) {
+      if (accessable[i]) {
+	viable.push_back(tools[i]);
       }
     }
     return viable;
   }
-  
+
+  // Every (feature, tool) pair is checked concurrently, the info
+  // is assembled afterwards in feature and tool order
   tool_access_info
   find_accessable_tools(feature_decomposition* f,
 			const std::vector<tool>& tools) {
+    vector<feature*> features = collect_features(f);
+
+    vector<unsigned> pairs(features.size()*tools.size());
+    std::iota(begin(pairs), end(pairs), 0);
+
+    unsigned num_tools = tools.size();
+    vector<bool> accessable =
+      parallel_map(pairs, [&features, &tools, f, num_tools](const unsigned k) {
+	  return can_access_feature_with_tool(*(features[k / num_tools]),
+					      tools[k % num_tools],
+					      f);
+	});
+
     tool_access_info info;
-    for (auto ft : collect_features(f)) {
+    for (unsigned i = 0; i < features.size(); i++) {
+      feature* ft = features[i];
       info[ft] = {};
-      for (auto t : tools) {
-	if (can_access_feature_with_tool(*ft, t, f)) {
-	  map_insert(info, ft, t);
+      for (unsigned j = 0; j < num_tools; j++) {
+	if (accessable[i*num_tools + j]) {
+	  map_insert(info, ft, tools[j]);
 	}
       }
     }
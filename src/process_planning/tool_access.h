@@ -23,4 +23,26 @@ namespace gca {
 				    const std::vector<tool>& tools);
 
   boost::optional<double> circle_diameter(const polygon_3& base);
+
+  // The base of f shrunk by the tool radius, shifted depth_offset
+  // along its normal and grown back out to diam
+  std::vector<polygon_3> tool_access_regions(const feature& f,
+					     const tool& t,
+					     const double diam,
+					     const double depth_offset);
+
+  struct tool_access_cache_stats {
+    int interior_hits, interior_misses;
+    int region_hits, region_misses;
+
+    tool_access_cache_stats() :
+      interior_hits(0), interior_misses(0),
+      region_hits(0), region_misses(0) {}
+  };
+
+  // Offset regions are memoized by polygon contents across calls
+  // and directions, this drops them and resets the statistics
+  void clear_tool_access_cache();
+
+  tool_access_cache_stats tool_access_cache_statistics();
 }
@@ -4,6 +4,8 @@
 #include "geometry/vtk_debug.h"
 #include "process_planning/major_axis_fixturing.h"
 #include "synthesis/millability.h"
+#include "utils/log.h"
+#include "utils/parallel.h"
 
 namespace gca {
 
@@ -42,52 +44,37 @@ namespace gca {
     vtk_debug_depth_field(part_field);
     vtk_debug_depth_field(t_field);
 
-    vector<surface> accessable;
-    for (auto& nv : non_vertical) {
-      auto bound_poly = surface_boundary_polygon(nv);
-      auto bound_poly_2 = to_boost_poly_2(bound_poly);
-
-      bool contained = true;
-      for (int i = 0; i < t_field.num_x_elems; i++) {
-
-	double x = t_field.x_coord(i);
-
-	for (int j = 0; j < t_field.num_y_elems; j++) {
-
-	  double y = t_field.y_coord(j);
-
-	  auto pt = boost::geometry::model::d2::point_xy<double>(x, y);
-
-	  if (boost::geometry::within(pt, bound_poly_2)) {
+    // Each surface boundary is rasterized once onto the field grid
+    // and surfaces are checked concurrently
+    vector<bool> contained =
+      parallel_map(non_vertical, [&part_field, &t_field](const surface& nv) {
+	  auto bound_poly = surface_boundary_polygon(nv);
 
+	  for (auto cell : rasterize_polygon(bound_poly, t_field)) {
 	    double pf_height =
-	      part_field.column_height(i, j);
+	      part_field.column_height(cell.first, cell.second);
 	    double tf_height =
-	      t_field.column_height(i, j);
+	      t_field.column_height(cell.first, cell.second);
 
 	    if (pf_height < tf_height) {
-
-	      cout << "NOT CONTAINED" << endl;
-	      vtk_debug_highlight_inds(nv);
-
-	      contained = false;
-	      break;
+	      return false;
 	    }
 	  }
-	  
-	}
 
-	if (contained == false) {
-	  break;
-	}
-      }
+	  return true;
+	});
 
-      if (contained) {
-	accessable.push_back(nv);
+    vector<surface> accessable;
+    for (unsigned i = 0; i < non_vertical.size(); i++) {
+      if (contained[i]) {
+	accessable.push_back(non_vertical[i]);
+      } else {
+	GCA_LOG_DEBUG(PLANNING_LOG, "NOT CONTAINED");
+	vtk_debug_highlight_inds(non_vertical[i]);
       }
     }
 
-    cout << "# accessable surfaces = " << accessable.size() << endl;
+    GCA_LOG_DEBUG(PLANNING_LOG, "# accessable surfaces = " << accessable.size());
     
     return accessable;
   }
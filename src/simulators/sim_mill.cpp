@@ -3,6 +3,7 @@
 #include "simulators/sim_mill.h"
 #include "gcode/circular_arc.h"
 #include "gcode/linear_cut.h"
+#include "utils/instrumentation.h"
 
 namespace gca {
 
@@ -74,11 +75,27 @@ namespace gca {
     return updates;
   }
 
+  // Grid cells under the tool at each point of the cut, the tool is
+  // the same size everywhere so the start point stands for all of them
+  static long cells_in_cut(const cut& c,
+			   const int num_points,
+			   region& r,
+			   const mill_tool& t) {
+    point p = r.machine_coords_to_region_coords(c.get_start());
+    long x_cells = r.r.x_index(t.x_max(p)) + 1 - r.r.x_index(t.x_min(p));
+    long y_cells = r.r.y_index(t.y_max(p)) + 1 - r.r.y_index(t.y_min(p));
+    return num_points*x_cells*y_cells;
+  }
+
   double update_cut(const cut& c, region& r, const mill_tool& t) {
     double volume_removed = 0.0;
     double d = r.r.resolution;
     int num_points = (c.length() / d) + 1;
 
+    if (instrumentation_enabled()) {
+      count_event("cells_simulated", cells_in_cut(c, num_points, r, t));
+    }
+
     for (int i = 0; i < num_points; i++) {
       double tp = static_cast<double>(i) / static_cast<double>(num_points);
       point e = c.value_at(tp); //r.machine_coords_to_region_coords(c.value_at(tp));
@@ -99,4 +116,53 @@ namespace gca {
     return volume_removed;
   }
 
+  double update_point(const point p, voxel_volume& v, const mill_tool& t) {
+    int first_x = v.x_index(t.x_min(p));
+    int last_x = v.x_index(t.x_max(p)) + 1;
+    int first_y = v.y_index(t.y_min(p));
+    int last_y = v.y_index(t.y_max(p)) + 1;
+
+    if (instrumentation_enabled()) {
+      count_event("cells_simulated", (last_x - first_x)*(last_y - first_y));
+    }
+
+    int voxels_removed = 0;
+    for (int i = first_x; i < last_x; i++) {
+      for (int j = first_y; j < last_y; j++) {
+	if (v.legal_column(i, j)) {
+	  point column_top(v.x_center(i), v.y_center(j), v.z_max());
+
+	  if (t.contains(p, column_top)) {
+	    voxels_removed += v.clear_column_above(i, j, t.z_at(p, column_top));
+	  }
+	}
+      }
+    }
+
+    return voxels_removed*v.voxel_volume_size();
+  }
+
+  double update_cut(const cut& c, voxel_volume& v, const mill_tool& t) {
+    double volume_removed = 0.0;
+    double d = v.get_resolution();
+    int num_points = (c.length() / d) + 1;
+
+    for (int i = 0; i <= num_points; i++) {
+      double tp = static_cast<double>(i) / static_cast<double>(num_points);
+      volume_removed += update_point(c.value_at(tp), v, t);
+    }
+
+    return volume_removed;
+  }
+
+  double simulate_mill(const vector<cut*>& p, voxel_volume& v, const mill_tool& t) {
+    double volume_removed = 0.0;
+
+    for (auto c : p) {
+      volume_removed += update_cut(*c, v, t);
+    }
+
+    return volume_removed;
+  }
+
 }
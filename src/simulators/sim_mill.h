@@ -1,6 +1,7 @@
 #ifndef GCA_SIM_MILL_H
 #define GCA_SIM_MILL_H
 
+#include "geometry/voxel_volume.h"
 #include "simulators/mill_tool.h"
 #include "simulators/region.h"
 #include "simulators/sim_res.h"
@@ -16,6 +17,12 @@ namespace gca {
 
   vector<point_update>
   update_cut_with_logging(const cut& c, class region& r, const mill_tool& t);
+
+  // Full 3D simulation against a voxel stock model, unlike region
+  // this keeps material under overhangs
+  double update_point(const point p, voxel_volume& v, const mill_tool& t);
+  double update_cut(const cut& c, voxel_volume& v, const mill_tool& t);
+  double simulate_mill(const vector<cut*>& p, voxel_volume& v, const mill_tool& t);
   
 
 }
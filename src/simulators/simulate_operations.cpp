@@ -1,9 +1,11 @@
 #include "simulators/simulate_operations.h"
 
+#include "analysis/cycle_time.h"
 #include "geometry/vtk_debug.h"
 #include "simulators/sim_mill.h"
 #include "system/file.h"
 #include "utils/algorithm.h"
+#include "utils/log.h"
 
 using namespace std;
 
@@ -30,7 +32,7 @@ namespace gca {
       return "CONTOUR";
     }
   
-    cout << "UNRECOGNIZED OP STRING = " << op << endl;
+    GCA_LOG_WARNING(SIMULATION_LOG, "Unrecognized op string = " << op);
     return "UNKNOWN";
   }
 
@@ -44,7 +46,7 @@ namespace gca {
 
   
   tool_end read_tool_end(std::string& comment) {
-    cout << "tool comment = " << comment << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "tool comment = " << comment);
 
     string r("ROUGH");
     if (starts_with(comment, r)) {
@@ -91,7 +93,7 @@ namespace gca {
       return KEY_CUTTER_ENDMILL;
     }
   
-    cout << "UNKNOWN TOOL COMMENT = " << comment << endl;
+    GCA_LOG_WARNING(SIMULATION_LOG, "Unknown tool comment = " << comment);
     return FINISH_ENDMILL;
   }
 
@@ -99,21 +101,21 @@ namespace gca {
   void add_tool_HAAS(map<int, tool_info>& tt, string& comment) {
     string tool_comment_start = "( TOOL ";
     if (starts_with(comment, tool_comment_start)) {
-      cout << "Tool comment is " << comment << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, "Tool comment is " << comment);
       size_t i = -1;
       int tool_no = stoi(comment.substr(tool_comment_start.size()), &i);
-      cout << "tool_no = " << tool_no << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, "tool_no = " << tool_no);
       assert(i != -1);
       string rest = comment.substr(tool_comment_start.size() + i);
 
-      cout << "Rest of comment = " << rest << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, "Rest of comment = " << rest);
 
       size_t j = -1;
       double tool_diameter = stod(rest, &j);
       string tool_comment = rest.substr(j + 1);
       tool_end end = read_tool_end(tool_comment);
     
-      cout << "tool diameter = " << tool_diameter << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, "tool diameter = " << tool_diameter);
       tool_info tf{end, tool_diameter};
       tt[tool_no] = tf;
     }
@@ -139,13 +141,13 @@ namespace gca {
   int extract_tool_number_GCA(const std::string& text) {
     string tool_no_comment_start = "(*** TOOL NUMBER = ";
 
-    cout << "Tool number comment = " << text << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "Tool number comment = " << text);
 
     DBG_ASSERT(starts_with(text, tool_no_comment_start));
 
     size_t i = -1;
     int tool_no = stoi(text.substr(tool_no_comment_start.size()), &i);
-    cout << "tool_no = " << tool_no << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "tool_no = " << tool_no);
     DBG_ASSERT(i != -1);
 
     return tool_no;
@@ -170,10 +172,10 @@ namespace gca {
 
       string tool_comment_start = "(*** TOOL DIAMETER = ";
       if (starts_with(comment, tool_comment_start)) {
-	cout << "Tool comment is " << comment << endl;
+	GCA_LOG_DEBUG(SIMULATION_LOG, "Tool comment is " << comment);
 	size_t i = -1;
 	double tool_diameter = stod(comment.substr(tool_comment_start.size()), &i);
-	cout << "tool_diameter = " << tool_diameter << endl;
+	GCA_LOG_DEBUG(SIMULATION_LOG, "tool_diameter = " << tool_diameter);
 	DBG_ASSERT(i != -1);
 
 	unsigned num_comment_ind = cnum + 2;
@@ -208,11 +210,11 @@ namespace gca {
       if (starts_with(comment, len_comment_start) &&
 	  ends_with(comment, len_comment_end)) {
 
-	cout << "Length comment is " << comment << endl;
+	GCA_LOG_DEBUG(SIMULATION_LOG, "Length comment is " << comment);
 
 	double len = stod(comment.substr(len_comment_start.size()));
 
-	cout << "length = " << len << endl;
+	GCA_LOG_DEBUG(SIMULATION_LOG, "length = " << len);
 
 	return len;
       }
@@ -260,13 +262,13 @@ namespace gca {
     }
 
     int last_line_no = p.back().back().line_no;
-    cout << "last line number = " << last_line_no << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "last line number = " << last_line_no);
   
     op_ranges.back().end_line = last_line_no;
 
-    cout << "# of op ranges = " << op_ranges.size() << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "# of op ranges = " << op_ranges.size());
     for (auto& op : op_ranges) {
-      cout << op << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, op);
     }
 
     return op_ranges;
@@ -324,13 +326,13 @@ namespace gca {
     }
 
     int last_line_no = p.back().back().line_no;
-    cout << "last line number = " << last_line_no << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "last line number = " << last_line_no);
   
     op_ranges.back().end_line = last_line_no;
 
-    cout << "# of op ranges = " << op_ranges.size() << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "# of op ranges = " << op_ranges.size());
     for (auto& op : op_ranges) {
-      cout << op << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, op);
     }
 
     return op_ranges;
@@ -494,7 +496,8 @@ namespace gca {
 
   operation_params
   build_operation_summary(const double sim_resolution,
-			  const operation_log& op_log) {
+			  const operation_log& op_log,
+			  const machine_profile& machine) {
 
     int current_tool_no = op_log.info.range.tool_number;
     double tool_diameter = op_log.info.tool_inf.tool_diameter;
@@ -540,15 +543,19 @@ namespace gca {
     double total_length_inches = 0.0;
     double cut_length_inches = 0.0;
 
-    double total_time_seconds = execution_time_seconds(path);
+    vector<double> cut_times = cut_times_seconds(path, machine);
+
+    double total_time_seconds = 0.0;
     double cut_time_seconds = 0.0;
 
-    for (auto& c : path) {
+    for (unsigned i = 0; i < path.size(); i++) {
+      const cut* c = path[i];
       total_length_inches += c->length();
+      total_time_seconds += cut_times[i];
 
       if (!c->is_safe_move()) {
 	cut_length_inches += c->length();
-	cut_time_seconds += cut_execution_time_seconds(c);
+	cut_time_seconds += cut_times[i];
       }
     }
 
@@ -582,7 +589,7 @@ namespace gca {
 			  map<int, tool_info>& tool_table,
 			  const std::vector<operation_range>& op_ranges) {
 
-    cout << "# of op ranges = " << op_ranges.size() << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "# of op ranges = " << op_ranges.size());
 
     auto op_paths = segment_cuts(paths, op_ranges);
 
@@ -591,7 +598,7 @@ namespace gca {
 
       auto path = path_op_pair.second;
 
-      cout << "Looking up tool diameter" << endl;
+      GCA_LOG_DEBUG(SIMULATION_LOG, "Looking up tool diameter");
       auto c_iter = find_if(path.begin(), path.end(),
 			    [](const cut* c) { return !c->is_safe_move(); });
 
@@ -646,14 +653,17 @@ namespace gca {
   std::vector<operation_params>
   program_operations_HAAS(std::vector<std::vector<cut*> >& paths,
 			  map<int, tool_info>& tool_table,
-			  const std::vector<operation_range>& op_ranges) {
+			  const std::vector<operation_range>& op_ranges,
+			  const machine_profile& m) {
 
     simulation_log sim_log = simulation_log_HAAS(paths, tool_table, op_ranges);
     
     vector<operation_params> ops;
 
     for (auto& op_log : sim_log.operation_logs) {
-      ops.push_back(build_operation_summary(sim_log.resolution, op_log));
+      ops.push_back(build_operation_summary(sim_log.resolution,
+					    op_log,
+					    m));
     }
 
     return ops;
@@ -683,7 +693,7 @@ namespace gca {
 			 map<int, tool_info>& tool_table,
 			 const std::vector<operation_range>& op_ranges) {
 
-    cout << "# of op ranges = " << op_ranges.size() << endl;
+    GCA_LOG_DEBUG(SIMULATION_LOG, "# of op ranges = " << op_ranges.size());
 
     auto op_paths = segment_cuts(paths, op_ranges);
 
@@ -707,14 +717,17 @@ namespace gca {
   std::vector<operation_params>
   program_operations_GCA(std::vector<std::vector<cut*> >& paths,
 			 map<int, tool_info>& tool_table,
-			 const std::vector<operation_range>& op_ranges) {
+			 const std::vector<operation_range>& op_ranges,
+			 const machine_profile& m) {
 
     simulation_log l = simulation_log_GCA(paths, tool_table, op_ranges);
 
     vector<operation_params> ops;
 
     for (auto& op_log : l.operation_logs) {
-      ops.push_back(build_operation_summary(l.resolution, op_log));
+      ops.push_back(build_operation_summary(l.resolution,
+					    op_log,
+					    m));
     }
 
     return ops;
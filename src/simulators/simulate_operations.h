@@ -1,5 +1,6 @@
 #pragma once
 
+#include "analysis/cycle_time.h"
 #include "backend/cut_params.h"
 #include "gcode/cut.h"
 #include "gcode/lexer.h"
@@ -119,15 +120,19 @@ namespace gca {
   std::ostream& operator<<(std::ostream& out, const operation_range& op_range);
   std::ostream& operator<<(std::ostream& out, const operation_params& op);
 
+  // Cycle times of the operations are estimated for machine m, the
+  // one the program was written for
   std::vector<operation_params>
   program_operations_GCA(std::vector<std::vector<cut*> >& paths,
 			 map<int, tool_info>& tool_table,
-			 const std::vector<operation_range>& op_ranges);
+			 const std::vector<operation_range>& op_ranges,
+			 const machine_profile& m);
 
   std::vector<operation_params>
   program_operations_HAAS(std::vector<std::vector<cut*> >& paths,
 			  map<int, tool_info>& tool_table,
-			  const std::vector<operation_range>& op_ranges);
+			  const std::vector<operation_range>& op_ranges,
+			  const machine_profile& m);
   
   double estimate_feedrate_median(const std::vector<cut*>& path);
 
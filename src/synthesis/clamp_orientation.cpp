@@ -1,4 +1,5 @@
 #include "geometry/extrusion.h"
+#include "geometry/nef_cache.h"
 #include "geometry/polygon_3.h"
 #include "geometry/vtk_debug.h"
 #include "synthesis/clamp_orientation.h"
@@ -139,7 +140,7 @@ namespace gca {
 			  const plane vice_top_plane) {
     point n = -1*vice_top_plane.normal();
 
-    auto part = nef_to_single_trimesh(part_nef);
+    auto part = cached_nef_to_single_trimesh(part_nef);
     polygon_3 hull = convex_hull_2D(part.vertex_list(),
 				    n,
 				    0.0);
@@ -160,7 +161,7 @@ namespace gca {
     // cout << "Clipper and clippee" << endl;
     // vtk_debug_meshes({part, m});
     
-    auto clip_nef = trimesh_to_nef_polyhedron(m);
+    auto clip_nef = cached_trimesh_to_nef_polyhedron(m);
     auto cut_parts_nef = part_nef - clip_nef;
 
     //    DBG_ASSERT(cut_parts.size() == 1);
@@ -173,7 +174,7 @@ namespace gca {
 			      const vice& v,
 			      const point n) {
 
-    auto part = nef_to_single_trimesh(part_nef);
+    auto part = cached_nef_to_single_trimesh(part_nef);
     
     point vice_pl_pt = min_point_in_dir(part, n) + v.jaw_height()*n;
     plane vice_top_plane(-1*n, vice_pl_pt);
@@ -210,7 +211,7 @@ namespace gca {
   all_stable_orientations_with_side_transforms(const Nef_polyhedron& part_nef,
 					       const vice& v,
 					       const point n) {
-    auto part = nef_to_single_trimesh(part_nef);
+    auto part = cached_nef_to_single_trimesh(part_nef);
     polygon_3 hull = convex_hull_2D(part.vertex_list(), n, 0.0);
 
     point vice_pl_pt = min_point_in_dir(part, n) + v.jaw_height()*n;
@@ -232,7 +233,7 @@ namespace gca {
     // cout << "Clipper and clippee" << endl;
     // vtk_debug_meshes({part, m});
 
-    auto clip_nef = trimesh_to_nef_polyhedron(m);
+    auto clip_nef = cached_trimesh_to_nef_polyhedron(m);
     auto cut_parts_nef = part_nef - clip_nef;
 
     //    DBG_ASSERT(cut_parts.size() == 1);
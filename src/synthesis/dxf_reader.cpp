@@ -6,14 +6,15 @@ namespace gca {
   public:
 
     bool log;
+    dxf_entity_sink& sink;
 
-    dxf_reader(bool plog) : log(plog) {}
+    dxf_reader(bool plog, dxf_entity_sink& psink) :
+      log(plog), sink(psink), current_spline(0), spline_open(false) {}
 
-    vector<hole_punch*> hole_punches;
-
-    vector<cut*> cuts;
-
-    vector<b_spline*> splines;
+    // Splines arrive one knot and control point at a time, they are
+    // passed on once the last of them is read
+    b_spline current_spline;
+    bool spline_open;
 
     int current_polyline_n;
     int polyline_vertices_left;
@@ -21,6 +22,15 @@ namespace gca {
     unsigned num_knots;
     unsigned num_control_points;
 
+    void finish_spline() {
+      if (spline_open &&
+	  current_spline.num_knots() == num_knots &&
+	  current_spline.num_control_points() == num_control_points) {
+	sink.spline(current_spline);
+	spline_open = false;
+      }
+    }
+
     virtual void addSpline(const DL_SplineData& data) {
       if (log) {
 	printf("SPLINE\n");
@@ -32,7 +42,9 @@ namespace gca {
       assert(data.nKnots == data.nControl + data.degree + 1);
       num_knots = data.nKnots;
       num_control_points = data.nControl;
-      splines.push_back(b_spline::make(data.degree));
+      current_spline = b_spline(data.degree);
+      spline_open = true;
+      finish_spline();
     }
 
     virtual void addControlPoint(const DL_ControlPointData& data) {
@@ -41,8 +53,9 @@ namespace gca {
 	       data.x, data.y, data.z);
 	printAttributes();
       }
-      assert(splines.back()->num_control_points() < num_control_points);
-      splines.back()->push_control_point(point(data.x, data.y, data.z));
+      assert(current_spline.num_control_points() < num_control_points);
+      current_spline.push_control_point(point(data.x, data.y, data.z));
+      finish_spline();
     }
 	
     virtual void addKnot(const DL_KnotData& data) {
@@ -50,8 +63,9 @@ namespace gca {
 	printf("KNOT    %6.4f\n", data.k);
 	printAttributes();
       }
-      assert(splines.back()->num_knots() < num_knots);
-      splines.back()->push_knot(data.k);
+      assert(current_spline.num_knots() < num_knots);
+      current_spline.push_knot(data.k);
+      finish_spline();
     }
 
     void setAttributes(const DL_Attributes& attrib) {
@@ -96,7 +110,7 @@ namespace gca {
       assert(data.z2 == 0);
       point s(data.x1, data.y1, data.z1);
       point e(data.x2, data.y2, data.z2);
-      cuts.push_back(linear_cut::make(s, e));
+      sink.line(s, e);
     }
 
     void addArc(const DL_ArcData& data) {
@@ -116,7 +130,7 @@ namespace gca {
 	printAttributes();
       }
       assert(data.cz == 0);
-      hole_punches.push_back(hole_punch::make(point(data.cx, data.cy, data.cz), data.radius));
+      sink.hole(point(data.cx, data.cy, data.cz), data.radius);
     }
 
     void addPolyline(const DL_PolylineData& data) {
@@ -143,7 +157,7 @@ namespace gca {
       }
       point v(data.x, data.y, data.z);
       if (polyline_vertices_left < current_polyline_n) {
-	cuts.push_back(linear_cut::make(last_vertex, v));
+	sink.line(last_vertex, v);
       }
       last_vertex = v;    
       polyline_vertices_left--;
@@ -214,16 +228,41 @@ namespace gca {
 
   };
 
-  shape_layout read_dxf(const char* file, bool log) {
-    dxf_reader* listener = new (allocate<dxf_reader>()) dxf_reader(log);
-    DL_Dxf* dxf = new (allocate<DL_Dxf>()) DL_Dxf();
-    if (!dxf->in(file, listener)) {
+  // Collects every entity of a file into arena allocated shapes
+  class shape_collector : public dxf_entity_sink {
+  public:
+    vector<hole_punch*> hole_punches;
+    vector<cut*> cuts;
+    vector<b_spline*> splines;
+
+    void line(const point s, const point e) {
+      cuts.push_back(linear_cut::make(s, e));
+    }
+
+    void hole(const point center, const double radius) {
+      hole_punches.push_back(hole_punch::make(center, radius));
+    }
+
+    void spline(const b_spline& s) {
+      splines.push_back(new (allocate<b_spline>()) b_spline(s));
+    }
+  };
+
+  void stream_dxf(const char* file, dxf_entity_sink& sink, bool log) {
+    dxf_reader listener(log, sink);
+    DL_Dxf dxf;
+    if (!dxf.in(file, &listener)) {
       std::cerr << file << " could not be opened.\n";
       assert(false);
     }
-    shape_layout shapes_to_cut(listener->cuts,
-			       listener->hole_punches,
-			       listener->splines);
+  }
+
+  shape_layout read_dxf(const char* file, bool log) {
+    shape_collector shapes;
+    stream_dxf(file, shapes, log);
+    shape_layout shapes_to_cut(shapes.cuts,
+			       shapes.hole_punches,
+			       shapes.splines);
     return shapes_to_cut;
   }
 
@@ -8,6 +8,19 @@
 
 namespace gca {
 
+  // Receives the entities of a DXF file as they are parsed, so the
+  // whole file never has to be held in memory
+  class dxf_entity_sink {
+  public:
+    virtual ~dxf_entity_sink() {}
+
+    virtual void line(const point s, const point e) = 0;
+    virtual void hole(const point center, const double radius) = 0;
+    virtual void spline(const b_spline& s) = 0;
+  };
+
+  void stream_dxf(const char* file, dxf_entity_sink& sink, bool log=false);
+
   shape_layout read_dxf(const char* file, bool log=false);
 
 }
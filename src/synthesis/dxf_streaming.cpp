@@ -0,0 +1,219 @@
+#include <deque>
+#include <future>
+#include <memory>
+
+#include "backend/cut_to_gcode.h"
+#include "backend/output.h"
+#include "backend/shapes_to_gcode.h"
+#include "backend/shapes_to_toolpaths.h"
+#include "gcode/hole_punch.h"
+#include "gcode/linear_cut.h"
+#include "synthesis/dxf_reader.h"
+#include "synthesis/dxf_streaming.h"
+#include "utils/parallel.h"
+
+namespace gca {
+
+  struct dxf_batch {
+    vector<pair<point, point>> lines;
+    vector<pair<point, double>> holes;
+    vector<b_spline> splines;
+
+    unsigned size() const {
+      return lines.size() + holes.size() + splines.size();
+    }
+
+    // Room for the cuts of a batch of lines and holes, a line takes
+    // under 1KB. Flattened splines can take a few hundred KB each, the
+    // arena grows for them as they are cut rather than reserving that
+    size_t arena_size() const {
+      return 4096 + 2048*size();
+    }
+  };
+
+  // Cuts of one batch and the arena they live in
+  struct cut_batch {
+    unique_ptr<arena_allocator> arena;
+    vector<cut*> cuts;
+  };
+
+  static cut_batch plan_batch(const dxf_batch& b, const cut_params& params) {
+    cut_batch planned;
+    planned.arena.reset(new arena_allocator(b.arena_size()));
+    thread_arena_scope scope(planned.arena.get());
+
+    vector<cut*> lines;
+    for (auto& l : b.lines) {
+      lines.push_back(linear_cut::make(l.first, l.second));
+    }
+    vector<hole_punch*> holes;
+    for (auto& h : b.holes) {
+      holes.push_back(hole_punch::make(h.first, h.second));
+    }
+    vector<b_spline*> splines;
+    for (auto& s : b.splines) {
+      splines.push_back(new (allocate<b_spline>()) b_spline(s));
+    }
+
+    shape_layout l(lines, holes, splines);
+    planned.cuts = shape_cuts(l, params);
+    return planned;
+  }
+
+  // Writes planned batches in order with the transitions between
+  // them. The last batch written is kept until the next one is, the
+  // transition into the next batch starts from its last cut
+  class batch_writer {
+  protected:
+    const cut_params& params;
+    gcode_writer& w;
+    cut_batch previous;
+
+    // The last cut as planned and as it was written, after the shift
+    cut* last_cut;
+    cut* last_written;
+
+    void emit(const vector<cut*>& cuts) {
+      vector<cut*> shifted = shift_cuts(cuts, point(0, 0, params.machine_z_zero));
+      set_feedrates(shifted, params);
+      write_cuts_gcode(last_written, shifted, params, false, w);
+      if (shifted.size() > 0) { last_written = shifted.back(); }
+    }
+
+  public:
+    batch_writer(const cut_params& p_params, gcode_writer& p_w) :
+      params(p_params), w(p_w), last_cut(NULL), last_written(NULL) {}
+
+    void write(cut_batch b) {
+      thread_arena_scope scope(b.arena.get());
+
+      vector<cut*> all_cuts;
+      for (auto next_cut : b.cuts) {
+	vector<cut*> transition = move_to_next_cut(last_cut, next_cut, params);
+	for (auto t : transition) {
+	  t->tool_no = next_cut->tool_no;
+	}
+	all_cuts.insert(all_cuts.end(), transition.begin(), transition.end());
+	all_cuts.push_back(next_cut);
+	last_cut = next_cut;
+      }
+      emit(all_cuts);
+
+      if (b.cuts.size() > 0) { previous = std::move(b); }
+    }
+
+    void finish() {
+      if (last_cut == NULL) { return; }
+
+      thread_arena_scope scope(previous.arena.get());
+      vector<cut*> tail{last_cut};
+      insert_move_home(tail, params);
+      emit(vector<cut*>(tail.begin() + 1, tail.end()));
+    }
+  };
+
+  // Fills batches with the entities of one kind as the parser reads
+  // them. Full batches are planned on worker threads, once
+  // max_in_flight are underway the oldest is written before the next
+  // one starts
+  class batching_sink : public dxf_entity_sink {
+  protected:
+    const cut_params& params;
+    batch_writer& out;
+    const unsigned batch_size;
+    const unsigned max_in_flight;
+    const bool take_holes;
+
+    std::shared_ptr<dxf_batch> current;
+    std::deque<std::future<cut_batch>> in_flight;
+
+    void write_oldest() {
+      out.write(in_flight.front().get());
+      in_flight.pop_front();
+    }
+
+    void dispatch() {
+      if (current->size() == 0) { return; }
+      if (in_flight.size() >= max_in_flight) { write_oldest(); }
+
+      std::shared_ptr<dxf_batch> b = current;
+      const cut_params* p = &params;
+      in_flight.push_back(std::async(std::launch::async, [b, p]() {
+	    worker_thread_scope worker;
+	    return plan_batch(*b, *p);
+	  }));
+      current = std::make_shared<dxf_batch>();
+    }
+
+    void added() {
+      if (current->size() >= batch_size) { dispatch(); }
+    }
+
+  public:
+    batching_sink(const cut_params& p_params,
+		  batch_writer& p_out,
+		  const unsigned p_batch_size,
+		  const bool p_take_holes) :
+      params(p_params),
+      out(p_out),
+      batch_size(p_batch_size),
+      max_in_flight(2*num_worker_threads()),
+      take_holes(p_take_holes),
+      current(std::make_shared<dxf_batch>()) {}
+
+    void line(const point s, const point e) {
+      if (take_holes) { return; }
+      current->lines.push_back(make_pair(s, e));
+      added();
+    }
+
+    void hole(const point center, const double radius) {
+      if (!take_holes) { return; }
+      current->holes.push_back(make_pair(center, radius));
+      added();
+    }
+
+    void spline(const b_spline& s) {
+      if (take_holes) { return; }
+      current->splines.push_back(s);
+      added();
+    }
+
+    void finish() {
+      dispatch();
+      while (in_flight.size() > 0) { write_oldest(); }
+    }
+  };
+
+  void stream_dxf_to_gcode(const char* file,
+			   const cut_params& params,
+			   gcode_writer& w,
+			   const unsigned batch_size) {
+    DBG_ASSERT(batch_size > 0);
+
+    vector<block> header;
+    append_header_blocks(header, params.target_machine);
+    w.write(header);
+
+    batch_writer out(params, w);
+
+    // shape_cuts drills every hole before cutting any shape, so the
+    // holes are read in a pass of their own
+    if (params.tools != DRAG_KNIFE_ONLY) {
+      batching_sink holes(params, out, batch_size, true);
+      stream_dxf(file, holes);
+      holes.finish();
+    }
+
+    batching_sink shapes(params, out, batch_size, false);
+    stream_dxf(file, shapes);
+    shapes.finish();
+
+    out.finish();
+
+    vector<block> footer;
+    append_footer_blocks(footer, params.target_machine);
+    w.write(footer);
+  }
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "backend/cut_params.h"
+#include "gcode/gcode_writer.h"
+
+namespace gca {
+
+  // Writes the program shape_layout_to_gcode would make for the shapes
+  // in file without holding the whole file. Entities are read into
+  // batches of batch_size that are planned on worker threads, and only
+  // the batches in flight are kept in memory.
+  //
+  // Each batch is planned as its own layout: lines only chain to lines
+  // in the same batch and finishing cuts follow the main cuts of their
+  // batch. A file with no more than batch_size holes and no more than
+  // batch_size lines and splines gives the same program as
+  // shape_layout_to_gcode
+  void stream_dxf_to_gcode(const char* file,
+			   const cut_params& params,
+			   gcode_writer& w,
+			   const unsigned batch_size = 4096);
+
+}
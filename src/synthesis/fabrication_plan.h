@@ -71,6 +71,7 @@ namespace gca {
     const rigid_arrangement& arrangement() const { return a; }
 
     const std::vector<toolpath>& toolpaths() const { return tps; }
+    std::vector<toolpath>& toolpaths() { return tps; }
 
     template<typename F>
     gcode_program gcode_for_toolpaths(F f) const {
@@ -100,6 +101,7 @@ namespace gca {
 
     //    const triangular_mesh* final_part_mesh() const { return final_part; }
     const std::vector<fabrication_setup>& steps() const { return fab_steps; }
+    std::vector<fabrication_setup>& steps() { return fab_steps; }
     const std::vector<fabrication_plan*>& custom_fixtures() const
     { return custom_fixes; }
   };
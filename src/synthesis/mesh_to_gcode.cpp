@@ -1,8 +1,13 @@
+#include "backend/arc_fitting.h"
 #include "backend/gcode_generation.h"
+#include "geometry/nef_cache.h"
+#include "process_planning/tool_access.h"
 #include "synthesis/mesh_to_gcode.h"
 #include "backend/toolpath_generation.h"
 #include "synthesis/workpiece_clipping.h"
 #include "utils/algorithm.h"
+#include "utils/instrumentation.h"
+#include "utils/log.h"
 
 namespace gca {
 
@@ -43,16 +48,60 @@ namespace gca {
 				 {inputs.w});
   }
 
+  fabrication_plan make_fabrication_plan(const triangular_mesh& part_mesh,
+					 const fabrication_inputs& inputs,
+					 const feed_optimization_params& feeds) {
+    fabrication_plan plan = make_fabrication_plan(part_mesh, inputs);
+    optimize_feedrates(plan, feeds);
+    return plan;
+  }
+
+  // The part mesh of each setup is the stock it starts from, the
+  // toolpaths of a setup are simulated in order against it
+  void optimize_feedrates(fabrication_plan& plan,
+			  const feed_optimization_params& feeds) {
+    phase_timer phase("optimize_feedrates");
+
+    for (auto& setup : plan.steps()) {
+      class region sim_region = stock_region(setup.part_mesh(), feeds.resolution);
+
+      for (auto& tp : setup.toolpaths()) {
+	tp = optimize_feedrates_by_MRR_simulation(sim_region, tp, feeds);
+      }
+    }
+  }
+
+  void fit_arcs(fabrication_plan& plan, const double tolerance) {
+    for (auto& setup : plan.steps()) {
+      for (auto& tp : setup.toolpaths()) {
+	tp = fit_arcs(tp, tolerance);
+      }
+    }
+  }
+
   fabrication_plan
   fabrication_plan_for_fixture_plan(const fixture_plan& plan,
 				     const triangular_mesh& part_mesh,
 				     const std::vector<tool>& tools,
 				     const workpiece& w) {
+    phase_timer phase("toolpath_generation");
+
+    // Pockets of all setups are milled together so that in parallel
+    // mode every pocket of the plan can go to its own worker
+    vector<vector<pocket>> setup_pockets;
+    for (auto& setup : plan.fixtures()) {
+      setup_pockets.push_back(setup.pockets);
+    }
+
+    vector<vector<toolpath>> setup_toolpaths =
+      mill_pocket_lists(setup_pockets, w.stock_material);
+
     vector<fabrication_setup> setups;
-    for (auto setup : plan.fixtures()) {
-      auto toolpaths =
-	cut_secured_mesh(setup.pockets, w.stock_material);
-      setups.push_back(fabrication_setup(setup.arrangement(), setup.fix.v, toolpaths));
+    for (unsigned i = 0; i < plan.fixtures().size(); i++) {
+      const fixture_setup& setup = plan.fixtures()[i];
+      setups.push_back(fabrication_setup(setup.arrangement(),
+					 setup.fix.v,
+					 setup_toolpaths[i]));
     }
 
     return fabrication_plan(&part_mesh, setups, plan.custom_fixtures());
@@ -62,51 +111,53 @@ namespace gca {
 					 const fixtures& f,
 					 const vector<tool>& tools,
 					 const std::vector<workpiece>& wps) {
-    fixture_plan plan = make_fixture_plan(part_mesh, f, tools, wps);
+    phase_timer phase("make_fabrication_plan");
 
-    return fabrication_plan_for_fixture_plan(plan, part_mesh, tools, plan.stock());
-  }
+    clear_nef_cache();
+    clear_tool_access_cache();
 
-  void print_programs(const fabrication_plan& fix_plan) {
-    cout << "Programs" << endl;
+    fixture_plan plan = make_fixture_plan(part_mesh, f, tools, wps);
 
-    cout.setf(ios::fixed, ios::floatfield);
-    cout.setf(ios::showpoint);
+    fabrication_plan fab_plan =
+      fabrication_plan_for_fixture_plan(plan, part_mesh, tools, plan.stock());
 
-    for (auto f : fix_plan.steps()) {
-      auto program = f.gcode_for_toolpaths(emco_f1_code);
-      cout << program.name << endl;
-      cout << program.blocks << endl;
-    }
+    GCA_LOG_DEBUG(SYNTHESIS_LOG, "Nef conversion cache" << endl << nef_cache_statistics());
+
+    clear_nef_cache();
+    clear_tool_access_cache();
 
+    return fab_plan;
   }
 
-  void print_programs_no_TLC(const fabrication_plan& fix_plan) {
+  // Streams each step straight to cout, the text is the same as
+  // printing the blocks of gcode_for_toolpaths in fixed notation
+  static void print_programs(const fabrication_plan& fix_plan,
+			     const post_processor& post) {
     cout << "Programs" << endl;
 
     cout.setf(ios::fixed, ios::floatfield);
     cout.setf(ios::showpoint);
 
-    for (auto f : fix_plan.steps()) {
-      auto program = f.gcode_for_toolpaths(emco_f1_code_no_TLC);
-      cout << program.name << endl;
-      cout << program.blocks << endl;
+    gcode_writer w(cout);
+    for (auto& f : fix_plan.steps()) {
+      w.text("Surface cut\n");
+      write_gcode_program(f.toolpaths(), post, w);
+      w.end_block();
     }
-
+    w.flush();
+    cout.flush();
   }
 
-  void print_programs_wells_no_TLC(const fabrication_plan& fix_plan) {
-    cout << "Programs" << endl;
-
-    cout.setf(ios::fixed, ios::floatfield);
-    cout.setf(ios::showpoint);
+  void print_programs(const fabrication_plan& fix_plan) {
+    print_programs(fix_plan, emco_f1_post());
+  }
 
-    for (auto f : fix_plan.steps()) {
-      auto program = f.gcode_for_toolpaths(wells_code_no_TLC);
-      cout << program.name << endl;
-      cout << program.blocks << endl;
-    }
+  void print_programs_no_TLC(const fabrication_plan& fix_plan) {
+    print_programs(fix_plan, emco_f1_no_TLC_post());
+  }
 
+  void print_programs_wells_no_TLC(const fabrication_plan& fix_plan) {
+    print_programs(fix_plan, wells_no_TLC_post());
   }
   
 }
@@ -1,6 +1,7 @@
 #ifndef MESH_TO_GCODE_H
 #define MESH_TO_GCODE_H
 
+#include "backend/feedrate_optimization.h"
 #include "geometry/surface.h"
 #include "synthesis/fabrication_plan.h"
 #include "synthesis/fixture_analysis.h"
@@ -24,6 +25,19 @@ namespace gca {
   fabrication_plan make_fabrication_plan(const triangular_mesh& m,
 					 const fabrication_inputs& inputs);
 
+  // Same plan with the feeds of every cut picked by simulating
+  // material removal from the stock of each setup
+  fabrication_plan make_fabrication_plan(const triangular_mesh& m,
+					 const fabrication_inputs& inputs,
+					 const feed_optimization_params& feeds);
+
+  void optimize_feedrates(fabrication_plan& plan,
+			  const feed_optimization_params& feeds);
+
+  // Replaces the linear cuts of every toolpath in the plan with
+  // lines and arcs within tolerance of them, see fit_arcs
+  void fit_arcs(fabrication_plan& plan, const double tolerance);
+
 
   std::vector<toolpath> cut_secured_mesh(vector<pocket>& pockets,
 					 const material& stock_material);
@@ -1,21 +1,10 @@
+#include "geometry/mesh_bvh.h"
 #include "synthesis/millability.h"
 #include "utils/algorithm.h"
+#include "utils/parallel.h"
 
 namespace gca {
 
-  std::vector<index_t> all_intersections(const vector<index_t>& all_face_inds,
-					 const triangular_mesh& part,
-					 const line test_segment) {
-    vector<index_t> ints;
-    for (auto i : all_face_inds) {
-      triangle t = part.face_triangle(i);
-      if (intersects(t, test_segment)) {
-	ints.push_back(i);
-      }
-    }
-    return ints;
-  }
-
   line test_segment(const double inc,
 		    const point dir,
 		    point p) {
@@ -125,6 +114,7 @@ namespace gca {
 
   std::vector<index_t> top_millable_faces(const point normal,
 					  const std::vector<index_t>& all_face_inds,
+					  const mesh_bvh& faces,
 					  const triangular_mesh& part) {
     vector<index_t> inds;
     vector<point> centroids(all_face_inds.size());
@@ -140,15 +130,14 @@ namespace gca {
 
     DBG_ASSERT(all_face_inds.size() == segments.size());
     DBG_ASSERT(centroids.size() == segments.size());
+
+    vector<vector<index_t>> segment_hits = faces.all_hits(segments);
     
     for (unsigned i = 0; i < all_face_inds.size(); i++) {
-      auto test_segment = segments[i];
-      vector<index_t> intersecting_faces = all_intersections(all_face_inds,
-    							     part,
-    							     test_segment);
+      const vector<index_t>& intersecting_faces = segment_hits[i];
       if (intersecting_faces.size() > 0) {
 	auto m_e = max_element(begin(intersecting_faces), end(intersecting_faces),
-			       [centroids, normal](const index_t l, const index_t r) {
+			       [&centroids, normal](const index_t l, const index_t r) {
 				 point cl = centroids[l];
 				 point cr = centroids[r];
 				 return signed_distance_along(cl, normal) <
@@ -165,6 +154,7 @@ namespace gca {
 
   std::vector<index_t> side_millable_faces(const point normal,
 					   const std::vector<index_t>& all_face_inds,
+					   const mesh_bvh& faces,
 					   const triangular_mesh& part) {
     vector<index_t> vertical_faces;
     for (auto i : all_face_inds) {
@@ -189,12 +179,11 @@ namespace gca {
 
     DBG_ASSERT(vertical_faces.size() == segments.size());
     DBG_ASSERT(centroids.size() == segments.size());
+
+    vector<vector<index_t>> segment_hits = faces.all_hits(segments);
     
     for (unsigned i = 0; i < vertical_faces.size(); i++) {
-      auto test_segment = segments[i];
-      vector<index_t> intersecting_faces = all_intersections(all_face_inds,
-    							     part,
-    							     test_segment);
+      const vector<index_t>& intersecting_faces = segment_hits[i];
       bool found_larger = false;
       point pc = part.face_triangle(vertical_faces[i]).centroid();
       for (auto k : intersecting_faces) {
@@ -211,13 +200,22 @@ namespace gca {
     }
     return inds;
   }
+
+  std::vector<index_t> side_millable_faces(const point normal,
+					   const std::vector<index_t>& all_face_inds,
+					   const triangular_mesh& part) {
+    mesh_bvh faces(part, all_face_inds);
+    return side_millable_faces(normal, all_face_inds, faces, part);
+  }
   
   std::vector<index_t> millable_faces(const point normal,
 				      const triangular_mesh& part) {
     vector<index_t> all_face_inds = part.face_indexes();
+    mesh_bvh faces(part);
     
-    vector<index_t> inds = top_millable_faces(normal, all_face_inds, part);
-    vector<index_t> side_inds = side_millable_faces(normal, all_face_inds, part);
+    vector<index_t> inds = top_millable_faces(normal, all_face_inds, faces, part);
+    vector<index_t> side_inds =
+      side_millable_faces(normal, all_face_inds, faces, part);
     concat(inds, side_inds);
     sort(begin(inds), end(inds));
     inds.erase(unique(begin(inds), end(inds)), end(inds));
@@ -309,19 +307,17 @@ namespace gca {
     double ray_len = 2*greater_than_diameter(normal, part.vertex_list());
     // vector<line> segments = construct_test_segments(normal, centroids, ray_len);
 
-    auto all_face_inds = part.face_indexes();
+    mesh_bvh faces(part);
     // DBG_ASSERT(all_face_inds.size() == segments.size());
     // DBG_ASSERT(centroids.size() == segments.size());
-    
-    for (int i = 0; i < df.num_x_elems; i++) {
+
+    parallel_for(df.num_x_elems, [&](const unsigned i) {
       for (int j = 0; j < df.num_y_elems; j++) {
 	auto test_segment = build_segment(i, j, df, bb);
-	vector<index_t> intersecting_faces = all_intersections(all_face_inds,
-							       part,
-							       test_segment);
+	vector<index_t> intersecting_faces = faces.all_hits(test_segment);
 	if (intersecting_faces.size() > 0) {
 	  auto m_e = max_element(begin(intersecting_faces), end(intersecting_faces),
-				 [part, normal](const index_t l, const index_t r) {
+				 [&part, normal](const index_t l, const index_t r) {
 				   point cl = part.face_triangle(l).centroid();
 				   point cr = part.face_triangle(r).centroid();
 				   return signed_distance_along(cl, normal) <
@@ -335,7 +331,7 @@ namespace gca {
 	}
 	
       }
-    }
+    });
 
   }
 
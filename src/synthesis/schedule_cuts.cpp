@@ -1,5 +1,7 @@
 #include <algorithm>
 
+#include "backend/hole_ordering.h"
+#include "geometry/endpoint_hash.h"
 #include "utils/arena_allocator.h"
 #include "synthesis/schedule_cuts.h"
 
@@ -13,14 +15,6 @@ namespace gca {
     return l->get_start().z > r->get_start().z;
   }
 
-  struct elem_test {
-    const vector<cut*>& elems;
-    elem_test(const vector<cut*>& pelems) : elems(pelems) {}
-    bool operator()(const cut* t) {
-      return find(elems.begin(), elems.end(), t) != elems.end();
-    }
-  };
-
   bool are_contiguous(const cut* last, const cut* next) {
     // TODO: Tune this magic number to the actual drag knife value
     double max_orientation_change = 15;
@@ -37,21 +31,6 @@ namespace gca {
     return within_eps(last->get_end(), next->get_start());
   }
 
-  vector<cut*> contiguous_chain(vector<cut*>::const_iterator it,
-				vector<cut*>::const_iterator e) {
-    cut* last_cut = NULL;
-    cut* next_cut = NULL;
-    vector<cut*> cont_chain;
-    for (; it != e; ++it) {
-      next_cut = *it;
-      if (last_cut == NULL || are_contiguous(last_cut, next_cut)) {
-	cont_chain.push_back(next_cut);
-	last_cut = next_cut;
-      }
-    }
-    return cont_chain;
-  }
-
   bool is_hole_punch(const cut* c) {
     return c->is_hole_punch();
   }
@@ -75,16 +54,35 @@ namespace gca {
     stable_sort(groups.begin(), groups.end(), poly_contains);
   }
 
+  // Each group starts at the first cut not yet grouped and grows
+  // with the first later cut that continues it. Cut starts are hashed
+  // so the next cut is found without rescanning the rest of the list
   vector<cut_group*> group_cuts(const vector<cut*>& cuts) {
+    endpoint_hash starts(0.0000001);
+    for (unsigned i = 0; i < cuts.size(); i++) {
+      starts.insert(cuts[i]->get_start(), i);
+    }
+
+    vector<bool> grouped(cuts.size(), false);
     vector<cut_group*> groups;
-    vector<cut*> cts = cuts;
-    while (cts.size() > 0) {
-      cut_group next_chain = contiguous_chain(cts.begin(), cts.end());
+    for (unsigned i = 0; i < cuts.size(); i++) {
+      if (grouped[i]) { continue; }
       groups.push_back(new (allocate<cut_group>()) cut_group());
-      groups.back()->insert(groups.back()->end(),
-			    next_chain.begin(),
-			    next_chain.end());
-      cts.erase(remove_if(cts.begin(), cts.end(), elem_test(next_chain)), cts.end());
+
+      unsigned last = i;
+      while (last < cuts.size()) {
+	grouped[last] = true;
+	groups.back()->push_back(cuts[last]);
+
+	unsigned next = cuts.size();
+	starts.for_each_near(cuts[last]->get_end(), [&](const unsigned j) {
+	    if (j > last && j < next && !grouped[j] &&
+		are_contiguous(cuts[last], cuts[j])) {
+	      next = j;
+	    }
+	  });
+	last = next;
+      }
     }
     return groups;
   }
@@ -98,12 +96,44 @@ namespace gca {
     return cuts;
   }
 
+  // Orders the hole punches at the front of cuts to shorten the
+  // rapids between them, holes for each tool stay together
+  void schedule_hole_punches(vector<cut*>& cuts) {
+    auto holes_end = find_if_not(cuts.begin(), cuts.end(), is_hole_punch);
+
+    vector<tool_name> tools;
+    for (auto it = cuts.begin(); it != holes_end; ++it) {
+      if (find(tools.begin(), tools.end(), (*it)->tool_no) == tools.end()) {
+	tools.push_back((*it)->tool_no);
+      }
+    }
+
+    vector<cut*> ordered;
+    for (auto t : tools) {
+      vector<cut*> holes;
+      vector<point> centers;
+      for (auto it = cuts.begin(); it != holes_end; ++it) {
+	if ((*it)->tool_no == t) {
+	  holes.push_back(*it);
+	  centers.push_back((*it)->get_start());
+	}
+      }
+
+      for (auto i : hole_visit_order(centers)) {
+	ordered.push_back(holes[i]);
+      }
+    }
+
+    copy(ordered.begin(), ordered.end(), cuts.begin());
+  }
+
   vector<cut*> schedule_cuts(const vector<cut*>& cuts) {
     for_each(cuts.begin(), cuts.end(), has_tool);
     vector<cut_group*> groups = group_cuts(cuts);
     schedule_cut_groups(groups);
     vector<cut*> scheduled_cuts = concat_cut_groups(groups);
     stable_partition(scheduled_cuts.begin(), scheduled_cuts.end(), is_hole_punch);
+    schedule_hole_punches(scheduled_cuts);
     assert(scheduled_cuts.size() == cuts.size());
     return scheduled_cuts;
   }
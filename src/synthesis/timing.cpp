@@ -1,3 +1,5 @@
+#include <unordered_set>
+
 #include "synthesis/timing.h"
 
 namespace gca {
@@ -33,6 +35,43 @@ namespace gca {
     return step_time;
   }
 
+  fab_plan_timing_info make_timing_info(const toolpath& tp,
+					const machine_profile& m) {
+    cut_params params;
+    params.safe_height = tp.safe_z_before_tlc;
+    params.set_plunge_feed(tp.plunge_feedrate);
+
+    std::unordered_set<const cut*> toolpath_cuts;
+    for (auto& cuts : tp.cuts_without_safe_moves()) {
+      toolpath_cuts.insert(begin(cuts), end(cuts));
+    }
+
+    vector<cut*> path = tp.contiguous_cuts(params);
+    vector<double> times = cut_times_seconds(path, m);
+
+    double exec_time = 0.0;
+    double air_time = 0.0;
+    for (unsigned i = 0; i < path.size(); i++) {
+      exec_time += times[i];
+      if (toolpath_cuts.count(path[i]) == 0) {
+	air_time += times[i];
+      }
+    }
+
+    return fab_plan_timing_info(exec_time, air_time);
+  }
+
+  fab_plan_timing_info make_timing_info(const fabrication_setup& step,
+					const machine_profile& m) {
+    fab_plan_timing_info step_time;
+
+    for (auto& tp : step.toolpaths()) {
+      increment(step_time, make_timing_info(tp, m));
+    }
+
+    return step_time;
+  }
+
   void print_time_info(std::ostream& out,
 		       const fab_plan_timing_info& times) {
     out << "Total execution time so far = " << times.toolpath_time_seconds << " seconds" << endl;
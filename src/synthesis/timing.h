@@ -1,5 +1,6 @@
 #pragma once
 
+#include "analysis/cycle_time.h"
 #include "synthesis/fabrication_plan.h"
 #include "backend/toolpath.h"
 
@@ -25,6 +26,14 @@ namespace gca {
   fab_plan_timing_info make_timing_info(const fabrication_setup& step,
 					const double rapid_feed);
 
+  // Times from the motion planner of m, run over the toolpath with
+  // its transitions. Air time is the time spent in the transitions
+  fab_plan_timing_info make_timing_info(const toolpath& tp,
+					const machine_profile& m);
+
+  fab_plan_timing_info make_timing_info(const fabrication_setup& step,
+					const machine_profile& m);
+
   void print_time_info(std::ostream& out,
 		       const fab_plan_timing_info& times);
   
@@ -48,11 +48,15 @@ namespace gca {
 
   vector<vector<cut*>> clip_transition_heights(vector<vector<cut*>>& paths,
 					       double new_safe_height) {
-    vector<vector<cut*>> clipped_paths;
-    for (auto path : paths) {
-      clipped_paths.push_back(clip_transition_heights(path, new_safe_height));
-    }
-    return clipped_paths;
+    transform_pipeline clip;
+    clip.then(clip_transition_heights(new_safe_height));
+    return clip.apply(paths);
+  }
+
+  path_stage clip_transition_heights(double new_safe_height) {
+    return [new_safe_height](const vector<cut*>& path) {
+      return clip_transition_heights(path, new_safe_height);
+    };
   }
 
 
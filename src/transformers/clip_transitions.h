@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gcode/cut.h"
+#include "transformers/transform_pipeline.h"
 
 namespace gca {
 
@@ -11,4 +12,6 @@ namespace gca {
   clip_transition_heights(std::vector<std::vector<cut*>>& paths,
 			  double new_safe_height);
 
+  path_stage clip_transition_heights(double new_safe_height);
+
 }
@@ -18,4 +18,13 @@ namespace gca {
     return np;
   }
 
+  cut_stage change_feeds(value* initial_feedrate, value* new_feedrate) {
+    return [initial_feedrate, new_feedrate](const vector<cut*>&) -> cut_transform {
+      return [initial_feedrate, new_feedrate](cut* c) {
+	if (*(c->get_feedrate()) == *initial_feedrate)
+	  { c->set_feedrate(new_feedrate); }
+      };
+    };
+  }
+
 }
@@ -2,10 +2,14 @@
 #define GCA_FEED_CHANGER_H
 
 #include "gcode/lexer.h"
+#include "transformers/transform_pipeline.h"
 
 namespace gca {
 
   vector<block> change_feeds(const vector<block>& p, value*
-			     initial_feedrate, value* new_feedrate);  
+			     initial_feedrate, value* new_feedrate);
+
+  // The same change on cuts, for a transform_pipeline
+  cut_stage change_feeds(value* initial_feedrate, value* new_feedrate);
 }
 #endif
@@ -45,41 +45,39 @@ namespace gca {
     return current;
   }
 
-  vector<cut*> retarget_toolpath(const vector<cut*>& path,
-				 tool_table& old_tools,
-				 tool_table& new_tools) {
-    sanity_check_toolpath(path);
-    auto old_tool = old_tools[get_active_tool_no(path)];
-    auto t = select_new_tool(path, old_tools, new_tools);
-    auto height_comp_setting = path.front()->settings.tool_height_comp;
-    vector<cut*> cuts;
-    for (auto c : path) {
-      auto r = c->copy();
-      r->settings.active_tool = ilit::make(t);
-      if (height_comp_setting == TOOL_HEIGHT_COMP_NEGATIVE) {
-	r = r->shift(point(0, 0, old_tool.length));
-	r->settings.tool_height_comp = TOOL_HEIGHT_COMP_OFF;
-      } else if (height_comp_setting == TOOL_HEIGHT_COMP_POSITIVE) {
+  cut_stage retarget_stage(const tool_table& old_tools,
+			   const tool_table& new_tools) {
+    return [&old_tools, &new_tools](const vector<cut*>& path) -> cut_transform {
+      sanity_check_toolpath(path);
+      auto old_tool = old_tools.find(get_active_tool_no(path));
+      DBG_ASSERT(old_tool != end(old_tools));
+      double old_length = old_tool->second.length;
+
+      value* new_tool = ilit::make(select_new_tool(path, old_tools, new_tools));
+      auto height_comp_setting = path.front()->settings.tool_height_comp;
+      if (height_comp_setting == TOOL_HEIGHT_COMP_POSITIVE) {
 	cout << "ERROR: Positive tool height compensation is not supported" << endl;
 	DBG_ASSERT(false);
       }
-      if (r->settings.active_tool->is_omitted()) {
-	cout << "ERROR IN RETARGET TOOLPATH" << endl;
-	cout << *c << endl;
-	cout << *r << endl;
-	DBG_ASSERT(false);
-      }
-      if (r->settings.spindle_speed->is_omitted()) {
-	cout << "ERROR IN RETARGET TOOLPATH" << endl;
-	cout << *c << endl;
-	cout << *r << endl;
-	DBG_ASSERT(false);
-      }
 
-      cuts.push_back(r);
-    }
-    sanity_check_toolpath(cuts);
-    return cuts;
+      // The checks above cover the whole path, so every cut leaves
+      // with the same tool, spindle speed and height compensation
+      return [new_tool, height_comp_setting, old_length](cut* c) {
+	c->settings.active_tool = new_tool;
+	if (height_comp_setting == TOOL_HEIGHT_COMP_NEGATIVE) {
+	  c->translate(point(0, 0, old_length));
+	  c->settings.tool_height_comp = TOOL_HEIGHT_COMP_OFF;
+	}
+      };
+    };
+  }
+
+  vector<cut*> retarget_toolpath(const vector<cut*>& path,
+				 tool_table& old_tools,
+				 tool_table& new_tools) {
+    transform_pipeline retarget;
+    retarget.then(retarget_stage(old_tools, new_tools));
+    return retarget.apply({path}).front();
   }
 
   vector<block> generate_gcode(const vector<cut*>& path) {
@@ -92,11 +90,9 @@ namespace gca {
   vector<vector<cut*>> haas_to_minimill(const vector<vector<cut*>> & p,
 					tool_table& old_tools,
 					tool_table& new_tools) {
-    vector<vector<cut*>> res_paths;
-    for (auto path : p) {
-      res_paths.push_back(retarget_toolpath(path, old_tools, new_tools));
-    }
-    return res_paths;
+    transform_pipeline retarget;
+    retarget.then(retarget_stage(old_tools, new_tools));
+    return retarget.apply(p);
   }
 
 
@@ -7,6 +7,7 @@
 #include "gcode/lexer.h"
 #include "gcode/cut.h"
 #include "backend/shapes_to_gcode.h"
+#include "transformers/transform_pipeline.h"
 
 namespace gca {
 
@@ -21,7 +22,15 @@ namespace gca {
 
   typedef map<int, tool_info> tool_table;
   
-  vector<cut*> retarget_toolpath(const vector<cut*>& path);
+  // Moves each path onto its tool in new_tools and takes out negative
+  // tool height compensation. The tables are only read, and must
+  // outlive the stage
+  cut_stage retarget_stage(const tool_table& old_tools,
+			   const tool_table& new_tools);
+
+  vector<cut*> retarget_toolpath(const vector<cut*>& path,
+				 tool_table& old_tools,
+				 tool_table& new_tools);
   vector<block> generate_gcode(const vector<cut*>& paths);
   
   vector<vector<cut*>> haas_to_minimill(const vector<vector<cut*>> & p,
@@ -0,0 +1,58 @@
+#include "transformers/transform_pipeline.h"
+#include "utils/parallel.h"
+
+namespace gca {
+
+  transform_pipeline& transform_pipeline::then(const cut_stage& s) {
+    if (steps.size() == 0 || steps.back().rewrite) {
+      steps.push_back(step());
+    }
+    steps.back().cut_stages.push_back(s);
+    return *this;
+  }
+
+  transform_pipeline& transform_pipeline::then(const path_stage& s) {
+    step st;
+    st.rewrite = s;
+    steps.push_back(st);
+    return *this;
+  }
+
+  void transform_pipeline::run(std::vector<cut*>& path, bool owned) const {
+    for (auto& st : steps) {
+      if (st.rewrite) {
+	path = st.rewrite(path);
+	continue;
+      }
+
+      // Every transform of the run is made from the path as it was
+      // before the run, then they are all applied to each cut in turn
+      std::vector<cut_transform> transforms;
+      for (auto& s : st.cut_stages) {
+	transforms.push_back(s(path));
+      }
+
+      for (auto& c : path) {
+	if (!owned) { c = c->copy(); }
+	for (auto& t : transforms) { t(c); }
+      }
+      owned = true;
+    }
+  }
+
+  std::vector<std::vector<cut*>>
+  transform_pipeline::apply(const std::vector<std::vector<cut*>>& paths) const {
+    return parallel_map_with_arenas(paths, [this](const std::vector<cut*>& p) {
+	std::vector<cut*> path = p;
+	run(path, false);
+	return path;
+      });
+  }
+
+  void transform_pipeline::apply_in_place(std::vector<std::vector<cut*>>& paths) const {
+    parallel_for_with_arenas(paths.size(), [this, &paths](const unsigned i) {
+	run(paths[i], true);
+      });
+  }
+
+}
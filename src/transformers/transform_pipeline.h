@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "gcode/cut.h"
+
+namespace gca {
+
+  // Changes one cut in place
+  typedef std::function<void(cut*)> cut_transform;
+
+  // Makes the cut_transform for one path, so that it can depend on
+  // the whole path. Must be safe to call on different paths at once
+  typedef std::function<cut_transform(const std::vector<cut*>&)> cut_stage;
+
+  // Rewrites a whole path without changing the cuts it is given
+  typedef std::function<std::vector<cut*>(const std::vector<cut*>&)> path_stage;
+
+  // Transforms applied to every path of a program. Runs of cut stages
+  // are fused into a single pass over each path, so every stage of a
+  // run is made from the path as it was before the run. Paths are
+  // transformed in parallel
+  class transform_pipeline {
+  protected:
+
+    // Either a run of cut stages or one path stage
+    struct step {
+      std::vector<cut_stage> cut_stages;
+      path_stage rewrite;
+    };
+
+    std::vector<step> steps;
+
+    void run(std::vector<cut*>& path, bool owned) const;
+
+  public:
+    transform_pipeline& then(const cut_stage& s);
+    transform_pipeline& then(const path_stage& s);
+
+    // Each cut is copied once, before the first cut stage that
+    // changes it, and paths is left as it was
+    std::vector<std::vector<cut*>>
+    apply(const std::vector<std::vector<cut*>>& paths) const;
+
+    // For paths whose cuts nothing else refers to, cut stages change
+    // them without copying
+    void apply_in_place(std::vector<std::vector<cut*>>& paths) const;
+  };
+
+}
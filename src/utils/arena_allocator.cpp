@@ -1,17 +1,88 @@
+#include <algorithm>
 #include <cstdlib>
 #include "utils/arena_allocator.h"
 
 namespace gca {
   arena_allocator* system_allocator = NULL;
+  thread_local arena_allocator* thread_allocator = NULL;
+  thread_local size_t thread_bytes_allocated = 0;
+
+  static const size_t thread_arena_block_size = 1 << 20;
+
+  void* arena_allocator::alloc_block(const size_t s) {
+    std::lock_guard<std::mutex> lock(block_mutex);
+    return alloc(s);
+  }
+
+  // Top level arenas that fill up double their chunk size up to this,
+  // so ones that start small grow in a few mallocs
+  static const size_t max_growth_chunk_size = 1 << 26;
+
+  void arena_allocator::next_block(const size_t s) {
+    if (parent == NULL) {
+      full_chunks.push_back(start);
+      size = std::max(size, std::min(2*size, max_growth_chunk_size));
+      size = std::max(s, size);
+      start = static_cast<char*>(malloc(size));
+      current = start;
+      space_left = size;
+      return;
+    }
+
+    size = std::max(s, thread_arena_block_size);
+    start = static_cast<char*>(parent->alloc_block(size));
+    current = start;
+    space_left = size;
+  }
+
+  arena_allocator* arena_allocator::thread_arena() {
+    if (parent != NULL) { return parent->thread_arena(); }
+
+    std::lock_guard<std::mutex> lock(block_mutex);
+    if (idle_arenas.size() > 0) {
+      arena_allocator* a = idle_arenas.back();
+      idle_arenas.pop_back();
+      return a;
+    }
+
+    arena_allocator* a = new arena_allocator(this);
+    thread_arenas.push_back(a);
+    return a;
+  }
+
+  void arena_allocator::release_thread_arena(arena_allocator* a) {
+    if (parent != NULL) { return parent->release_thread_arena(a); }
+
+    std::lock_guard<std::mutex> lock(block_mutex);
+    idle_arenas.push_back(a);
+  }
 
   void set_system_allocator(arena_allocator* a) {
     system_allocator = a;
   }
 
+  void set_thread_allocator(arena_allocator* a) {
+    thread_allocator = a;
+  }
+
+  arena_allocator* get_thread_allocator() {
+    return thread_allocator;
+  }
+
+  arena_allocator* current_allocator() {
+    return thread_allocator != NULL ? thread_allocator : system_allocator;
+  }
+
   void* alloc(size_t s) {
-    DBG_ASSERT(system_allocator != NULL);
-    void* to_alloc = system_allocator->alloc(s);
+    arena_allocator* a = current_allocator();
+    DBG_ASSERT(a != NULL);
+    void* to_alloc = a->alloc(s);
+    thread_bytes_allocated += s;
     return to_alloc;
   }
+
+  size_t bytes_allocated_on_thread() {
+    return thread_bytes_allocated;
+  }
   
 }
@@ -2,6 +2,7 @@
 #define GCA_ARENA_ALLOCATOR_H
 
 #include <cstdlib>
+#include <mutex>
 #include <vector>
 
 #include "utils/check.h"
@@ -18,22 +19,55 @@ namespace gca {
     char* current;
     size_t size;
     size_t space_left;
+
+    // Thread arenas take their memory in blocks from the arena that
+    // made them, so it lives until that arena is destroyed
+    arena_allocator* parent;
+    std::mutex block_mutex;
+
+    // Chunks a top level arena filled before the current one, freed
+    // along with it
+    std::vector<char*> full_chunks;
+    std::vector<arena_allocator*> thread_arenas;
+
+    // Thread arenas whose workers are done, handed out again before
+    // any new one is made so the number of partly used blocks stays
+    // at the number of workers that ever ran at once
+    std::vector<arena_allocator*> idle_arenas;
+
+    arena_allocator(arena_allocator* p_parent)
+      : start(NULL), current(NULL), size(0), space_left(0), parent(p_parent) {}
+
+    void* alloc_block(const size_t s);
+    void next_block(const size_t s);
     
   public:
-    arena_allocator() {
-      size = DEFAULT_ARENA_SIZE;
+    arena_allocator() : arena_allocator(DEFAULT_ARENA_SIZE) {}
+
+    // Short lived arenas that are freed as a whole, like the one for
+    // each batch of a stream, can be much smaller than the default.
+    // One that runs out takes another chunk, twice the size of the
+    // last one up to 64MB, freed with the arena
+    explicit arena_allocator(const size_t arena_size) {
+      size = arena_size;
       space_left = size;
       start = static_cast<char*>(malloc(size));
       current = start;
+      parent = NULL;
     }
 
     ~arena_allocator() {
-      delete start;
+      for (auto a : thread_arenas) { delete a; }
+      if (parent == NULL) {
+	for (auto c : full_chunks) { free(c); }
+	free(start);
+      }
     }
 
     void* alloc(size_t s) {
+      if (s > space_left) { next_block(s); }
+      DBG_ASSERT(s <= space_left);
       space_left = space_left - s;
-      DBG_ASSERT(space_left > 0);
       void* to_alloc = current;
       current += s;
       return to_alloc;
@@ -41,23 +75,72 @@ namespace gca {
 
     template<typename T>
     T* allocate() {
-      size_t s = sizeof(T);
-      space_left = space_left - s;
-      DBG_ASSERT(space_left > 0);
-      void* to_alloc = current;
-      current += s;
-      return static_cast<T*>(to_alloc);
+      return static_cast<T*>(alloc(sizeof(T)));
     }
 
+    // An arena for one worker thread. Only its blocks are taken from
+    // the top level arena under a lock, so threads with their own
+    // arenas allocate without contention
+    arena_allocator* thread_arena();
+
+    // Gives back an arena from thread_arena once its worker is done.
+    // What was allocated in it stays valid, the next worker to get it
+    // carries on from the end of its current block
+    void release_thread_arena(arena_allocator* a);
+
   };
 
   void set_system_allocator(arena_allocator* a);
+
+  // Allocations on the calling thread go to a instead of the system
+  // allocator until it is reset to NULL
+  void set_thread_allocator(arena_allocator* a);
+  arena_allocator* get_thread_allocator();
+
+  // The arena allocations on the calling thread go to
+  arena_allocator* current_allocator();
+
   void* alloc(size_t s);
+
+  // Bytes the calling thread has taken from arenas through alloc
+  size_t bytes_allocated_on_thread();
   
   template<typename T> T* allocate() {
     void* to_alloc = alloc(sizeof(T));
     return static_cast<T*>(to_alloc);
   }
+
+  class thread_arena_scope {
+  protected:
+    arena_allocator* previous;
+
+  public:
+    thread_arena_scope(arena_allocator* a) : previous(get_thread_allocator()) {
+      set_thread_allocator(a);
+    }
+
+    ~thread_arena_scope() { set_thread_allocator(previous); }
+  };
+
+  // Allocations on the calling thread go to a thread arena of parent
+  // for the life of the scope, e.g. for the whole chunk of a worker
+  class worker_arena_scope {
+  protected:
+    arena_allocator* parent;
+    arena_allocator* arena;
+    arena_allocator* previous;
+
+  public:
+    explicit worker_arena_scope(arena_allocator* p)
+      : parent(p), arena(p->thread_arena()), previous(get_thread_allocator()) {
+      set_thread_allocator(arena);
+    }
+
+    ~worker_arena_scope() {
+      set_thread_allocator(previous);
+      parent->release_thread_arena(arena);
+    }
+  };
     
 }
 
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "utils/arena_allocator.h"
+#include "utils/check.h"
+#include "utils/instrumentation.h"
+
+namespace gca {
+
+  struct phase_node {
+    std::string name;
+    phase_node* parent;
+    std::vector<std::unique_ptr<phase_node>> children;
+
+    long calls;
+    double total_ns;
+    size_t bytes;
+    std::map<std::string, long> counters;
+
+    phase_node(const std::string& p_name, phase_node* p_parent)
+      : name(p_name), parent(p_parent), calls(0), total_ns(0.0), bytes(0) {}
+
+    double self_ns() const {
+      double child_ns = 0.0;
+      for (auto& c : children) { child_ns += c->total_ns; }
+      return std::max(0.0, total_ns - child_ns);
+    }
+  };
+
+  bool instrumentation_on = false;
+
+  // Phases are coarse, so one lock for the whole tree costs far less
+  // than the work being timed
+  static std::mutex tree_mutex;
+  static phase_node root("all", NULL);
+  static std::string out_file;
+  static std::chrono::high_resolution_clock::time_point run_start;
+
+  static thread_local phase_node* thread_phase = NULL;
+
+  static phase_node* child_named(phase_node* parent, const char* name) {
+    for (auto& c : parent->children) {
+      if (c->name == name) { return c.get(); }
+    }
+    parent->children.push_back(std::unique_ptr<phase_node>(new phase_node(name, parent)));
+    return parent->children.back().get();
+  }
+
+  static void write_at_exit() { write_instrumentation(); }
+  static bool exit_write_registered = false;
+
+  void enable_instrumentation(const std::string& out_path) {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    if (!exit_write_registered) {
+      std::atexit(write_at_exit);
+      exit_write_registered = true;
+    }
+    out_file = out_path;
+    run_start = std::chrono::high_resolution_clock::now();
+    instrumentation_on = true;
+  }
+
+  void disable_instrumentation() {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    DBG_ASSERT(thread_phase == NULL);
+
+    instrumentation_on = false;
+    out_file = "";
+    root.children.clear();
+    root.counters.clear();
+    root.calls = 0;
+    root.total_ns = 0.0;
+    root.bytes = 0;
+  }
+
+  static bool enable_from_environment() {
+    const char* path = std::getenv("GCA_TRACE");
+    if (path != NULL && std::string(path) != "") {
+      enable_instrumentation(path);
+    }
+    return true;
+  }
+
+  static bool environment_read = enable_from_environment();
+
+  phase_node* current_phase() {
+    return thread_phase;
+  }
+
+  phase_timer::phase_timer(const char* name) : node(NULL), parent(NULL) {
+    if (!instrumentation_enabled()) { return; }
+
+    parent = thread_phase == NULL ? &root : thread_phase;
+    {
+      std::lock_guard<std::mutex> lock(tree_mutex);
+      node = child_named(parent, name);
+    }
+    thread_phase = node;
+    start_bytes = bytes_allocated_on_thread();
+    start = std::chrono::high_resolution_clock::now();
+  }
+
+  phase_timer::~phase_timer() {
+    if (node == NULL) { return; }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    size_t bytes = bytes_allocated_on_thread() - start_bytes;
+
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    node->calls++;
+    node->total_ns += ns;
+    node->bytes += bytes;
+    thread_phase = parent == &root ? NULL : parent;
+  }
+
+  phase_parent_scope::phase_parent_scope(phase_node* p) : previous(thread_phase) {
+    thread_phase = p;
+  }
+
+  phase_parent_scope::~phase_parent_scope() { thread_phase = previous; }
+
+  void count_event(const char* name, const long n) {
+    if (!instrumentation_enabled()) { return; }
+
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    phase_node* p = thread_phase == NULL ? &root : thread_phase;
+    p->counters[name] += n;
+  }
+
+  static void add_counters(const phase_node& n, std::map<std::string, long>& totals) {
+    for (auto& c : n.counters) { totals[c.first] += c.second; }
+    for (auto& c : n.children) { add_counters(*c, totals); }
+  }
+
+  static std::string json_string(const std::string& s) {
+    std::string escaped = "\"";
+    for (char c : s) {
+      if (c == '"' || c == '\\') { escaped += '\\'; }
+      escaped += c;
+    }
+    return escaped + "\"";
+  }
+
+  static void write_counters_json(const std::map<std::string, long>& counters,
+				  std::ostream& out) {
+    out << "{";
+    bool first = true;
+    for (auto& c : counters) {
+      out << (first ? "" : ", ") << json_string(c.first) << ": " << c.second;
+      first = false;
+    }
+    out << "}";
+  }
+
+  static void write_phase_json(const phase_node& n,
+			       const std::string& indent,
+			       std::ostream& out) {
+    out << indent << "{\"name\": " << json_string(n.name)
+	<< ", \"calls\": " << n.calls
+	<< ", \"total_ms\": " << n.total_ns / 1e6
+	<< ", \"self_ms\": " << n.self_ns() / 1e6
+	<< ", \"arena_bytes\": " << n.bytes
+	<< ", \"counters\": ";
+    write_counters_json(n.counters, out);
+    out << ", \"children\": [";
+    for (unsigned i = 0; i < n.children.size(); i++) {
+      out << (i == 0 ? "\n" : ",\n");
+      write_phase_json(*n.children[i], indent + "  ", out);
+    }
+    out << "]}";
+  }
+
+  static void write_folded(const phase_node& n,
+			   const std::string& stack,
+			   std::ostream& out) {
+    std::string frame = stack == "" ? n.name : stack + ";" + n.name;
+    long self_us = static_cast<long>(n.self_ns() / 1e3);
+    if (self_us > 0) { out << frame << " " << self_us << std::endl; }
+    for (auto& c : n.children) { write_folded(*c, frame, out); }
+  }
+
+  static bool ends_with_json(const std::string& path) {
+    std::string ext = ".json";
+    return path.size() >= ext.size() &&
+      path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+  }
+
+  void write_instrumentation() {
+    if (!instrumentation_enabled()) { return; }
+
+    std::lock_guard<std::mutex> lock(tree_mutex);
+
+    // The root is open for the whole run, its self time is the time
+    // spent outside any phase
+    auto now = std::chrono::high_resolution_clock::now();
+    root.total_ns = std::chrono::duration<double, std::nano>(now - run_start).count();
+    root.calls = 1;
+
+    std::ofstream out(out_file);
+    if (ends_with_json(out_file)) {
+      std::map<std::string, long> totals;
+      add_counters(root, totals);
+
+      out << "{\"counters\": ";
+      write_counters_json(totals, out);
+      out << ",\n\"phases\":\n";
+      write_phase_json(root, "", out);
+      out << "}" << std::endl;
+    } else {
+      write_folded(root, "", out);
+    }
+  }
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace gca {
+
+  // Phase timers and event counters for finding where planning time
+  // goes. They cost one branch while off, and are turned on for a run
+  // by setting GCA_TRACE to an output file, written at exit. Files
+  // ending in .json get a JSON tree of phases with their calls, times,
+  // arena bytes and counters; any other name gets folded stacks of
+  // self time in microseconds for flamegraph.pl.
+  //
+  // Phases opened by the workers of parallel_for and parallel_map
+  // nest under the phase that started them, so a parent's children
+  // can add up to more than its wall time.
+
+  struct phase_node;
+
+  extern bool instrumentation_on;
+
+  inline bool instrumentation_enabled() { return instrumentation_on; }
+
+  // Starts recording, for runs that pick the output file themselves
+  void enable_instrumentation(const std::string& out_path);
+
+  // Stops recording and drops everything recorded so far. Must not be
+  // called while any phase is open
+  void disable_instrumentation();
+
+  // Writes everything recorded so far to the output file
+  void write_instrumentation();
+
+  // Times the enclosing scope as a child of the innermost phase open
+  // on this thread
+  class phase_timer {
+  protected:
+    phase_node* node;
+    phase_node* parent;
+    std::chrono::high_resolution_clock::time_point start;
+    size_t start_bytes;
+
+  public:
+    explicit phase_timer(const char* name);
+    ~phase_timer();
+
+    phase_timer(const phase_timer&) = delete;
+    phase_timer& operator=(const phase_timer&) = delete;
+  };
+
+  phase_node* current_phase();
+
+  // Opens phases on this thread under p, for worker threads
+  class phase_parent_scope {
+  protected:
+    phase_node* previous;
+
+  public:
+    explicit phase_parent_scope(phase_node* p);
+    ~phase_parent_scope();
+  };
+
+  // Adds n to the named counter of the innermost open phase
+  void count_event(const char* name, const long n = 1);
+
+}
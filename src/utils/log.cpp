@@ -0,0 +1,174 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "utils/log.h"
+
+namespace gca {
+
+  int log_levels[NUM_LOG_SUBSYSTEMS] = {
+    LEVEL_WARNING, LEVEL_WARNING, LEVEL_WARNING,
+    LEVEL_WARNING, LEVEL_WARNING, LEVEL_WARNING
+  };
+
+  static const char* level_names[] = {"error", "warning", "info", "debug", "trace"};
+
+  static const char* subsystem_names[] = {
+    "geometry", "gcode", "simulation", "planning", "backend", "synthesis"
+  };
+
+  // The writer thread wakes up when this much is buffered, or at the
+  // latest after write_interval
+  static const size_t buffer_limit = 1 << 16;
+  static const std::chrono::milliseconds write_interval(100);
+
+  static std::mutex buffer_mutex;
+  static std::condition_variable buffer_ready;
+  static std::string buffer;
+  static std::thread writer;
+  static bool stopping = false;
+
+  // Held while a buffer is taken and written, so that messages come
+  // out in order whichever thread writes them
+  static std::mutex output_mutex;
+  static std::ofstream log_file;
+
+  static void write_buffered() {
+    std::lock_guard<std::mutex> output_lock(output_mutex);
+    std::string pending;
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex);
+      pending.swap(buffer);
+    }
+
+    if (pending.size() == 0) { return; }
+
+    std::ostream& out = log_file.is_open() ? log_file : std::cerr;
+    out.write(pending.data(), pending.size());
+    out.flush();
+  }
+
+  static void write_loop() {
+    std::unique_lock<std::mutex> lock(buffer_mutex);
+    while (!stopping) {
+      buffer_ready.wait_for(lock, write_interval);
+      lock.unlock();
+      write_buffered();
+      lock.lock();
+    }
+  }
+
+  static void stop_writer() {
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex);
+      stopping = true;
+    }
+    buffer_ready.notify_one();
+    writer.join();
+    write_buffered();
+  }
+
+  void flush_log() { write_buffered(); }
+
+  void log_message(const log_level level,
+		   const log_subsystem s,
+		   const std::string& message) {
+    bool full, stopped;
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex);
+      if (!writer.joinable() && !stopping) {
+	writer = std::thread(write_loop);
+	std::atexit(stop_writer);
+      }
+
+      buffer += "[";
+      buffer += level_names[level];
+      buffer += " ";
+      buffer += subsystem_names[s];
+      buffer += "] ";
+      buffer += message;
+      buffer += "\n";
+      full = buffer.size() >= buffer_limit;
+      stopped = stopping;
+    }
+
+    // Errors are written before returning in case the program is
+    // about to stop
+    if (level == LEVEL_ERROR || stopped) {
+      write_buffered();
+    } else if (full) {
+      buffer_ready.notify_one();
+    }
+  }
+
+  void set_log_level(const log_level level) {
+    for (int i = 0; i < NUM_LOG_SUBSYSTEMS; i++) { log_levels[i] = level; }
+  }
+
+  void set_log_level(const log_subsystem s, const log_level level) {
+    log_levels[s] = level;
+  }
+
+  void set_log_file(const std::string& path) {
+    flush_log();
+
+    std::lock_guard<std::mutex> output_lock(output_mutex);
+    if (log_file.is_open()) { log_file.close(); }
+    if (path != "") { log_file.open(path); }
+  }
+
+  static int name_index(const std::string& name,
+			const char* const names[],
+			const int num_names) {
+    for (int i = 0; i < num_names; i++) {
+      if (name == names[i]) { return i; }
+    }
+    return -1;
+  }
+
+  // Reads settings like "warning,geometry=debug", unknown names are
+  // reported and skipped
+  static void set_levels_from_string(const std::string& settings) {
+    std::stringstream ss(settings);
+    std::string setting;
+    while (std::getline(ss, setting, ',')) {
+      size_t eq = setting.find('=');
+      std::string level_name = eq == std::string::npos ? setting : setting.substr(eq + 1);
+      int level = name_index(level_name, level_names, LEVEL_TRACE + 1);
+
+      if (level < 0) {
+	std::cerr << "Unknown log level " << level_name << std::endl;
+	continue;
+      }
+
+      if (eq == std::string::npos) {
+	set_log_level(static_cast<log_level>(level));
+	continue;
+      }
+
+      int s = name_index(setting.substr(0, eq), subsystem_names, NUM_LOG_SUBSYSTEMS);
+      if (s < 0) {
+	std::cerr << "Unknown log subsystem " << setting.substr(0, eq) << std::endl;
+	continue;
+      }
+      set_log_level(static_cast<log_subsystem>(s), static_cast<log_level>(level));
+    }
+  }
+
+  static bool read_environment() {
+    const char* levels = std::getenv("GCA_LOG_LEVEL");
+    if (levels != NULL) { set_levels_from_string(levels); }
+
+    const char* path = std::getenv("GCA_LOG_FILE");
+    if (path != NULL && std::string(path) != "") { set_log_file(path); }
+
+    return true;
+  }
+
+  static bool environment_read = read_environment();
+
+}
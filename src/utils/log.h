@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+namespace gca {
+
+  // Leveled diagnostics for the planners and simulators. Messages go
+  // to a buffer that a background thread writes out, so logging never
+  // flushes on the calling thread except for errors.
+  //
+  // GCA_LOG_LEVEL sets the levels at runtime, either one level for every
+  // subsystem ("debug") or per subsystem ("warning,geometry=debug").
+  // The default is warning. GCA_LOG_FILE names a file to log to
+  // instead of stderr. Levels above GCA_LOG_MAX_LEVEL are compiled
+  // out, by default that is info when NDEBUG is defined.
+
+  enum log_level {
+    LEVEL_ERROR = 0,
+    LEVEL_WARNING = 1,
+    LEVEL_INFO = 2,
+    LEVEL_DEBUG = 3,
+    LEVEL_TRACE = 4
+  };
+
+  enum log_subsystem {
+    GEOMETRY_LOG,
+    GCODE_LOG,
+    SIMULATION_LOG,
+    PLANNING_LOG,
+    BACKEND_LOG,
+    SYNTHESIS_LOG,
+    NUM_LOG_SUBSYSTEMS
+  };
+
+  extern int log_levels[NUM_LOG_SUBSYSTEMS];
+
+  inline bool log_enabled(const log_level level, const log_subsystem s) {
+    return level <= log_levels[s];
+  }
+
+  void set_log_level(const log_level level);
+  void set_log_level(const log_subsystem s, const log_level level);
+
+  // Sends messages to path from now on, after writing out the ones
+  // already buffered. An empty path goes back to stderr
+  void set_log_file(const std::string& path);
+
+  void log_message(const log_level level,
+		   const log_subsystem s,
+		   const std::string& message);
+
+  // Blocks until every buffered message has been written
+  void flush_log();
+
+}
+
+#ifndef GCA_LOG_MAX_LEVEL
+#ifdef NDEBUG
+#define GCA_LOG_MAX_LEVEL 2
+#else
+#define GCA_LOG_MAX_LEVEL 4
+#endif
+#endif
+
+// The message is only formatted when the level is enabled, so
+// arguments may be expensive to print, e.g.
+//   GCA_LOG_DEBUG(GEOMETRY_LOG, "# of triangles = " << n);
+#define GCA_LOG(level, subsystem, message)				\
+  do {									\
+    if ((level) <= GCA_LOG_MAX_LEVEL &&					\
+	gca::log_enabled((level), (subsystem))) {			\
+      std::ostringstream gca_log_stream;				\
+      gca_log_stream << message;					\
+      gca::log_message((level), (subsystem), gca_log_stream.str());	\
+    }									\
+  } while (0)
+
+#define GCA_LOG_ERROR(subsystem, message) GCA_LOG(gca::LEVEL_ERROR, subsystem, message)
+#define GCA_LOG_WARNING(subsystem, message) GCA_LOG(gca::LEVEL_WARNING, subsystem, message)
+#define GCA_LOG_INFO(subsystem, message) GCA_LOG(gca::LEVEL_INFO, subsystem, message)
+#define GCA_LOG_DEBUG(subsystem, message) GCA_LOG(gca::LEVEL_DEBUG, subsystem, message)
+#define GCA_LOG_TRACE(subsystem, message) GCA_LOG(gca::LEVEL_TRACE, subsystem, message)
@@ -0,0 +1,147 @@
+#ifndef GCA_PARALLEL_H
+#define GCA_PARALLEL_H
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "utils/arena_allocator.h"
+#include "utils/check.h"
+#include "utils/instrumentation.h"
+
+namespace gca {
+
+  inline unsigned num_worker_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+  }
+
+  // Only the outermost parallel_for or parallel_map starts threads.
+  // Calls made from its workers run serially on the worker, so nested
+  // loops never use more than num_worker_threads() threads in all
+  inline bool& on_worker_thread() {
+    static thread_local bool on_worker = false;
+    return on_worker;
+  }
+
+  class worker_thread_scope {
+  public:
+    worker_thread_scope() { on_worker_thread() = true; }
+    ~worker_thread_scope() { on_worker_thread() = false; }
+  };
+
+  inline unsigned num_threads_for(const unsigned n) {
+    if (on_worker_thread()) { return 1; }
+    return std::min(num_worker_threads(), n);
+  }
+
+  // Calls f(i) for every i in [0, n), split into one contiguous
+  // chunk per worker thread. f must be safe to call concurrently
+  // on different indexes. With worker_parent every worker allocates
+  // from one of its thread arenas for its whole chunk
+  template<typename F>
+  void parallel_for(const unsigned n,
+		    F f,
+		    arena_allocator* worker_parent = NULL) {
+    unsigned num_threads = num_threads_for(n);
+
+    if (num_threads <= 1) {
+      for (unsigned i = 0; i < n; i++) { f(i); }
+      return;
+    }
+
+    unsigned chunk_size = (n + num_threads - 1) / num_threads;
+    phase_node* phase = current_phase();
+
+    std::vector<std::future<void>> workers;
+    for (unsigned s = 0; s < n; s += chunk_size) {
+      unsigned e = std::min(s + chunk_size, n);
+      workers.push_back(std::async(std::launch::async, [&f, s, e, phase, worker_parent]() {
+	    worker_thread_scope worker;
+	    phase_parent_scope scope(phase);
+	    std::unique_ptr<worker_arena_scope> arena;
+	    if (worker_parent != NULL) { arena.reset(new worker_arena_scope(worker_parent)); }
+
+	    for (unsigned i = s; i < e; i++) { f(i); }
+	  }));
+    }
+
+    for (auto& w : workers) { w.get(); }
+  }
+
+  // Applies f to every element of elems in parallel, results are
+  // returned in the same order as elems regardless of scheduling.
+  // worker_parent is as for parallel_for
+  template<typename T, typename F>
+  auto parallel_map(const std::vector<T>& elems,
+		    F f,
+		    arena_allocator* worker_parent = NULL)
+    -> std::vector<typename std::decay<decltype(f(elems.front()))>::type> {
+    typedef typename std::decay<decltype(f(elems.front()))>::type R;
+
+    unsigned n = elems.size();
+    unsigned num_threads = num_threads_for(n);
+
+    std::vector<R> results;
+    if (num_threads <= 1) {
+      for (auto& e : elems) { results.push_back(f(e)); }
+      return results;
+    }
+
+    unsigned chunk_size = (n + num_threads - 1) / num_threads;
+    phase_node* phase = current_phase();
+
+    std::vector<std::future<std::vector<R>>> workers;
+    for (unsigned s = 0; s < n; s += chunk_size) {
+      unsigned e = std::min(s + chunk_size, n);
+      workers.push_back(std::async(std::launch::async, [&elems, &f, s, e, phase, worker_parent]() {
+	    worker_thread_scope worker;
+	    phase_parent_scope scope(phase);
+	    std::unique_ptr<worker_arena_scope> arena;
+	    if (worker_parent != NULL) { arena.reset(new worker_arena_scope(worker_parent)); }
+
+	    std::vector<R> chunk_results;
+	    for (unsigned i = s; i < e; i++) {
+	      chunk_results.push_back(f(elems[i]));
+	    }
+	    return chunk_results;
+	  }));
+    }
+
+    for (auto& w : workers) {
+      std::vector<R> chunk_results = w.get();
+      results.insert(end(results),
+		     std::make_move_iterator(begin(chunk_results)),
+		     std::make_move_iterator(end(chunk_results)));
+    }
+
+    return results;
+  }
+
+  // parallel_for where the calls of each worker allocate their cuts
+  // from one arena, taken from the arena of the calling thread. When
+  // there is only one worker f runs in the calling thread's arena
+  template<typename F>
+  void parallel_for_with_arenas(const unsigned n, F f) {
+    arena_allocator* a = current_allocator();
+    DBG_ASSERT(a != NULL);
+
+    parallel_for(n, f, a);
+  }
+
+  // parallel_map with arenas as for parallel_for_with_arenas
+  template<typename T, typename F>
+  auto parallel_map_with_arenas(const std::vector<T>& elems, F f)
+    -> std::vector<typename std::decay<decltype(f(elems.front()))>::type> {
+    arena_allocator* a = current_allocator();
+    DBG_ASSERT(a != NULL);
+
+    return parallel_map(elems, f, a);
+  }
+
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include <cmath>
+
+#include "catch.hpp"
+#include "backend/arc_fitting.h"
+#include "backend/drop_cutter.h"
+#include "backend/freeform_toolpaths.h"
+#include "gcode/circular_arc.h"
+#include "utils/arena_allocator.h"
+
+namespace gca {
+
+  static double max_distance_to_cuts(const std::vector<point>& pts,
+				     const std::vector<cut*>& cuts) {
+    vector<point> samples;
+    for (auto c : cuts) {
+      int n = 10000;
+      for (int k = 0; k <= n; k++) {
+	samples.push_back(c->value_at(static_cast<double>(k) / n));
+      }
+    }
+
+    double worst = 0.0;
+    for (auto p : pts) {
+      double closest = (p - samples.front()).len();
+      for (auto s : samples) {
+	closest = min(closest, (p - s).len());
+      }
+      worst = max(worst, closest);
+    }
+    return worst;
+  }
+
+  TEST_CASE("Arc fitting") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    double tol = 0.0005;
+
+    SECTION("Sampled circle becomes a few arcs") {
+      vector<point> pts;
+      for (int i = 0; i <= 360; i++) {
+	double t = i*M_PI / 180.0;
+	pts.push_back(point(1 + cos(t), 2 - sin(t), 0.5));
+      }
+
+      vector<cut*> cuts = fit_arcs(pts, tol);
+
+      REQUIRE(cuts.size() == 3);
+      for (auto c : cuts) {
+	REQUIRE(c->is_circular_arc());
+	REQUIRE(static_cast<circular_arc*>(c)->dir == CLOCKWISE);
+      }
+      REQUIRE(within_eps(cuts.front()->get_start(), pts.front()));
+      REQUIRE(within_eps(cuts.back()->get_end(), pts.back()));
+      REQUIRE(max_distance_to_cuts(pts, cuts) < tol);
+    }
+
+    SECTION("Points that leave the plane only merge into lines") {
+      vector<point> pts;
+      for (int i = 0; i <= 1000; i++) {
+	double x = 0.002*i;
+	pts.push_back(point(x, 0.3*sin(3*x), 0.1*cos(5*x)));
+      }
+
+      vector<cut*> cuts = fit_arcs(pts, tol);
+
+      REQUIRE(cuts.size() < 100);
+      for (auto c : cuts) {
+	REQUIRE(c->is_linear_cut());
+      }
+      REQUIRE(max_distance_to_cuts(pts, cuts) < tol);
+    }
+
+    SECTION("Toolpath settings carry over to the fitted cuts") {
+      vector<point> pts;
+      for (int i = 0; i <= 20; i++) {
+	pts.push_back(point(0.1*i, 0, 0));
+      }
+      for (int i = 1; i <= 30; i++) {
+	double t = i*M_PI / 60.0;
+	pts.push_back(point(2 + 0.5*sin(t), 0.5 - 0.5*cos(t), 0));
+      }
+
+      tool t{0.25, 3.0, 2, HSS, FLAT_NOSE};
+      t.set_tool_number(2);
+      toolpath tp(FACE_POCKET, 1.0, 3000, 12.0, 4.0, t, {polyline(pts)});
+
+      toolpath fitted = fit_arcs(tp, tol);
+
+      auto cuts = fitted.cuts_without_safe_moves();
+      REQUIRE(cuts.size() == 1);
+      REQUIRE(cuts.front().size() == 2);
+      REQUIRE(cuts.front()[0]->is_linear_cut());
+      REQUIRE(cuts.front()[1]->is_circular_arc());
+
+      cut* original = tp.cuts_without_safe_moves().front().front();
+      for (auto c : cuts.front()) {
+	REQUIRE(same_cut_properties(*c, *original));
+      }
+    }
+
+    SECTION("Reflected arcs run the other way around the reflected center") {
+      circular_arc* c =
+	circular_arc::make(point(1, 0, 0), point(0, 1, 0), point(-1, 0, 0), COUNTERCLOCKWISE, XY);
+      cut* r = c->reflect_x();
+
+      REQUIRE(static_cast<circular_arc*>(r)->dir == CLOCKWISE);
+      REQUIRE(within_eps(r->value_at(0.5), point(-sqrt(0.5), sqrt(0.5), 0), 0.0001));
+    }
+  }
+
+  TEST_CASE("Arcs fitted to adaptively dropped points") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    drop_cutter cutter(box_triangles(box(0, 1, 0, 2, 0, 3)));
+    tool ball(0.5, 3.0, 4, HSS, BALL_NOSE);
+
+    // Across the box and off both sides, where the ball rolls over
+    // the edges
+    vector<point> samples;
+    for (int i = 0; i <= 400; i++) {
+      samples.push_back(point(-0.5 + 0.005*i, 1.0, 0));
+    }
+    vector<point> uniform = cutter.drop(samples, ball, -1.0);
+
+    // Split between the two steps the way freeform toolpaths are
+    double tol = 0.0005;
+    polyline dropped =
+      adaptive_drop_polylines(-1.0, cutter, {polyline(samples)}, ball, 0.125, tol / 2).front();
+    vector<cut*> cuts = fit_arcs(vector<point>(begin(dropped), end(dropped)), tol / 2);
+
+    REQUIRE(cuts.size() < (uniform.size() - 1) / 5);
+    REQUIRE(max_distance_to_cuts(uniform, cuts) <= tol);
+  }
+
+}
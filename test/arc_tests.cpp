@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "geometry/arc.h"
+#include "geometry/parametric_curve.h"
 #include "utils/arena_allocator.h"
 
 namespace gca {
@@ -66,4 +67,26 @@ namespace gca {
     }
 
   }
+
+  TEST_CASE("Parametric curves") {
+    parametric_curve l = line(point(0, 0, 0), point(2, 0, 0));
+    parametric_curve c = arc(point(0, 0, 0), point(1, 0, 0), point(0.5, 0, 0), COUNTERCLOCKWISE);
+
+    SECTION("Copies keep their kind") {
+      parametric_curve copy = c;
+      REQUIRE(copy.kind() == parametric_curve::ARC);
+      REQUIRE(within_eps(copy.value(0.5), c.value(0.5)));
+
+      copy = l;
+      REQUIRE(copy.kind() == parametric_curve::LINE);
+      REQUIRE(within_eps(copy.value(0.5), point(1, 0, 0)));
+    }
+
+    SECTION("Transforms follow the stored curve") {
+      REQUIRE(within_eps(l.shift(point(0, 1, 0)).value(1.0), point(2, 1, 0)));
+      REQUIRE(within_eps(c.shift(point(0, 1, 0)).value(1.0), point(1, 1, 0)));
+      REQUIRE(within_eps(c.reflect_x().value(1.0), point(-1, 0, 0)));
+      REQUIRE(c.reflect_x().get_arc().dir == CLOCKWISE);
+    }
+  }
 }
@@ -69,6 +69,21 @@ namespace gca {
       REQUIRE(equal(correct.begin(), correct.end(), actual.begin(), cmp_cuts));
     }
 
+    SECTION("Holes are ordered to shorten rapids") {
+      cuts.push_back(hole_punch::make(point(3, 0, -0.1), 0.125, DRILL));
+      cuts.push_back(hole_punch::make(point(0, 0, -0.1), 0.125, DRILL));
+      cuts.push_back(hole_punch::make(point(2, 0, -0.1), 0.125, DRILL));
+      cuts.push_back(hole_punch::make(point(1, 0, -0.1), 0.125, DRILL));
+      actual = schedule_cuts(cuts);
+
+      REQUIRE(actual.size() == 4);
+      double travel = 0.0;
+      for (unsigned i = 0; i + 1 < actual.size(); i++) {
+	travel += (actual[i + 1]->get_start() - actual[i]->get_start()).len();
+      }
+      REQUIRE(within_eps(travel, 3.0, 0.0001));
+    }
+
     SECTION("Cuts with different tools are not adjacent") {
       cuts.push_back(linear_cut::make(point(0, 0, -0.1), point(1, 1, -0.1), DRILL));
       cuts.push_back(linear_cut::make(point(0, 0, -0.3), point(1, 1, -0.3), DRILL));
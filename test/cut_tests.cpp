@@ -1,4 +1,5 @@
 #include <cmath>
+#include <sstream>
 
 #include "catch.hpp"
 
@@ -6,6 +7,8 @@
 #include "backend/align_blade.h"
 #include "backend/cut_to_gcode.h"
 #include "backend/output.h"
+#include "gcode/circular_arc.h"
+#include "gcode/hole_punch.h"
 #include "gcode/safe_move.h"
 #include "system/settings.h"
 
@@ -51,6 +54,55 @@ namespace gca {
     }
   }
 
+  static std::string printed_blocks(const vector<block>& blocks) {
+    std::ostringstream printed;
+    printed.setf(ios::fixed, ios::floatfield);
+    printed.setf(ios::showpoint);
+    printed << blocks;
+    return printed.str();
+  }
+
+  static std::string streamed_cuts(const vector<cut*>& cuts,
+				   const cut_params& params,
+				   const bool reflected) {
+    std::ostringstream streamed;
+    gcode_writer w(streamed, 64);
+    write_cuts_gcode(cuts, params, reflected, w);
+    w.flush();
+    return streamed.str();
+  }
+
+  TEST_CASE("Streamed cuts match printed blocks") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    cut_params params;
+    params.target_machine = CAMASTER;
+
+    vector<cut*> cuts{
+      safe_move::make(point(0, 0, 1), point(0, 1, 0), DRILL),
+      circular_arc::make(point(0, 1, 0), point(1, 0, 0), point(0, -1, 0), CLOCKWISE, XY, DRILL),
+      circular_arc::make(point(1, 0, 0), point(-1, 0, 0), point(-1, 0, 0), COUNTERCLOCKWISE, XY, DRILL),
+      hole_punch::make(point(-1, 0, 0), 0.125, DRILL),
+      linear_cut::make(point(-1, 0, 0), point(-0.5, 0.25, -0.1), DRILL)
+    };
+    cuts.back()->set_feedrate(lit::make(12.5));
+
+    SECTION("Arcs and hole punches") {
+      vector<block> blocks;
+      append_cuts_gcode_blocks(cuts, blocks, params);
+
+      REQUIRE(printed_blocks(blocks) == streamed_cuts(cuts, params, false));
+    }
+
+    SECTION("Reflected arcs and hole punches") {
+      vector<block> blocks;
+      append_cuts_gcode_blocks(reflect_x(cuts), blocks, params);
+
+      REQUIRE(printed_blocks(blocks) == streamed_cuts(cuts, params, true));
+    }
+  }
+
   TEST_CASE("Infer material height") {
     arena_allocator a;
     set_system_allocator(&a);
@@ -0,0 +1,82 @@
+#include <cmath>
+
+#include "catch.hpp"
+#include "analysis/cycle_time.h"
+#include "gcode/circular_arc.h"
+#include "gcode/linear_cut.h"
+#include "gcode/safe_move.h"
+#include "utils/arena_allocator.h"
+
+namespace gca {
+
+  static cut* feed_cut(const point s, const point e, const double feed) {
+    cut* c = linear_cut::make(s, e);
+    c->set_feedrate(lit::make(feed));
+    return c;
+  }
+
+  TEST_CASE("Kinematic cycle time") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    machine_profile haas = haas_vf_profile();
+
+    SECTION("A long cut is its length over the feed plus ramp time") {
+      vector<cut*> path{feed_cut(point(0, 0, 0), point(10, 0, 0), 60)};
+
+      vector<double> times = cut_times_seconds(path, haas);
+
+      // One second to cover the distance spent speeding up and
+      // slowing down from 1 inch per second
+      REQUIRE(times.size() == 1);
+      REQUIRE(within_eps(times.front(), 10.0 + 1.0 / haas.max_axis_acceleration.x, 1e-6));
+    }
+
+    SECTION("Corners slow the machine down") {
+      vector<cut*> straight{feed_cut(point(0, 0, 0), point(1, 0, 0), 600),
+	  feed_cut(point(1, 0, 0), point(2, 0, 0), 600)};
+      vector<cut*> corner{feed_cut(point(0, 0, 0), point(1, 0, 0), 600),
+	  feed_cut(point(1, 0, 0), point(1, 1, 0), 600)};
+
+      REQUIRE(execution_time_seconds(corner, haas) >
+	      execution_time_seconds(straight, haas));
+    }
+
+    SECTION("Dense segments are limited by the block rate") {
+      machine_profile emco = emco_f1_profile();
+
+      vector<cut*> path;
+      int n = 200;
+      for (int i = 0; i < n; i++) {
+	path.push_back(feed_cut(point(0.001*i, 0, 0), point(0.001*(i + 1), 0, 0), 20));
+      }
+
+      double t = execution_time_seconds(path, emco);
+
+      REQUIRE(within_eps(t, n / emco.blocks_per_second, 1e-6));
+      REQUIRE(t > 60.0*execution_time_minutes(path));
+    }
+
+    SECTION("Arcs are timed by their length") {
+      cut* c = circular_arc::make(point(1, 0, 0), point(-1, 0, 0), point(-1, 0, 0), COUNTERCLOCKWISE, XY);
+      c->set_feedrate(lit::make(6));
+
+      // 0.1 inches per second around half a unit circle, the ramps
+      // add the same time as on a line
+      REQUIRE(within_eps(travel_distance(c), M_PI, 1e-8));
+      REQUIRE(within_eps(execution_time_seconds({c}, haas),
+			 M_PI / 0.1 + 0.1 / haas.max_axis_acceleration.x,
+			 1e-6));
+    }
+
+    SECTION("Safe moves run at the rapid rate") {
+      vector<cut*> path{safe_move::make(point(0, 0, 1), point(100, 0, 1))};
+
+      double rapid = haas.max_axis_feed.x / 60.0;
+      REQUIRE(within_eps(execution_time_seconds(path, haas),
+			 100.0 / rapid + rapid / haas.max_axis_acceleration.x,
+			 1e-6));
+    }
+  }
+
+}
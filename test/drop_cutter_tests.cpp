@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "backend/drop_cutter.h"
+#include "backend/freeform_toolpaths.h"
+#include "system/parse_stl.h"
+
+namespace gca {
+
+  TEST_CASE("Drop cutter on a box") {
+    triangular_mesh m = make_mesh(box_triangles(box(0, 1, 0, 2, 0, 3)), 0.001);
+    drop_cutter cutter(m);
+
+    tool flat(0.5, 3.0, 4, HSS, FLAT_NOSE);
+    tool ball(0.5, 3.0, 4, HSS, BALL_NOSE);
+
+    SECTION("Both cutters rest on the top face over the box") {
+      REQUIRE(within_eps(cutter.drop(0.5, 1.0, flat, -1.0), 3.0, 0.0001));
+      REQUIRE(within_eps(cutter.drop(0.5, 1.0, ball, -1.0), 3.0, 0.0001));
+    }
+
+    SECTION("Flat cutter hangs over the edge at full height") {
+      REQUIRE(within_eps(cutter.drop(1.1, 1.0, flat, -1.0), 3.0, 0.0001));
+    }
+
+    SECTION("Ball cutter rolls off the edge") {
+      double expected = 3.0 + sqrt(0.25*0.25 - 0.1*0.1) - 0.25;
+      REQUIRE(within_eps(cutter.drop(1.1, 1.0, ball, -1.0), expected, 0.0001));
+    }
+
+    SECTION("Cutter clear of the box stays at z_min") {
+      REQUIRE(within_eps(cutter.drop(1.3, 1.0, flat, -1.0), -1.0, 0.0001));
+      REQUIRE(within_eps(cutter.drop(1.3, 1.0, ball, -1.0), -1.0, 0.0001));
+    }
+
+    SECTION("Batched drops match single drops") {
+      vector<point> pts{point(0.5, 1.0, 0), point(1.1, 1.0, 0), point(1.3, 1.0, 0)};
+      vector<point> dropped = cutter.drop(pts, ball, -1.0);
+
+      REQUIRE(dropped.size() == pts.size());
+      for (unsigned i = 0; i < pts.size(); i++) {
+	REQUIRE(dropped[i].z == cutter.drop(pts[i].x, pts[i].y, ball, -1.0));
+      }
+    }
+
+    SECTION("Surface lookup matches z_at") {
+      maybe<double> z = cutter.surface_z(0.3, 1.2);
+      maybe<double> expected = z_at(0.3, 1.2, m.face_indexes(), m);
+
+      REQUIRE(z.just);
+      REQUIRE(expected.just);
+      REQUIRE(within_eps(z.t, expected.t, 0.0001));
+      REQUIRE(!cutter.surface_z(5.0, 5.0).just);
+    }
+  }
+
+  TEST_CASE("Adaptive drops over a box") {
+    triangular_mesh m = make_mesh(box_triangles(box(0, 1, 0, 2, 0, 3)), 0.001);
+    drop_cutter cutter(m);
+    tool ball(0.5, 3.0, 4, HSS, BALL_NOSE);
+
+    // Across the box and off both sides, where the ball rolls over
+    // the edges
+    vector<point> samples;
+    for (int i = 0; i <= 200; i++) {
+      samples.push_back(point(-0.5 + 0.01*i, 1.0, 0));
+    }
+
+    double tolerance = 0.0005;
+    polyline adaptive =
+      adaptive_drop_polylines(-1.0, cutter, {polyline(samples)}, ball, 0.125, tolerance).front();
+    vector<point> uniform = cutter.drop(samples, ball, -1.0);
+
+    REQUIRE(adaptive.num_points() < uniform.size() / 3);
+
+    // Every uniform sample is close to the adaptive path over it
+    auto pts = vector<point>(begin(adaptive), end(adaptive));
+    for (auto& p : uniform) {
+      auto next = find_if(begin(pts), end(pts),
+			  [p](const point q) { return q.x >= p.x - 1e-8; });
+      REQUIRE(next != end(pts));
+
+      double z = next->z;
+      if (next != begin(pts) && next->x > p.x + 1e-8) {
+	point prev = *(next - 1);
+	z = prev.z + (p.x - prev.x)*(next->z - prev.z) / (next->x - prev.x);
+      }
+
+      REQUIRE(fabs(z - p.z) <= 2*tolerance);
+    }
+  }
+
+}
@@ -1,18 +1,78 @@
 #include <sstream>
 
 #include "analysis/extract_cuts.h"
+#include "analysis/gcode_to_cuts.h"
 #include "catch.hpp"
+#include "geometry/line.h"
 #include "checkers/bounds_checker.h"
 #include "checkers/forbidden_tool_checker.h"
 #include "checkers/unsafe_spindle_checker.h"
 #include "backend/shapes_to_gcode.h"
 #include "backend/shapes_to_toolpaths.h"
 #include "synthesis/dxf_reader.h"
+#include "synthesis/dxf_streaming.h"
 #include "backend/output.h"
 #include "system/settings.h"
 
 namespace gca {
 
+  // Moves of p at its deepest z, flattened onto the XY plane. A move
+  // that only starts or ends there, like a plunge, is kept as the
+  // point it reaches
+  static vector<line> full_depth_moves(const vector<block>& p) {
+    vector<vector<cut*>> paths;
+    REQUIRE(gcode_to_cuts(p, paths) == GCODE_TO_CUTS_SUCCESS);
+
+    double depth = 0.0;
+    for (auto& path : paths) {
+      for (auto c : path) {
+	if (!c->is_safe_move()) { depth = min(depth, c->get_end().z); }
+      }
+    }
+
+    vector<line> moves;
+    for (auto& path : paths) {
+      for (auto c : path) {
+	if (c->is_safe_move()) { continue; }
+
+	point s(c->get_start().x, c->get_start().y, 0);
+	point e(c->get_end().x, c->get_end().y, 0);
+	bool s_deep = within_eps(c->get_start().z, depth, 1e-6);
+	bool e_deep = within_eps(c->get_end().z, depth, 1e-6);
+
+	if (s_deep && e_deep) {
+	  moves.push_back(line(s, e));
+	} else if (s_deep || e_deep) {
+	  point reached = s_deep ? s : e;
+	  moves.push_back(line(reached, reached));
+	}
+      }
+    }
+    return moves;
+  }
+
+  // Whether every point of p, sampled step apart, is within tol of q
+  static bool covered_by(const vector<line>& p,
+			 const vector<line>& q,
+			 const double step,
+			 const double tol) {
+    for (auto& l : p) {
+      int n = static_cast<int>(ceil((l.end - l.start).len() / step));
+      for (int k = 0; k <= n; k++) {
+	point x = n == 0 ? l.start : l.value(static_cast<double>(k) / n);
+	bool near = false;
+	for (auto& m : q) {
+	  if (distance_to_segment(x, m.start, m.end) <= tol) {
+	    near = true;
+	    break;
+	  }
+	}
+	if (!near) { return false; }
+      }
+    }
+    return true;
+  }
+
   TEST_CASE("Read rectangle file") {
     arena_allocator a;
     set_system_allocator(&a);
@@ -83,9 +143,12 @@ namespace gca {
 
     vector<vector<machine_state>> sections;
 
-    SECTION("2 paths for splines") {
+    // The flattened spiral runs from end point to end point, so its
+    // second depth pass starts where the first one ended and needs no
+    // realignment. Each pass follows one drag knife alignment move
+    SECTION("2 paths for splines, each after an alignment move") {
       extract_cuts(p, sections);
-      REQUIRE(sections.size() == 6);      
+      REQUIRE(sections.size() == 4);
     }
 
     // SECTION("No standalone feedrate instructions, G53 moves, or toolchanges") {
@@ -287,4 +350,82 @@ namespace gca {
     }
   }
 
+  TEST_CASE("Streamed DXF files") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    cut_params params;
+    params.default_feedrate = 30;
+    params.set_default_feedrate = true;
+    params.material_depth = 0.09;
+    params.cut_depth = 0.05;
+    params.push_depth = 0.005;
+    params.safe_height = 0.35;
+    params.machine_z_zero = -4.05;
+    params.start_loc = point(0, 0, 0);
+    params.start_orient = point(1, 0, 0);
+    params.target_machine = CAMASTER;
+    params.tools = DRILL_AND_DRAG_KNIFE;
+
+    string file_name =
+      project_path + string("gca/test/dxf-files/12-inch-spiral.DXF");
+
+    SECTION("One batch is the same as the whole layout") {
+      shape_layout l = read_dxf(file_name.c_str());
+      string expected = shape_layout_to_gcode_string(l, params);
+
+      stringstream ss;
+      gcode_writer w(ss);
+      stream_dxf_to_gcode(file_name.c_str(), params, w);
+      w.flush();
+
+      REQUIRE(ss.str() + "\n" == expected);
+    }
+
+    SECTION("Small batches still cut every shape") {
+      file_name = project_path + string("gca/test/dxf-files/rect-2inx3in.DXF");
+
+      stringstream ss;
+      gcode_writer w(ss);
+      stream_dxf_to_gcode(file_name.c_str(), params, w, 2);
+      w.flush();
+
+      vector<block> p = lex_gprog(ss.str());
+      vector<vector<machine_state>> sections;
+      extract_cuts(p, sections);
+
+      shape_layout l = read_dxf(file_name.c_str());
+      vector<block> whole = shape_layout_to_gcode(l, params);
+
+      REQUIRE(sections.size() > 0);
+      REQUIRE(check_for_forbidden_tool_changes({}, p) ==
+	      check_for_forbidden_tool_changes({}, whole));
+    }
+
+    // The drag knife is offset along the direction of each cut, which
+    // depends on how lines are chained, so the shapes are compared
+    // with the drill
+    SECTION("Small batches cut the same shapes as the whole layout") {
+      params.tools = DRILL_ONLY;
+
+      for (auto name : {"rect-2inx3in.DXF", "12-inch-spiral.DXF"}) {
+	file_name = project_path + string("gca/test/dxf-files/") + name;
+
+	stringstream ss;
+	gcode_writer w(ss);
+	stream_dxf_to_gcode(file_name.c_str(), params, w, 2);
+	w.flush();
+
+	shape_layout l = read_dxf(file_name.c_str());
+	vector<block> whole = shape_layout_to_gcode(l, params);
+
+	vector<line> streamed_moves = full_depth_moves(lex_gprog(ss.str()));
+	vector<line> whole_moves = full_depth_moves(whole);
+
+	REQUIRE(covered_by(streamed_moves, whole_moves, 0.01, 1e-4));
+	REQUIRE(covered_by(whole_moves, streamed_moves, 0.01, 1e-4));
+      }
+    }
+  }
+
 }
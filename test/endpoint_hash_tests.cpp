@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "geometry/endpoint_hash.h"
+
+namespace gca {
+
+  TEST_CASE("Endpoint chaining") {
+
+    SECTION("Shuffled and reversed square sides close into one loop") {
+      vector<pair<point, point>> segments{
+	make_pair(point(1, 1, 0), point(1, 0, 0)),
+	make_pair(point(0, 0, 0), point(1, 0, 0)),
+	make_pair(point(0, 1, 0), point(0, 0, 0)),
+	make_pair(point(0, 1, 0), point(1, 1, 0) + point(1e-9, 0, 0))};
+
+      auto chains = chain_segments(segments, 1e-7, true);
+
+      REQUIRE(chains.size() == 1);
+      REQUIRE(chains.front().closed);
+      REQUIRE(chains.front().links.size() == 4);
+      REQUIRE(chains.front().links[0].index == 0);
+      REQUIRE(chains.front().links[1].reversed);
+    }
+
+    SECTION("Reversal only happens when it is allowed") {
+      vector<pair<point, point>> segments{
+	make_pair(point(0, 0, 0), point(1, 0, 0)),
+	make_pair(point(3, 0, 0), point(1, 0, 0)),
+	make_pair(point(1, 0, 0), point(2, 0, 0))};
+
+      auto forward = chain_segments(segments, 1e-7, false);
+
+      REQUIRE(forward.size() == 2);
+      REQUIRE(forward.front().links.size() == 2);
+      REQUIRE(forward.front().links[1].index == 2);
+      REQUIRE(forward.back().links.front().index == 1);
+
+      auto either = chain_segments(segments, 1e-7, true);
+
+      REQUIRE(either.size() == 2);
+      REQUIRE(either.front().links.size() == 2);
+      REQUIRE(either.front().links[1].index == 1);
+      REQUIRE(either.front().links[1].reversed);
+      REQUIRE(either.back().links.front().index == 2);
+    }
+
+    SECTION("Chains grow backward from their first segment") {
+      vector<pair<point, point>> segments;
+      unsigned n = 1000;
+      for (unsigned i = n; i > 0; i--) {
+	segments.push_back(make_pair(point(i - 1.0, 0, 0), point(i, 0, 0)));
+      }
+
+      auto chains = chain_segments(segments, 1e-7, false);
+
+      REQUIRE(chains.size() == 1);
+      REQUIRE(chains.front().links.size() == n);
+      REQUIRE(chains.front().links.front().index == n - 1);
+      REQUIRE(!chains.front().closed);
+    }
+  }
+
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <numeric>
+#include <random>
+
+#include "catch.hpp"
+#include "backend/hole_ordering.h"
+
+namespace gca {
+
+  static double travel_distance(const std::vector<point>& sites,
+				const std::vector<unsigned>& order) {
+    double d = 0.0;
+    for (unsigned i = 0; i + 1 < order.size(); i++) {
+      d += (sites[order[i + 1]] - sites[order[i]]).len();
+    }
+    return d;
+  }
+
+  TEST_CASE("Hole visit order") {
+    SECTION("Shuffled holes on a line are visited end to end") {
+      vector<point> sites;
+      for (int i = 0; i < 50; i++) {
+	sites.push_back(point((i*7) % 50, 1, 0));
+      }
+
+      vector<unsigned> order = hole_visit_order(sites);
+
+      REQUIRE(order.size() == sites.size());
+      REQUIRE(within_eps(travel_distance(sites, order), 49.0, 0.0001));
+    }
+
+    SECTION("Shuffled grid of holes is close to a serpentine") {
+      vector<point> sites;
+      for (int i = 0; i < 40; i++) {
+	for (int j = 0; j < 40; j++) {
+	  sites.push_back(point(0.5*i, 0.5*j, 0));
+	}
+      }
+      std::shuffle(begin(sites), end(sites), std::mt19937(3));
+
+      vector<unsigned> order = hole_visit_order(sites);
+
+      vector<unsigned> sorted_order = order;
+      sort(begin(sorted_order), end(sorted_order));
+      for (unsigned i = 0; i < sorted_order.size(); i++) {
+	REQUIRE(sorted_order[i] == i);
+      }
+
+      double serpentine = 0.5*(sites.size() - 1);
+      REQUIRE(travel_distance(sites, order) < 1.1*serpentine);
+    }
+
+    SECTION("10^5 random holes are ordered quickly") {
+      std::mt19937 gen(7);
+      std::uniform_real_distribution<double> coord(0.0, 100.0);
+
+      vector<point> sites;
+      for (int i = 0; i < 100000; i++) {
+	sites.push_back(point(coord(gen), coord(gen), 0));
+      }
+
+      vector<unsigned> input_order(sites.size());
+      std::iota(begin(input_order), end(input_order), 0);
+
+      auto start = std::chrono::steady_clock::now();
+      vector<unsigned> order = hole_visit_order(sites);
+      double seconds =
+	std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      REQUIRE(order.size() == sites.size());
+      REQUIRE(travel_distance(sites, order) < 0.05*travel_distance(sites, input_order));
+      REQUIRE(seconds < 10.0);
+    }
+  }
+
+}
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "catch.hpp"
+#include "utils/arena_allocator.h"
+#include "utils/instrumentation.h"
+#include "utils/parallel.h"
+
+namespace gca {
+
+  static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+  }
+
+  TEST_CASE("Phase timers and counters") {
+    // Relative, so the trace lands in the directory the tests run in
+    std::string path = "gca_instrumentation_test.json";
+    enable_instrumentation(path);
+
+    arena_allocator a(1 << 16);
+    thread_arena_scope arena(&a);
+
+    {
+      phase_timer outer("outer_phase");
+      allocate<double>();
+      count_event("outer_events", 2);
+
+      {
+	phase_timer inner("inner_phase");
+	count_event("inner_events");
+      }
+
+      parallel_for(8, [](const unsigned i) {
+	  phase_timer worker("worker_phase");
+	  count_event("worker_events");
+	});
+    }
+
+    write_instrumentation();
+    disable_instrumentation();
+
+    std::string trace = read_file(path);
+    std::remove(path.c_str());
+
+    // Counters are totalled over all phases
+    REQUIRE(trace.find("\"outer_events\": 2") != std::string::npos);
+    REQUIRE(trace.find("\"inner_events\": 1") != std::string::npos);
+    REQUIRE(trace.find("\"worker_events\": 8") != std::string::npos);
+
+    // Nested and worker phases are children of the outer phase
+    size_t outer = trace.find("\"name\": \"outer_phase\"");
+    REQUIRE(outer != std::string::npos);
+    REQUIRE(trace.find("\"name\": \"inner_phase\"", outer) != std::string::npos);
+    REQUIRE(trace.find("\"name\": \"worker_phase\", \"calls\": 8", outer) != std::string::npos);
+
+    // Arena bytes are charged to the phase that allocated them
+    REQUIRE(trace.find("\"arena_bytes\": " + std::to_string(sizeof(double))) != std::string::npos);
+
+    // Nothing is recorded once instrumentation is off
+    REQUIRE(!instrumentation_enabled());
+    {
+      phase_timer after("after_phase");
+      count_event("after_events");
+    }
+    REQUIRE(current_phase() == NULL);
+  }
+
+}
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "catch.hpp"
+#include "utils/log.h"
+
+namespace gca {
+
+  static int times_printed = 0;
+
+  struct counted_value {};
+
+  static std::ostream& operator<<(std::ostream& out, const counted_value) {
+    times_printed++;
+    return out << "counted";
+  }
+
+  TEST_CASE("Leveled logging") {
+    // Relative, so the log lands in the directory the tests run in
+    std::string path = "gca_log_test.txt";
+    set_log_file(path);
+    set_log_level(LEVEL_WARNING);
+    set_log_level(GEOMETRY_LOG, LEVEL_INFO);
+    times_printed = 0;
+
+    GCA_LOG_INFO(GEOMETRY_LOG, "geometry " << counted_value());
+    GCA_LOG_INFO(BACKEND_LOG, "backend " << counted_value());
+    GCA_LOG_WARNING(BACKEND_LOG, "warning " << 3);
+
+    flush_log();
+    set_log_file("");
+    set_log_level(LEVEL_WARNING);
+
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove(path.c_str());
+
+    // Messages below the level of their subsystem are never formatted
+    REQUIRE(times_printed == 1);
+    REQUIRE(contents.str() ==
+	    "[info geometry] geometry counted\n[warning backend] warning 3\n");
+  }
+
+}
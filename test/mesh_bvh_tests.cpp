@@ -0,0 +1,63 @@
+#include "catch.hpp"
+#include "geometry/mesh_bvh.h"
+#include "system/parse_stl.h"
+
+namespace gca {
+
+  TEST_CASE("BVH segment queries on a box") {
+    triangular_mesh m = make_mesh(box_triangles(box(0, 1, 0, 2, 0, 3)), 0.001);
+    mesh_bvh bvh(m);
+
+    REQUIRE(bvh.num_faces() == m.face_indexes().size());
+
+    line through(point(0.5, 1.0, 10), point(0.5, 1.0, -10));
+    line miss(point(5, 5, 10), point(5, 5, -10));
+
+    SECTION("Vertical segment through the box hits top and bottom") {
+      auto hits = bvh.all_hits(through);
+      REQUIRE(hits.size() == 2);
+      REQUIRE(bvh.any_hit(through));
+
+      auto first = bvh.first_hit(through);
+      REQUIRE(first);
+      REQUIRE(within_eps(m.face_triangle(*first).centroid().z, 3.0, 0.0001));
+    }
+
+    SECTION("Segment outside the box misses") {
+      REQUIRE(bvh.all_hits(miss).size() == 0);
+      REQUIRE(!bvh.any_hit(miss));
+      REQUIRE(!bvh.first_hit(miss));
+    }
+
+    SECTION("Batched queries match single queries") {
+      vector<line> ls{through, miss};
+      auto hits = bvh.all_hits(ls);
+      REQUIRE(hits.size() == 2);
+      REQUIRE(hits[0] == bvh.all_hits(through));
+      REQUIRE(hits[1].size() == 0);
+    }
+  }
+
+  TEST_CASE("BVH matches brute force intersection on a part") {
+    triangular_mesh m =
+      parse_stl("test/stl-files/onshape_parts/Part Studio 1 - Part 1(10).stl",
+		0.0001);
+    mesh_bvh bvh(m);
+
+    box bb = m.bounding_box();
+    vector<line> ls;
+    for (auto p : sample_points_2d(bb, bb.x_len() / 20.0, bb.y_len() / 20.0, 0.0)) {
+      ls.push_back(line(point(p.x, p.y, bb.z_max + 1), point(p.x, p.y, bb.z_min - 1)));
+    }
+
+    auto hits = bvh.all_hits(ls);
+    for (unsigned i = 0; i < ls.size(); i++) {
+      vector<index_t> brute;
+      for (auto f : m.face_indexes()) {
+	if (intersects(m.face_triangle(f), ls[i])) { brute.push_back(f); }
+      }
+      REQUIRE(hits[i] == brute);
+    }
+  }
+
+}
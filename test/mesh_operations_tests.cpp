@@ -0,0 +1,53 @@
+#include "catch.hpp"
+#include "geometry/extrusion.h"
+#include "geometry/mesh_operations.h"
+#include "utils/arena_allocator.h"
+
+namespace gca {
+
+  TEST_CASE("Boolean difference of meshes") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    auto box_mesh = [](const double x, const double x_len) {
+      std::vector<point> pts{point(x, 0, 0),
+	  point(x, 1, 0),
+	  point(x + x_len, 1, 0),
+	  point(x + x_len, 0, 0)};
+      return extrude(build_clean_polygon_3(pts), point(0, 0, 1));
+    };
+
+    triangular_mesh near_box = box_mesh(0, 1);
+    triangular_mesh far_box = box_mesh(5, 1);
+
+    // Overlaps half of near_box, misses far_box, and a box that
+    // misses both
+    std::vector<triangular_mesh> subtrahends{box_mesh(0.5, 1), box_mesh(10, 1)};
+
+    SECTION("One mesh") {
+      auto res = boolean_difference(near_box, subtrahends);
+
+      REQUIRE(res.size() == 1);
+      REQUIRE(within_eps(volume(res.front()), 0.5, 0.001));
+    }
+
+    SECTION("Several meshes are each cut only by what overlaps them") {
+      auto res = boolean_difference({near_box, far_box}, subtrahends);
+
+      REQUIRE(res.size() == 2);
+
+      double total_volume = 0.0;
+      for (auto& m : res) { total_volume += volume(m); }
+      REQUIRE(within_eps(total_volume, 1.5, 0.001));
+    }
+
+    SECTION("Subtrahends on both sides are both removed") {
+      std::vector<triangular_mesh> two_sides{box_mesh(-0.5, 0.75), box_mesh(0.75, 1)};
+      auto res = boolean_difference(near_box, two_sides);
+
+      REQUIRE(res.size() == 1);
+      REQUIRE(within_eps(volume(res.front()), 0.5, 0.001));
+    }
+  }
+
+}
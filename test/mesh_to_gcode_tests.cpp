@@ -1,8 +1,11 @@
+#include <sstream>
+
 #include "analysis/gcode_to_cuts.h"
 #include "catch.hpp"
 #include "geometry/triangular_mesh.h"
 #include "synthesis/fixture_analysis.h"
 #include "synthesis/mesh_to_gcode.h"
+#include "backend/gcode_generation.h"
 #include "backend/toolpath_generation.h"
 #include "synthesis/visual_debug.h"
 #include "utils/arena_allocator.h"
@@ -935,5 +938,36 @@ namespace gca {
     REQUIRE(fab_plan.steps().size() == 3);
 
   }
+
+  static std::vector<std::string> step_programs(const fabrication_plan& p) {
+    std::vector<std::string> programs;
+    for (auto& step : p.steps()) {
+      std::ostringstream out;
+      gcode_writer w(out);
+      write_gcode_program(step.toolpaths(), emco_f1_post(), w);
+      w.flush();
+      programs.push_back(out.str());
+    }
+    return programs;
+  }
+
+  TEST_CASE("Parallel toolpath generation gives the same fabrication plan") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    workpiece workpiece_dims(1.75, 1.75, 2.5, ALUMINUM);
+    fabrication_inputs inputs = current_fab_inputs(workpiece_dims);
+
+    auto mesh = parse_stl("test/stl-files/OctagonWithHolesShort.stl", 0.001);
+
+    fabrication_plan serial = make_fabrication_plan(mesh, inputs);
+
+    set_parallel_toolpath_generation(true);
+    fabrication_plan parallel = make_fabrication_plan(mesh, inputs);
+    set_parallel_toolpath_generation(false);
+
+    REQUIRE(serial.steps().size() > 0);
+    REQUIRE(step_programs(serial) == step_programs(parallel));
+  }
   
 }
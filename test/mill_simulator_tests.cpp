@@ -247,7 +247,7 @@ namespace gca {
       REQUIRE(op_ranges.size() == 2);
 
       vector<operation_params> prog_ops =
-	program_operations_GCA(paths, tt, op_ranges);
+	program_operations_GCA(paths, tt, op_ranges, emco_f1_profile());
 
       REQUIRE(prog_ops.size() == 2);
 
@@ -262,6 +262,45 @@ namespace gca {
 
 
   
+  TEST_CASE("Voxel mill simulator") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    voxel_volume v = voxelize(box_triangles(box(0, 5, 0, 5, 0, 4)),
+			      box(0, 5, 0, 5, 0, 5),
+			      0.01);
+    double tool_diameter = 0.5;
+    double tool_radius = tool_diameter / 2.0;
+
+    SECTION("Flat plunge") {
+      cylindrical_bit t(tool_diameter);
+      vector<cut*> cuts{linear_cut::make(point(2, 2, 5), point(2, 2, 1))};
+      double actual = simulate_mill(cuts, v, t);
+      double correct = M_PI*tool_radius*tool_radius*(4.0 - 1.0);
+      REQUIRE(within_eps(actual, correct, 0.01));
+      REQUIRE(within_eps(v.volume(), 5*5*4 - correct, 0.01));
+    }
+
+    SECTION("Slot at constant depth") {
+      cylindrical_bit t(tool_diameter);
+      vector<cut*> cuts{linear_cut::make(point(1, 2, 3), point(4, 2, 3))};
+      double actual = simulate_mill(cuts, v, t);
+      double correct = (3*tool_diameter + M_PI*tool_radius*tool_radius)*1.0;
+      REQUIRE(within_eps(actual, correct, 0.02));
+    }
+
+    SECTION("Ball plunge") {
+      ball_nosed t(tool_diameter);
+      vector<cut*> cuts{linear_cut::make(point(2, 2, 5), point(2, 2, 1))};
+      double actual = simulate_mill(cuts, v, t);
+      double correct =
+	M_PI*tool_radius*tool_radius*(4.0 - 1.0 - tool_radius) +
+	(2.0 / 3.0)*M_PI*tool_radius*tool_radius*tool_radius;
+      REQUIRE(within_eps(actual, correct, 0.01));
+    }
+
+  }
+
   // TEST_CASE("Vertical safe move does not remove material") {
   //   arena_allocator a;
   //   set_system_allocator(&a);
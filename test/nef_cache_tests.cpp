@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "geometry/extrusion.h"
+#include "geometry/nef_cache.h"
+#include "utils/arena_allocator.h"
+
+namespace gca {
+
+  TEST_CASE("Nef conversion cache") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    auto box_mesh = [](const double x) {
+      std::vector<point> pts{point(x, 0, 0),
+	  point(x, 1, 0),
+	  point(x + 2, 1, 0),
+	  point(x + 2, 0, 0)};
+      return extrude(build_clean_polygon_3(pts), point(0, 0, 1));
+    };
+
+    triangular_mesh m = box_mesh(0);
+
+    clear_nef_cache();
+
+    SECTION("Converting the same mesh twice hits the cache") {
+      Nef_polyhedron first = cached_trimesh_to_nef_polyhedron(m);
+      Nef_polyhedron second = cached_trimesh_to_nef_polyhedron(m);
+
+      REQUIRE(nef_cache_statistics().mesh_to_nef_misses == 1);
+      REQUIRE(nef_cache_statistics().mesh_to_nef_hits == 1);
+      REQUIRE(first.identical(second));
+    }
+
+    SECTION("A different mesh misses") {
+      cached_trimesh_to_nef_polyhedron(m);
+      cached_trimesh_to_nef_polyhedron(box_mesh(3));
+
+      REQUIRE(nef_cache_statistics().mesh_to_nef_misses == 2);
+      REQUIRE(nef_cache_statistics().mesh_to_nef_hits == 0);
+    }
+
+    SECTION("Cached conversion matches the uncached one") {
+      Nef_polyhedron cached = cached_trimesh_to_nef_polyhedron(m);
+      Nef_polyhedron uncached = trimesh_to_nef_polyhedron(m);
+
+      REQUIRE((cached - uncached).is_empty());
+      REQUIRE((uncached - cached).is_empty());
+    }
+
+    SECTION("Volumes are computed once and match the mesh") {
+      Nef_polyhedron nef = cached_trimesh_to_nef_polyhedron(m);
+
+      double first = cached_nef_volume(nef);
+      double second = cached_nef_volume(nef);
+
+      REQUIRE(nef_cache_statistics().volume_misses == 1);
+      REQUIRE(nef_cache_statistics().volume_hits == 1);
+      REQUIRE(first == second);
+      REQUIRE(within_eps(first, volume(m), 0.001));
+      REQUIRE(within_eps(first, 2.0, 0.001));
+    }
+
+    SECTION("Clearing resets the statistics") {
+      cached_trimesh_to_nef_polyhedron(m);
+      clear_nef_cache();
+
+      REQUIRE(nef_cache_statistics().mesh_to_nef_misses == 0);
+
+      cached_trimesh_to_nef_polyhedron(m);
+      REQUIRE(nef_cache_statistics().mesh_to_nef_misses == 1);
+    }
+  }
+
+}
@@ -1,4 +1,5 @@
 #include "catch.hpp"
+#include "geometry/offset.h"
 #include "geometry/polygon.h"
 #include "geometry/triangle.h"
 #include "utils/algorithm.h"
@@ -61,4 +62,27 @@ namespace gca {
       REQUIRE(results.size() == 1);
     }
   }
+
+  TEST_CASE("Offset rings from one skeleton") {
+    vector<point> square{point(0, 0, 0), point(1, 0, 0),
+	point(1, 1, 0), point(0, 1, 0)};
+    vector<polygon_3> islands{build_clean_polygon_3(square)};
+
+    exterior_offset_rings rings(islands, 1.0);
+
+    for (double d : {0.1, 0.25, 0.5, 1.0}) {
+      vector<polygon_3> from_skeleton = rings.at(d);
+      vector<polygon_3> direct = exterior_offset(islands, d);
+
+      REQUIRE(from_skeleton.size() == 1);
+      REQUIRE(direct.size() == 1);
+      REQUIRE(within_eps(area(from_skeleton.front()),
+			 area(direct.front()),
+			 0.0001));
+      REQUIRE(within_eps(area(from_skeleton.front()),
+			 (1 + 2*d)*(1 + 2*d),
+			 0.0001));
+    }
+  }
+
 }
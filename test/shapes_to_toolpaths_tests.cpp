@@ -113,6 +113,20 @@ namespace gca {
 	    REQUIRE(all_of(cuts.begin(), cuts.end(), is_vertical_or_horizontal));
 	  }
 	}
+
+	SECTION("Reversed lines chain into one closed polyline") {
+	  lines.push_back(linear_cut::make(p1, p0));
+	  lines.push_back(linear_cut::make(p2, p3));
+	  lines.push_back(linear_cut::make(p1, p2));
+	  lines.push_back(linear_cut::make(p0, p3));
+
+	  shape_layout l(lines, holes, splines);
+	  vector<polyline> ps = polylines_for_shapes(l);
+
+	  REQUIRE(ps.size() == 1);
+	  REQUIRE(ps.front().num_points() == 5);
+	  REQUIRE(within_eps(ps.front().front(), ps.front().back()));
+	}
       }
     }
 
@@ -1,6 +1,7 @@
 #include "utils/arena_allocator.h"
 #include "catch.hpp"
 #include "geometry/b_spline.h"
+#include "geometry/spline_sampling.h"
 
 namespace gca {
 
@@ -46,4 +47,64 @@ namespace gca {
     
   }
 
+  TEST_CASE("Cubic spline evaluation") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    vector<point> control_points{point(0, 0, 0), point(1, 2, 0), point(2, -1, 0),
+	point(3, 3, 0), point(4, 0, 1), point(5, 1, 0)};
+    vector<double> knots{0, 0, 0, 0, 0.3, 0.5, 1, 1, 1, 1};
+    b_spline s(3, control_points, knots);
+
+    SECTION("de Boor matches the basis function sum") {
+      for (int k = 0; k < 100; k++) {
+	double v = k / 100.0;
+	point expected(0, 0, 0);
+	for (unsigned i = 0; i < control_points.size(); i++) {
+	  expected = expected + s.basis(i, 3, v)*control_points[i];
+	}
+	REQUIRE(within_eps(s.eval(v), expected, 1e-10));
+      }
+    }
+
+    SECTION("Clamped ends hit the end control points") {
+      REQUIRE(within_eps(s.eval(s.start_param()), control_points.front()));
+      REQUIRE(within_eps(s.eval(s.end_param()), control_points.back()));
+    }
+
+    SECTION("Derivative matches finite differences") {
+      double h = 1e-6;
+      for (double v : {0.1, 0.3, 0.45, 0.8}) {
+	point fd = (1.0 / (2*h))*(s.eval(v + h) - s.eval(v - h));
+	REQUIRE(within_eps(s.derivative(v), fd, 1e-4));
+      }
+    }
+
+    SECTION("Flattening stays within tolerance") {
+      double tol = 0.001;
+      vector<point> pts = flatten_spline(&s, tol);
+
+      REQUIRE(within_eps(pts.front(), control_points.front()));
+      REQUIRE(within_eps(pts.back(), control_points.back()));
+
+      for (int k = 0; k <= 10000; k++) {
+	point p = s.eval(k / 10000.0);
+	double closest = (p - pts.front()).len();
+	for (unsigned i = 0; i + 1 < pts.size(); i++) {
+	  point d = pts[i + 1] - pts[i];
+	  double t = max(0.0, min(1.0, (p - pts[i]).dot(d) / d.dot(d)));
+	  closest = min(closest, (p - (pts[i] + t*d)).len());
+	}
+	REQUIRE(closest <= tol);
+      }
+    }
+
+    SECTION("Straight splines flatten to their end points") {
+      vector<point> line_points{point(0, 0, 0), point(1, 1, 0), point(2, 2, 0), point(3, 3, 0)};
+      b_spline l(3, line_points, {0, 0, 0, 0, 1, 1, 1, 1});
+
+      REQUIRE(flatten_spline(&l, 0.001).size() == 2);
+    }
+  }
+
 }
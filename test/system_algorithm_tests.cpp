@@ -1,7 +1,10 @@
+#include <numeric>
 #include <vector>
 
 #include "catch.hpp"
 #include "utils/algorithm.h"
+#include "utils/arena_allocator.h"
+#include "utils/parallel.h"
 
 using namespace std;
 
@@ -103,4 +106,69 @@ namespace gca {
       REQUIRE(v == correct);
     }
   }
+
+  TEST_CASE("Parallel map") {
+    vector<int> v(1000);
+    std::iota(begin(v), end(v), 0);
+
+    SECTION("Map preserves order") {
+      vector<int> sq = parallel_map(v, [](const int i) { return i*i; });
+      REQUIRE(sq.size() == v.size());
+      REQUIRE(sq[0] == 0);
+      REQUIRE(sq[999] == 999*999);
+    }
+
+    SECTION("Nested maps run on the worker of the outer map") {
+      vector<int> outer(num_worker_threads() + 1);
+      vector<bool> same_thread =
+	parallel_map(outer, [&v](const int) {
+	    std::thread::id worker = std::this_thread::get_id();
+	    vector<std::thread::id> inner =
+	      parallel_map(v, [](const int) { return std::this_thread::get_id(); });
+	    return std::all_of(begin(inner), end(inner), [worker](const std::thread::id id) {
+		return id == worker;
+	      });
+	  });
+
+      REQUIRE(std::all_of(begin(same_thread), end(same_thread), [](const bool b) { return b; }));
+    }
+
+    SECTION("Repeated maps with arenas reuse the arenas of earlier workers") {
+      // Room for the first block of every worker's arena and no more
+      arena_allocator a((num_worker_threads() + 1) << 20);
+      thread_arena_scope scope(&a);
+
+      vector<int*> last;
+      for (int i = 0; i < 100; i++) {
+	last = parallel_map_with_arenas(v, [](const int j) {
+	    int* p = allocate<int>();
+	    *p = j;
+	    return p;
+	  });
+      }
+
+      REQUIRE(*(last[0]) == 0);
+      REQUIRE(*(last[999]) == 999);
+    }
+  }
+
+  TEST_CASE("Small arenas grow as they fill") {
+    arena_allocator a(64);
+    thread_arena_scope scope(&a);
+
+    vector<int*> ints;
+    for (int i = 0; i < 100000; i++) {
+      int* p = allocate<int>();
+      *p = i;
+      ints.push_back(p);
+    }
+
+    bool all_kept = true;
+    for (int i = 0; i < 100000; i++) {
+      all_kept = all_kept && *(ints[i]) == i;
+    }
+
+    REQUIRE(all_kept);
+  }
+
 }
@@ -87,9 +87,48 @@ namespace gca {
     }
 
     REQUIRE(tool_info[base].size() == 3);
+
+    SECTION("Repeated access checks reuse cached offsets") {
+      tool_access_info cached_info = find_accessable_tools(f, tools);
+      REQUIRE(cached_info[base].size() == 3);
+
+      clear_tool_access_cache();
+
+      tool_access_info fresh_info = find_accessable_tools(f, tools);
+      REQUIRE(fresh_info[base].size() == 3);
+    }
     
   }
 
+  TEST_CASE("Tools of equal radius share interior offsets") {
+    clear_tool_access_cache();
+
+    polygon_3 base =
+      build_clean_polygon_3({point(0, 0, 0), point(3, 0, 0), point(3, 2, 0), point(0, 2, 0)});
+    feature f(true, false, 0.5, base);
+
+    tool t1(0.5, 3.0, 4, HSS, FLAT_NOSE);
+    tool t2(0.5, 2.0, 2, CARBIDE, FLAT_NOSE);
+
+    tool_access_regions(f, t1, 1.0, 0.5);
+    vector<polygon_3> cached = tool_access_regions(f, t2, 1.5, 0.5);
+
+    tool_access_cache_stats stats = tool_access_cache_statistics();
+    REQUIRE(stats.interior_misses == 1);
+    REQUIRE(stats.interior_hits == 1);
+    REQUIRE(stats.region_misses == 2);
+
+    clear_tool_access_cache();
+    vector<polygon_3> fresh = tool_access_regions(f, t2, 1.5, 0.5);
+
+    REQUIRE(tool_access_cache_statistics().interior_hits == 0);
+    REQUIRE(cached.size() == fresh.size());
+    for (unsigned i = 0; i < cached.size(); i++) {
+      REQUIRE(cached[i].vertices() == fresh[i].vertices());
+      REQUIRE(cached[i].holes() == fresh[i].holes());
+    }
+  }
+
   std::vector<tool> nested_thru_hole_tools() {
     tool t1(0.30, 3.0, 2, HSS, FLAT_NOSE);
     t1.set_cut_diameter(0.3);
@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include "catch.hpp"
 
 #include "backend/face_toolpaths.h"
@@ -299,6 +301,34 @@ namespace gca {
     REQUIRE(compress_lines(p, 0.001).num_points() == 2);
   }
 
+  TEST_CASE("Zig lines clipped around a hole") {
+    vector<point> outer_pts{point(0, 0, 0), point(10, 0, 0),
+	point(10, 10, 0), point(0, 10, 0)};
+    vector<point> hole_pts{point(2, 2, 0), point(8, 2, 0),
+	point(8, 8, 0), point(2, 8, 0)};
+
+    polygon_3 bound = build_clean_polygon_3(outer_pts);
+    polygon_3 hole = build_clean_polygon_3(hole_pts);
+
+    tool t(0.5, 3.0, 4, HSS, FLAT_NOSE);
+
+    vector<point> across{point(-1, 5, 0), point(11, 5, 0)};
+    vector<polyline> clipped = clip_lines({polyline(across)}, bound, {hole}, t);
+
+    REQUIRE(clipped.size() == 2);
+    REQUIRE(within_eps(clipped[0].front(), point(0, 5, 0), 0.0001));
+    REQUIRE(within_eps(clipped[0].back(), point(2, 5, 0), 0.0001));
+    REQUIRE(within_eps(clipped[1].front(), point(8, 5, 0), 0.0001));
+    REQUIRE(within_eps(clipped[1].back(), point(10, 5, 0), 0.0001));
+
+    vector<point> below_hole{point(-1, 1, 0), point(11, 1, 0)};
+    clipped = clip_lines({polyline(below_hole)}, bound, {hole}, t);
+
+    REQUIRE(clipped.size() == 1);
+    REQUIRE(within_eps(clipped[0].front(), point(0, 1, 0), 0.0001));
+    REQUIRE(within_eps(clipped[0].back(), point(10, 1, 0), 0.0001));
+  }
+
   TEST_CASE("Contour with hole") {
     arena_allocator a;
     set_system_allocator(&a);
@@ -452,6 +482,30 @@ namespace gca {
       }
     }
 
+    SECTION("Parallel generation matches serial generation") {
+      std::vector<toolpath> serial = machine_flat_region(r, 1.0, {t, huge_tool});
+
+      set_parallel_toolpath_generation(true);
+      std::vector<toolpath> parallel = machine_flat_region(r, 1.0, {t, huge_tool});
+      set_parallel_toolpath_generation(false);
+
+      REQUIRE(serial.size() == parallel.size());
+      for (unsigned i = 0; i < serial.size(); i++) {
+	REQUIRE(serial[i].tool_number() == parallel[i].tool_number());
+
+	auto serial_lines = serial[i].lines();
+	auto parallel_lines = parallel[i].lines();
+
+	REQUIRE(serial_lines.size() == parallel_lines.size());
+	for (unsigned j = 0; j < serial_lines.size(); j++) {
+	  REQUIRE(serial_lines[j].num_points() == parallel_lines[j].num_points());
+	  for (unsigned k = 0; k < serial_lines[j].num_points(); k++) {
+	    REQUIRE(serial_lines[j].pt(k) == parallel_lines[j].pt(k));
+	  }
+	}
+      }
+    }
+
     SECTION("No use of tiny tool") {
       std::vector<toolpath> toolpaths = machine_flat_region(r, 1.0, {t, tiny_tool});
 
@@ -554,6 +608,118 @@ namespace gca {
       REQUIRE(all_cuts_below_power);
 
     }
+
+    SECTION("Split cuts never run faster than the planned feed by default") {
+      std::vector<toolpath> toolpaths = machine_flat_region(r, 1.0, {t, huge_tool});
+
+      feed_optimization_params params(0.737, 0.3);
+      optimize_feedrates_by_MRR_simulation(r, toolpaths, params);
+
+      for (auto& tp : toolpaths) {
+	for (auto cuts : tp.cuts_without_safe_moves()) {
+	  for (auto c : cuts) {
+	    double feed = static_cast<lit*>(c->get_feedrate())->v;
+
+	    REQUIRE(feed <= tp.feedrate + 1e-8);
+
+	    // Longer moves only come from merging pieces left at the
+	    // planned feed
+	    if (c->length() > params.max_segment_length + 1e-8) {
+	      REQUIRE(within_eps(feed, tp.feedrate, 1e-6));
+	    }
+	  }
+	}
+      }
+    }
+
+    SECTION("Streamed G-code matches printed blocks") {
+      std::vector<toolpath> toolpaths = machine_flat_region(r, 1.0, {t, huge_tool});
+
+      auto prog = build_gcode_program("Surface cut", toolpaths, emco_f1_code);
+
+      std::ostringstream printed;
+      printed.setf(ios::fixed, ios::floatfield);
+      printed.setf(ios::showpoint);
+      printed << prog.blocks;
+
+      std::ostringstream streamed;
+      {
+	gcode_writer w(streamed, 256);
+	write_gcode_program(toolpaths, emco_f1_post(), w);
+      }
+
+      REQUIRE(printed.str() == streamed.str());
+    }
+
+    SECTION("Streamed CAMASTER G-code matches printed blocks") {
+      std::vector<toolpath> toolpaths = machine_flat_region(r, 1.0, {t, huge_tool});
+
+      auto prog = build_gcode_program("Engraving",
+				      toolpaths,
+				      camaster_prefix_blocks,
+				      camaster_suffix_blocks,
+				      camaster_engraving);
+
+      std::ostringstream printed;
+      printed.setf(ios::fixed, ios::floatfield);
+      printed.setf(ios::showpoint);
+      printed << prog.blocks;
+
+      std::ostringstream streamed;
+      {
+	gcode_writer w(streamed, 256);
+	write_camaster_program(toolpaths, w);
+      }
+
+      REQUIRE(printed.str() == streamed.str());
+    }
+  }
+
+  TEST_CASE("Light cuts run faster than planned") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    tool t{0.25, 3.0, 2, HSS, FLAT_NOSE};
+
+    // Stock top at z = 0.5 over a 2 x 2 inch square
+    class region sim_region(point(0, 0, 0), 2.0, 2.0, 1.0, 0.01);
+    for (int i = 0; i < sim_region.r.num_x_elems; i++) {
+      for (int j = 0; j < sim_region.r.num_y_elems; j++) {
+	sim_region.r.set_column_height(i, j, 0.5);
+      }
+    }
+
+    // One pass just below the stock top, one through air above it
+    vector<polyline> lines{polyline({point(0.5, 0.5, 0.49), point(1.5, 0.5, 0.49)}),
+	polyline({point(0.5, 1.5, 0.8), point(1.5, 1.5, 0.8)})};
+    toolpath tp(FACE_POCKET, 1.0, 3000, 20.0, 5.0, t, lines);
+
+    SECTION("Up to the feed scale without a machine") {
+      feed_optimization_params params(0.737, 0.3);
+      params.max_feed_scale = 2.0;
+      toolpath fast = optimize_feedrates_by_MRR_simulation(sim_region, tp, params);
+
+      for (auto& cuts : fast.cuts_without_safe_moves()) {
+	for (auto c : cuts) {
+	  double feed = static_cast<lit*>(c->get_feedrate())->v;
+	  REQUIRE(within_eps(feed, params.max_feed_scale*tp.feedrate, 1e-6));
+	}
+      }
+    }
+
+    SECTION("Never past the axis limits of the machine") {
+      feed_optimization_params params(0.737, 0.3, emco_f1_profile());
+      params.max_feed_scale = 2.0;
+      toolpath fast = optimize_feedrates_by_MRR_simulation(sim_region, tp, params);
+
+      for (auto& cuts : fast.cuts_without_safe_moves()) {
+	for (auto c : cuts) {
+	  double feed = static_cast<lit*>(c->get_feedrate())->v;
+	  REQUIRE(feed > tp.feedrate);
+	  REQUIRE(within_eps(feed, emco_f1_profile().max_axis_feed.x, 1e-6));
+	}
+      }
+    }
   }
 
 }
@@ -0,0 +1,48 @@
+#include "catch.hpp"
+#include "backend/toolpath_linking.h"
+
+namespace gca {
+
+  TEST_CASE("Parallel passes are ordered and linked into a zig-zag") {
+    vector<polyline> passes;
+    for (int i = 0; i < 4; i++) {
+      vector<point> pts{point(0, i, 0), point(10, i, 0)};
+      passes.push_back(polyline(pts));
+    }
+    swap(passes[1], passes[3]);
+
+    vector<polyline> ordered = order_lines(passes);
+
+    REQUIRE(ordered.size() == 4);
+    for (unsigned i = 0; i < ordered.size(); i++) {
+      REQUIRE(within_eps(ordered[i].front().y, i, 0.0001));
+    }
+    REQUIRE(within_eps(ordered[1].front(), point(10, 1, 0), 0.0001));
+    REQUIRE(within_eps(ordered[2].front(), point(0, 2, 0), 0.0001));
+
+    vector<point> outer{point(0, -1, 0), point(10, -1, 0),
+	point(10, 4, 0), point(0, 4, 0)};
+    polygon_3 bound = build_clean_polygon_3(outer);
+
+    SECTION("Passes inside the bound become one line") {
+      vector<polyline> linked = link_lines(ordered, bound, {}, 2.0);
+      REQUIRE(linked.size() == 1);
+      REQUIRE(linked.front().num_points() == 8);
+    }
+
+    SECTION("Links that cross a hole are left as rapids") {
+      vector<point> hole_pts{point(9, 2.2, 0), point(11, 2.2, 0),
+	  point(11, 2.8, 0), point(9, 2.8, 0)};
+      polygon_3 hole = build_clean_polygon_3(hole_pts);
+
+      vector<polyline> linked = link_lines(ordered, bound, {hole}, 2.0);
+      REQUIRE(linked.size() == 2);
+    }
+
+    SECTION("Links longer than the limit are left as rapids") {
+      vector<polyline> linked = link_lines(ordered, bound, {}, 0.5);
+      REQUIRE(linked.size() == 4);
+    }
+  }
+
+}
@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "gcode/lexer.h"
+#include "gcode/linear_cut.h"
 #include "transformers/feed_changer.h"
+#include "transformers/retarget.h"
 
 namespace gca {
 
@@ -29,4 +31,55 @@ namespace gca {
       REQUIRE(change_feeds(p, initial_feedrate, new_feedrate) == correct);
     }
   }
+
+  static vector<cut*> compensated_path(const double feed) {
+    vector<cut*> path;
+    for (int i = 0; i < 3; i++) {
+      cut* c = linear_cut::make(point(i, 0, 0), point(i + 1, 0, 0));
+      c->settings.active_tool = ilit::make(2);
+      c->settings.spindle_speed = lit::make(1000);
+      c->settings.feedrate = lit::make(feed);
+      c->settings.tool_height_comp = TOOL_HEIGHT_COMP_NEGATIVE;
+      path.push_back(c);
+    }
+    return path;
+  }
+
+  TEST_CASE("Transform pipelines") {
+    arena_allocator a;
+    set_system_allocator(&a);
+
+    tool_table tools;
+    tools[2] = tool_info(1.5, 0.25);
+
+    vector<vector<cut*>> paths{compensated_path(10), compensated_path(20)};
+
+    transform_pipeline p;
+    p.then(retarget_stage(tools, tools))
+      .then(change_feeds(lit::make(10), lit::make(15)));
+
+    SECTION("Applying copies leaves the input alone") {
+      auto res = p.apply(paths);
+
+      REQUIRE(res.size() == 2);
+      REQUIRE(res[0][0] != paths[0][0]);
+      REQUIRE(within_eps(paths[0][0]->get_start(), point(0, 0, 0)));
+      REQUIRE(paths[0][0]->settings.tool_height_comp == TOOL_HEIGHT_COMP_NEGATIVE);
+
+      REQUIRE(within_eps(res[0][0]->get_start(), point(0, 0, 1.5)));
+      REQUIRE(res[0][0]->settings.tool_height_comp == TOOL_HEIGHT_COMP_OFF);
+      REQUIRE(*res[0][2]->get_feedrate() == *lit::make(15));
+      REQUIRE(*res[1][2]->get_feedrate() == *lit::make(20));
+    }
+
+    SECTION("Applying in place keeps the same cuts") {
+      cut* first = paths[1][0];
+      p.apply_in_place(paths);
+
+      REQUIRE(paths[1][0] == first);
+      REQUIRE(within_eps(first->get_end(), point(1, 0, 1.5)));
+      REQUIRE(first->settings.tool_height_comp == TOOL_HEIGHT_COMP_OFF);
+    }
+  }
+
 }
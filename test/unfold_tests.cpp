@@ -47,5 +47,12 @@ namespace gca {
       correct.push_back(b5);
       REQUIRE(res == correct);
     }
+
+    SECTION("Nested and repeated subroutine calls") {
+      p = lex_gprog("M97 P1 \n M97 P1 \n M30 \n N1 \n G0 X1.0 \n M97 P2 \n M99 \n N2 \n G0 Y2.0 \n M99");
+      res = unfold_gprog(p);
+      correct = lex_gprog("N1 \n G0 X1.0 \n N2 \n G0 Y2.0 \n N1 \n G0 X1.0 \n N2 \n G0 Y2.0 \n M30");
+      REQUIRE(res == correct);
+    }
   }
 }
@@ -216,6 +216,40 @@ namespace gca {
 
     REQUIRE(vol.is_occupied(0, 0, 0));
 
+  }
+
+  TEST_CASE("Clearing a voxel empties it") {
+    voxel_volume vol(point(0, 0, 0), 1.0, 1.0, 10.0, 0.1);
+
+    vol.set_occupied(3, 4, 70);
+    vol.set_empty(3, 4, 70);
+
+    REQUIRE(vol.is_empty(3, 4, 70));
+  }
+
+  TEST_CASE("Voxelizing a box") {
+    box b(0, 1, 0, 2, 0, 3);
+    box bounds(-0.5, 1.5, -0.5, 2.5, -0.5, 3.5);
+
+    voxel_volume vol = voxelize(box_triangles(b), bounds, 0.05);
+
+    REQUIRE(within_eps(vol.volume(), 6.0, 0.001));
+    REQUIRE(within_eps(vol.surface_area(), 22.0, 0.001));
+
+    SECTION("Clearing the top half of the box") {
+      voxel_volume top = vol;
+      for (int i = 0; i < top.num_x_elems(); i++) {
+	for (int j = 0; j < top.num_y_elems(); j++) {
+	  top.clear_column_above(i, j, 1.5);
+	}
+      }
+
+      REQUIRE(within_eps(top.volume(), 3.0, 0.001));
+      REQUIRE(within_eps(boolean_difference(vol, top).volume(), 3.0, 0.001));
+      REQUIRE(within_eps(boolean_intersection(vol, top).volume(), 3.0, 0.001));
+      REQUIRE(within_eps(boolean_union(vol, top).volume(), 6.0, 0.001));
+    }
+
   }
 
     vector<string> voxel_test_parts{